@@ -668,6 +668,9 @@ static void update_logging1(void)
 
     if (should_log(MASK_LOG_NTUN))
         Log_Write_Nav_Tuning();
+
+    if (should_log(MASK_LOG_IMU))
+        DataFlash.Log_Write_Vibration(ins);
 }
 
 /*
@@ -743,7 +746,7 @@ static void one_second_loop(void)
 
 static void update_GPS_50Hz(void)
 {        
-    static uint32_t last_gps_reading[GPS_MAX_INSTANCES];
+    static uint32_t last_gps_reading[GPS_NUM_STATES];
 	gps.update();
 
     for (uint8_t i=0; i<gps.num_sensors(); i++) {
@@ -754,6 +757,17 @@ static void update_GPS_50Hz(void)
             }
         }
     }
+
+#if GPS_MAX_INSTANCES > 1
+    // log the blended solution when it is in use
+    if (gps.primary_sensor() == GPS_BLENDED_INSTANCE &&
+        gps.last_message_time_ms(GPS_BLENDED_INSTANCE) != last_gps_reading[GPS_BLENDED_INSTANCE]) {
+        last_gps_reading[GPS_BLENDED_INSTANCE] = gps.last_message_time_ms(GPS_BLENDED_INSTANCE);
+        if (should_log(MASK_LOG_GPS)) {
+            DataFlash.Log_Write_GPS(gps, GPS_BLENDED_INSTANCE, current_loc.alt);
+        }
+    }
+#endif
 }
 
 
@@ -272,6 +272,7 @@ bool GCS_MAVLINK::try_send_message(enum ap_message id)
     case MSG_OPTICAL_FLOW:
     case MSG_GIMBAL_REPORT:
     case MSG_EKF_STATUS_REPORT:
+    case MSG_VIBRATION:
         break; // just here to prevent a warning
     }
     return true;
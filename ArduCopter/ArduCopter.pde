@@ -462,12 +462,10 @@ static MOTOR_CLASS motors(g.rc_1, g.rc_2, g.rc_3, g.rc_4, MAIN_LOOP_RATE);
 ////////////////////////////////////////////////////////////////////////////////
 // GPS variables
 ////////////////////////////////////////////////////////////////////////////////
-// We use atan2 and other trig techniques to calaculate angles
-// We need to scale the longitude up to make these calcs work
-// to account for decreasing distance between lines of longitude away from the equator
-static float scaleLongUp = 1;
-// Sometimes we need to remove the scaling for distance calcs
-static float scaleLongDown = 1;
+// projection of locations into position vectors about the EKF origin,
+// which accounts for the decreasing distance between lines of
+// longitude away from the equator
+static LocalTangentPlane pv_ltp;
 
 ////////////////////////////////////////////////////////////////////////////////
 // Location & Navigation
@@ -816,6 +814,7 @@ static const AP_Scheduler::Task scheduler_tasks[] PROGMEM = {
     { full_rate_logging_loop,1,     22 },
     { perf_update,        4000,     20 },
     { read_receiver_rssi,   40,      5 },
+    { compass_learn_update, 40,     30 },
 #if FRSKY_TELEM_ENABLED == ENABLED
     { frsky_telemetry_send, 80,     10 },
 #endif
@@ -1057,6 +1056,9 @@ static void ten_hz_logging_loop()
     if (should_log(MASK_LOG_RCIN)) {
         DataFlash.Log_Write_RCIN();
     }
+    if (should_log(MASK_LOG_IMU) || should_log(MASK_LOG_IMU_FAST)) {
+        DataFlash.Log_Write_Vibration(ins);
+    }
     if (should_log(MASK_LOG_NTUN) && (mode_requires_GPS(control_mode) || landing_with_GPS())) {
         Log_Write_Nav_Tuning();
     }
@@ -1186,7 +1188,7 @@ static void one_hz_loop()
 // called at 50hz
 static void update_GPS(void)
 {
-    static uint32_t last_gps_reading[GPS_MAX_INSTANCES];   // time of last gps message
+    static uint32_t last_gps_reading[GPS_NUM_STATES];   // time of last gps message
     bool gps_updated = false;
 
     gps.update();
@@ -1205,6 +1207,17 @@ static void update_GPS(void)
         }
     }
 
+#if GPS_MAX_INSTANCES > 1
+    // log the blended solution when it is in use
+    if (gps.primary_sensor() == GPS_BLENDED_INSTANCE &&
+        gps.last_message_time_ms(GPS_BLENDED_INSTANCE) != last_gps_reading[GPS_BLENDED_INSTANCE]) {
+        last_gps_reading[GPS_BLENDED_INSTANCE] = gps.last_message_time_ms(GPS_BLENDED_INSTANCE);
+        if (should_log(MASK_LOG_GPS)) {
+            DataFlash.Log_Write_GPS(gps, GPS_BLENDED_INSTANCE, current_loc.alt);
+        }
+    }
+#endif
+
     if (gps_updated) {
         // set system time if necessary
         set_system_time_from_GPS();
@@ -680,6 +680,11 @@ bool GCS_MAVLINK::try_send_message(enum ap_message id)
     case MSG_ARMMASK:
         mavlink_msg_named_value_int_send(chan, millis(), "ARMMASK", get_ready_to_arm_mode_mask());
         break;
+
+    case MSG_VIBRATION:
+        CHECK_PAYLOAD_SIZE(VIBRATION);
+        gcs[chan-MAVLINK_COMM_0].send_vibration(ins);
+        break;
     }
 
     return true;
@@ -910,6 +915,7 @@ GCS_MAVLINK::data_stream_send(void)
         send_message(MSG_MAG_CAL_PROGRESS);
         send_message(MSG_EKF_STATUS_REPORT);
         send_message(MSG_GPS_ACCURACY);
+        send_message(MSG_VIBRATION);
     }
 }
 
@@ -32,6 +32,32 @@ static void compass_cal_update() {
     }
 }
 
+// compass_learn_update - learn compass offsets and motor interference
+// in flight from the field expected by the EKF. should be called at 10hz
+static void compass_learn_update()
+{
+#if AP_AHRS_NAVEKF_AVAILABLE
+    if (!g.compass_enabled || !compass.learn_inflight_enabled()) {
+        return;
+    }
+
+    // only learn while flying on a healthy EKF that is using the compass
+    const NavEKF &ekf = ahrs.get_NavEKF_const();
+    if (!motors.armed() || ap.land_complete || !ahrs.have_inertial_nav() ||
+        !ekf.healthy() || !ekf.use_compass()) {
+        compass.learn_inflight_reset();
+        return;
+    }
+
+    Vector3f mag_ned, mag_bias;
+    Matrix3f body_to_ned;
+    ekf.getMagNED(mag_ned);
+    ekf.getMagXYZ(mag_bias);
+    ekf.getRotationBodyToNED(body_to_ned);
+    compass.learn_inflight(body_to_ned.mul_transpose(mag_ned), mag_bias);
+#endif
+}
+
 static void accel_cal_update() {
     accelcal.update();
     if( accelcal.get_status() == ACCEL_CAL_WAITING_FOR_ORIENTATION || accelcal.get_status() == ACCEL_CAL_COLLECTING_SAMPLE ) {
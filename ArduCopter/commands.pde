@@ -86,9 +86,6 @@ static bool set_home(const Location& loc)
         if (g.compass_enabled) {
             compass.set_initial_location(gps.location().lat, gps.location().lng);
         }
-        // update navigation scalers.  used to offset the shrinking longitude as we go towards the poles
-        scaleLongDown = longitude_scale(loc);
-        scaleLongUp   = 1.0f/scaleLongDown;
         // record home is set
         set_home_state(HOME_SET_NOT_LOCKED);
 
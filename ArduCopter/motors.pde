@@ -747,6 +747,12 @@ static void init_disarm_motors()
 
     motors.armed(false);
 
+    // save compass offsets and motor interference learned in flight
+    if (compass.learn_inflight_enabled()) {
+        compass.save_offsets();
+        compass.save_motor_compensation();
+    }
+
     // save compass offsets learned by the EKF
     Vector3f magOffsets;
     if (ahrs.use_compass() && ahrs.getMagOffsets(magOffsets)) {
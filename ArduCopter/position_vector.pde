@@ -10,9 +10,10 @@
 // pv_location_to_vector - convert lat/lon coordinates to a position vector
 Vector3f pv_location_to_vector(const Location& loc)
 {
-    const struct Location &origin = inertial_nav.get_origin();
+    pv_ltp.set_origin(inertial_nav.get_origin());
     float alt_above_origin = pv_alt_above_origin(loc.alt);  // convert alt-relative-to-home to alt-relative-to-origin
-    return Vector3f((loc.lat-origin.lat) * LATLON_TO_CM, (loc.lng-origin.lng) * LATLON_TO_CM * scaleLongDown, alt_above_origin);
+    Vector2f ne = pv_ltp.location_to_ne(loc);
+    return Vector3f(ne.x * 100.0f, ne.y * 100.0f, alt_above_origin);
 }
 
 // pv_location_to_vector_with_default - convert lat/lon coordinates to a position vector,
@@ -969,6 +969,9 @@ static void update_logging1(void)
 
     if (should_log(MASK_LOG_ATTITUDE_MED) && !should_log(MASK_LOG_IMU))
         Log_Write_IMU();
+
+    if (should_log(MASK_LOG_IMU))
+        Log_Write_Vibration();
 }
 
 /*
@@ -1120,7 +1123,7 @@ static void airspeed_ratio_update(void)
  */
 static void update_GPS_50Hz(void)
 {
-    static uint32_t last_gps_reading[GPS_MAX_INSTANCES];
+    static uint32_t last_gps_reading[GPS_NUM_STATES];
     gps.update();
 
     for (uint8_t i=0; i<gps.num_sensors(); i++) {
@@ -1131,6 +1134,17 @@ static void update_GPS_50Hz(void)
             }
         }
     }
+
+#if GPS_MAX_INSTANCES > 1
+    // log the blended solution when it is in use
+    if (gps.primary_sensor() == GPS_BLENDED_INSTANCE &&
+        gps.last_message_time_ms(GPS_BLENDED_INSTANCE) != last_gps_reading[GPS_BLENDED_INSTANCE]) {
+        last_gps_reading[GPS_BLENDED_INSTANCE] = gps.last_message_time_ms(GPS_BLENDED_INSTANCE);
+        if (should_log(MASK_LOG_GPS)) {
+            Log_Write_GPS(GPS_BLENDED_INSTANCE);
+        }
+    }
+#endif
 }
 
 /*
@@ -440,6 +440,11 @@ static void Log_Write_IMU()
     DataFlash.Log_Write_IMU(ins);
 }
 
+static void Log_Write_Vibration()
+{
+    DataFlash.Log_Write_Vibration(ins);
+}
+
 static void Log_Write_RC(void)
 {
     DataFlash.Log_Write_RCIN();
@@ -527,6 +532,7 @@ static void Log_Write_Attitude() {}
 static void Log_Write_Control_Tuning() {}
 static void Log_Write_GPS(uint8_t instance) {}
 static void Log_Write_IMU() {}
+static void Log_Write_Vibration() {}
 static void Log_Write_RC() {}
 static void Log_Write_Airspeed(void) {}
 static void Log_Write_Baro(void) {}
@@ -0,0 +1,160 @@
+#include <AP_HAL.h>
+#include <AP_Common.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "Benchmark.h"
+
+Benchmark::Benchmark() :
+    _num_stages(0),
+    _num_counters(0)
+{
+    memset(_stages, 0, sizeof(_stages));
+    for (uint8_t i=0; i<BENCHMARK_MAX_COUNTERS; i++) {
+        _counter_fd[i] = -1;
+        _counter_name[i] = NULL;
+    }
+}
+
+#if defined(__linux__)
+/*
+  open a user space hardware counter for this thread, in the group
+  led by group_fd
+ */
+static int perf_counter_open(uint64_t config, int group_fd)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = (group_fd == -1);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+#endif
+
+bool Benchmark::init(void)
+{
+#if defined(__linux__)
+    static const struct {
+        uint64_t config;
+        const char *name;
+    } counters[BENCHMARK_MAX_COUNTERS] = {
+        { PERF_COUNT_HW_CPU_CYCLES,   "cycles" },
+        { PERF_COUNT_HW_INSTRUCTIONS, "instr" },
+        { PERF_COUNT_HW_CACHE_MISSES, "cache-miss" },
+    };
+    for (uint8_t i=0; i<BENCHMARK_MAX_COUNTERS; i++) {
+        int fd = perf_counter_open(counters[i].config, _num_counters == 0 ? -1 : _counter_fd[0]);
+        if (fd == -1) {
+            // not supported by this CPU or not permitted, see
+            // /proc/sys/kernel/perf_event_paranoid
+            continue;
+        }
+        _counter_fd[_num_counters] = fd;
+        _counter_name[_num_counters] = counters[i].name;
+        _num_counters++;
+    }
+    if (_num_counters > 0) {
+        ioctl(_counter_fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(_counter_fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+    return _num_counters > 0;
+}
+
+uint8_t Benchmark::add_stage(const char *name)
+{
+    if (_num_stages >= BENCHMARK_MAX_STAGES) {
+        return BENCHMARK_MAX_STAGES - 1;
+    }
+    _stages[_num_stages].name = name;
+    return _num_stages++;
+}
+
+uint64_t Benchmark::now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+  read all counters of the group in one system call
+ */
+bool Benchmark::read_counters(uint64_t values[BENCHMARK_MAX_COUNTERS]) const
+{
+    if (_num_counters == 0) {
+        return false;
+    }
+    uint64_t buf[1 + BENCHMARK_MAX_COUNTERS];
+    ssize_t len = ::read(_counter_fd[0], buf, sizeof(uint64_t) * (1 + _num_counters));
+    if (len != (ssize_t)(sizeof(uint64_t) * (1 + _num_counters)) || buf[0] != _num_counters) {
+        return false;
+    }
+    memcpy(values, &buf[1], sizeof(uint64_t) * _num_counters);
+    return true;
+}
+
+// the counters are read outside the timed interval, and exclude the
+// kernel so the read itself is not counted
+void Benchmark::start(uint8_t stage)
+{
+    struct stage_data &s = _stages[stage];
+    read_counters(s.counter_start);
+    s.start_ns = now_ns();
+}
+
+void Benchmark::stop(uint8_t stage)
+{
+    struct stage_data &s = _stages[stage];
+    uint64_t dt = now_ns() - s.start_ns;
+    uint64_t values[BENCHMARK_MAX_COUNTERS];
+    if (read_counters(values)) {
+        for (uint8_t i=0; i<_num_counters; i++) {
+            s.counter_total[i] += values[i] - s.counter_start[i];
+        }
+    }
+    s.calls++;
+    s.total_ns += dt;
+    if (dt > s.max_ns) {
+        s.max_ns = dt;
+    }
+}
+
+void Benchmark::report(FILE *f) const
+{
+    fprintf(f, "%-20s %8s %10s %10s", "stage", "calls", "ns/call", "max ns");
+    for (uint8_t i=0; i<_num_counters; i++) {
+        fprintf(f, " %10s", _counter_name[i]);
+    }
+    fprintf(f, "\n");
+    for (uint8_t i=0; i<_num_stages; i++) {
+        const struct stage_data &s = _stages[i];
+        if (s.calls == 0) {
+            fprintf(f, "%-20s %8u\n", s.name, 0U);
+            continue;
+        }
+        fprintf(f, "%-20s %8u %10.0f %10llu", s.name, (unsigned)s.calls,
+                s.total_ns / (double)s.calls, (unsigned long long)s.max_ns);
+        for (uint8_t c=0; c<_num_counters; c++) {
+            fprintf(f, " %10.1f", s.counter_total[c] / (double)s.calls);
+        }
+        fprintf(f, "\n");
+    }
+    if (_num_counters == 0) {
+        fprintf(f, "hardware counters not available\n");
+    }
+}
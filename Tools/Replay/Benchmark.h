@@ -0,0 +1,49 @@
+/*
+  per-stage timing of the code Replay drives, in nanoseconds of real
+  time, with CPU cycle, instruction and cache miss counts from the
+  Linux perf_event interface when the kernel allows it.
+
+  The scheduler clock in Replay follows the log, so the times here come
+  from CLOCK_MONOTONIC instead of hal.scheduler->micros()
+ */
+
+#define BENCHMARK_MAX_STAGES    8
+#define BENCHMARK_MAX_COUNTERS  3
+
+class Benchmark
+{
+public:
+    Benchmark();
+
+    // open the hardware counters, returning false if none are available
+    bool init(void);
+
+    // add a named stage, returning its number for start() and stop()
+    uint8_t add_stage(const char *name);
+
+    void start(uint8_t stage);
+    void stop(uint8_t stage);
+
+    // print the totals per call of each stage
+    void report(FILE *f) const;
+
+private:
+    bool read_counters(uint64_t values[BENCHMARK_MAX_COUNTERS]) const;
+    static uint64_t now_ns(void);
+
+    struct stage_data {
+        const char *name;
+        uint32_t calls;
+        uint64_t total_ns;
+        uint64_t max_ns;
+        uint64_t start_ns;
+        uint64_t counter_total[BENCHMARK_MAX_COUNTERS];
+        uint64_t counter_start[BENCHMARK_MAX_COUNTERS];
+    } _stages[BENCHMARK_MAX_STAGES];
+    uint8_t _num_stages;
+
+    // counter group, the first being the leader
+    int _counter_fd[BENCHMARK_MAX_COUNTERS];
+    const char *_counter_name[BENCHMARK_MAX_COUNTERS];
+    uint8_t _num_counters;
+};
@@ -51,6 +51,11 @@
 #include <AP_SerialManager.h>
 #include <RC_Channel.h>
 #include <AP_RangeFinder.h>
+#include <AP_Curve.h>
+#include <AP_Motors.h>
+#include <AC_PID.h>
+#include <AC_P.h>
+#include <AC_AttitudeControl.h>
 #include <stdio.h>
 #include <getopt.h>
 #include <errno.h>
@@ -63,6 +68,7 @@
 #endif
 
 #include "LogReader.h"
+#include "Benchmark.h"
 
 const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
 
@@ -83,6 +89,27 @@ static DataFlash_File dataflash("logs");
 SITL sitl;
 #endif
 
+/*
+  the copter fast loop for -b. The AHRS runs its own EKF, so
+  UpdateFilter() is timed on a second instance fed the same sensors
+ */
+static NavEKF bench_ekf(&ahrs, barometer, rng);
+static RC_Channel rc1(0), rc2(1), rc3(2), rc4(3);
+static AP_MotorsQuad motors(rc1, rc2, rc3, rc4, 400);
+static AP_Vehicle::MultiCopter copter_aparm;
+static AC_P p_stabilize_roll(4.5f), p_stabilize_pitch(4.5f), p_stabilize_yaw(4.5f);
+static AC_PID pid_rate_roll(0.15f, 0.1f, 0.004f, 2000, 20, 0.0025f);
+static AC_PID pid_rate_pitch(0.15f, 0.1f, 0.004f, 2000, 20, 0.0025f);
+static AC_PID pid_rate_yaw(0.2f, 0.02f, 0, 1000, 5, 0.0025f);
+static AC_AttitudeControl attitude_control(ahrs, copter_aparm, motors,
+                                           p_stabilize_roll, p_stabilize_pitch, p_stabilize_yaw,
+                                           pid_rate_roll, pid_rate_pitch, pid_rate_yaw);
+static Benchmark benchmark;
+static bool benchmarking;
+static bool bench_ekf_running;
+static uint8_t bench_read_AHRS, bench_UpdateFilter, bench_read_inertia;
+static uint8_t bench_update_flight_mode, bench_rate_controller_run, bench_motors_output;
+
 static const NavEKF &NavEKF = ahrs.get_NavEKF();
 
 static LogReader LogReader(ahrs, ins, barometer, compass, gps, airspeed, dataflash);
@@ -124,6 +151,7 @@ static void usage(void)
     ::printf(" -aMASK     set accel mask (1=accel1 only, 2=accel2 only, 3=both)\n");
     ::printf(" -gMASK     set gyro mask (1=gyro1 only, 2=gyro2 only, 3=both)\n");
     ::printf(" -A time    arm at time milliseconds)\n");
+    ::printf(" -b         benchmark the copter fast loop\n");
 }
 
 void setup()
@@ -137,7 +165,7 @@ void setup()
 
     hal.util->commandline_arguments(argc, argv);
 
-	while ((opt = getopt(argc, argv, "r:p:ha:g:A:")) != -1) {
+	while ((opt = getopt(argc, argv, "r:p:ha:g:A:b")) != -1) {
 		switch (opt) {
         case 'h':
             usage();
@@ -159,6 +187,10 @@ void setup()
             arm_time_ms = strtoul(optarg, NULL, 0);
             break;
 
+        case 'b':
+            benchmarking = true;
+            break;
+
         case 'p':
             char *eq = strchr(optarg, '=');
             if (eq == NULL) {
@@ -281,6 +313,92 @@ void setup()
         ::printf("Failed to start NavEKF\n");
         exit(1);
     }
+
+    if (benchmarking) {
+        setup_benchmark();
+    }
+}
+
+/*
+  setup the copter fast loop stages timed by -b
+ */
+static void setup_benchmark(void)
+{
+    if (!benchmark.init()) {
+        ::printf("Hardware counters not available, timing only\n");
+    }
+    bench_read_AHRS = benchmark.add_stage("read_AHRS incl. EKF");
+    bench_UpdateFilter = benchmark.add_stage("NavEKF::UpdateFilter");
+    bench_read_inertia = benchmark.add_stage("read_inertia");
+    bench_update_flight_mode = benchmark.add_stage("update_flight_mode");
+    bench_rate_controller_run = benchmark.add_stage("rate_controller_run");
+    bench_motors_output = benchmark.add_stage("motors_output");
+
+    bench_ekf_running = bench_ekf.InitialiseFilterDynamic();
+
+    copter_aparm.angle_max.set(4500);
+    attitude_control.set_dt(1.0f / update_rate);
+
+    motors.set_update_rate(490);
+    motors.set_frame_orientation(AP_MOTORS_X_FRAME);
+    motors.set_min_throttle(130);
+    motors.set_hover_throttle(500);
+    motors.Init();
+    if (rc3.radio_min == 0) {
+        rc3.radio_min = 1000;
+    }
+    if (rc3.radio_max == 0) {
+        rc3.radio_max = 2000;
+    }
+    rc1.set_angle(4500);
+    rc2.set_angle(4500);
+    rc3.set_range(130, 1000);
+    rc4.set_angle(4500);
+    motors.enable();
+    motors.armed(true);
+}
+
+/*
+  one pass of the copter fast loop, with stabilize holding the logged
+  attitude at hover throttle
+ */
+static void run_benchmark(void)
+{
+    // ahrs.update() runs the AHRS's own EKF as well as DCM
+    benchmark.start(bench_read_AHRS);
+    ahrs.update();
+    benchmark.stop(bench_read_AHRS);
+
+    if (!bench_ekf_running) {
+        // the filter will not start until it has good sensor data, so
+        // keep trying. UpdateFilter() is only timed once it runs
+        bench_ekf_running = bench_ekf.InitialiseFilterDynamic();
+    }
+    if (bench_ekf_running) {
+        benchmark.start(bench_UpdateFilter);
+        bench_ekf.UpdateFilter();
+        benchmark.stop(bench_UpdateFilter);
+    }
+
+    if (ahrs.get_home().lat != 0) {
+        benchmark.start(bench_read_inertia);
+        inertial_nav.update(ins.get_delta_time());
+        benchmark.stop(bench_read_inertia);
+    }
+
+    const Vector3f &attitude = LogReader.get_attitude();
+    benchmark.start(bench_update_flight_mode);
+    attitude_control.angle_ef_roll_pitch_rate_ef_yaw(attitude.x*100, attitude.y*100, 0);
+    attitude_control.set_throttle_out(500, true, 0);
+    benchmark.stop(bench_update_flight_mode);
+
+    benchmark.start(bench_rate_controller_run);
+    attitude_control.rate_controller_run();
+    benchmark.stop(bench_rate_controller_run);
+
+    benchmark.start(bench_motors_output);
+    motors.output(false, false);
+    benchmark.stop(bench_motors_output);
 }
 
 
@@ -344,9 +462,13 @@ static void read_sensors(uint8_t type)
         }
         last_imu_usec = LogReader.last_timestamp_us();
         for (uint8_t i=0; i<update_count; i++) {
-            ahrs.update();
-            if (ahrs.get_home().lat != 0) {
-                inertial_nav.update(ins.get_delta_time());
+            if (benchmarking) {
+                run_benchmark();
+            } else {
+                ahrs.update();
+                if (ahrs.get_home().lat != 0) {
+                    inertial_nav.update(ins.get_delta_time());
+                }
             }
             hal.scheduler->stop_clock(hal.scheduler->micros() + update_delta_usec);
             dataflash.Log_Write_EKF(ahrs,false);
@@ -375,6 +497,12 @@ void loop()
 
         if (!LogReader.update(type)) {
             ::printf("End of log at %.1f seconds\n", hal.scheduler->millis()*0.001f);
+            if (benchmarking) {
+                benchmark.report(stdout);
+                if (!bench_ekf_running) {
+                    ::printf("NavEKF::UpdateFilter not timed: the filter never initialised\n");
+                }
+            }
             fclose(plotf);
             exit(0);
         }
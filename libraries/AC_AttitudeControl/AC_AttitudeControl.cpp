@@ -90,6 +90,13 @@ const AP_Param::GroupInfo AC_AttitudeControl::var_info[] PROGMEM = {
     // @User: Advanced
     AP_GROUPINFO("LEAD_PIT_R", 11, AC_AttitudeControl, _pitch_lead_r, 1),
 
+    // @Param: QUAT_ERR
+    // @DisplayName: Quaternion attitude error
+    // @Description: Controls whether the body-frame angle error and rate feed forward are calculated from the vehicle and target attitudes as quaternions, which is exact for large errors, or from the earth-frame euler angle errors and rates at the current attitude
+    // @Values: 0:Euler, 1:Quaternion
+    // @User: Advanced
+    AP_GROUPINFO("QUAT_ERR", 12, AC_AttitudeControl, _quat_error_enabled, AC_ATTITUDE_CONTROL_QUAT_ERROR_DEFAULT),
+
 
     AP_GROUPEND
 };
@@ -156,7 +163,7 @@ void AC_AttitudeControl::angle_ef_roll_pitch_rate_ef_yaw_smooth(float roll_angle
     } else {
         // target roll and pitch to desired input roll and pitch
         _angle_ef_target.x = roll_angle_ef;
-        angle_ef_error.x = wrap_180_cd_float(_angle_ef_target.x - _ahrs.roll_sensor);
+        angle_ef_error.x = fast_wrap_180_cd(_angle_ef_target.x - _ahrs.roll_sensor);
 
         // set roll and pitch feed forward to zero
         _rate_ef_desired.x = 0;
@@ -179,7 +186,7 @@ void AC_AttitudeControl::angle_ef_roll_pitch_rate_ef_yaw_smooth(float roll_angle
     } else {
         // target roll and pitch to desired input roll and pitch
         _angle_ef_target.y = pitch_angle_ef;
-        angle_ef_error.y = wrap_180_cd_float(_angle_ef_target.y - _ahrs.pitch_sensor);
+        angle_ef_error.y = fast_wrap_180_cd(_angle_ef_target.y - _ahrs.pitch_sensor);
 
         // set roll and pitch feed forward to zero
         _rate_ef_desired.y = 0;
@@ -204,7 +211,7 @@ void AC_AttitudeControl::angle_ef_roll_pitch_rate_ef_yaw_smooth(float roll_angle
     }
 
     // convert earth-frame angle errors to body-frame angle errors
-    frame_conversion_ef_to_bf(angle_ef_error, _angle_bf_error);
+    update_angle_bf_error(_angle_ef_target, angle_ef_error);
 
 
     // convert body-frame angle errors to body-frame rate targets
@@ -213,11 +220,11 @@ void AC_AttitudeControl::angle_ef_roll_pitch_rate_ef_yaw_smooth(float roll_angle
     // add body frame rate feed forward
     if (_rate_bf_ff_enabled) {
         // convert earth-frame feed forward rates to body-frame feed forward rates
-        frame_conversion_ef_to_bf(_rate_ef_desired, _rate_bf_desired);
+        update_rate_bf_feedforward(_rate_ef_desired);
         _rate_bf_target += _rate_bf_desired;
     } else {
         // convert earth-frame feed forward rates to body-frame feed forward rates
-        frame_conversion_ef_to_bf(Vector3f(0,0,_rate_ef_desired.z), _rate_bf_desired);
+        update_rate_bf_feedforward(Vector3f(0,0,_rate_ef_desired.z));
         _rate_bf_target += _rate_bf_desired;
     }
 
@@ -235,10 +242,10 @@ void AC_AttitudeControl::angle_ef_roll_pitch_rate_ef_yaw(float roll_angle_ef, fl
 
     // set earth-frame angle targets for roll and pitch and calculate angle error
     _angle_ef_target.x = constrain_float(roll_angle_ef, -_aparm.angle_max, _aparm.angle_max);
-    angle_ef_error.x = wrap_180_cd_float(_angle_ef_target.x - _ahrs.roll_sensor);
+    angle_ef_error.x = fast_wrap_180_cd(_angle_ef_target.x - _ahrs.roll_sensor);
 
     _angle_ef_target.y = constrain_float(pitch_angle_ef, -_aparm.angle_max, _aparm.angle_max);
-    angle_ef_error.y = wrap_180_cd_float(_angle_ef_target.y - _ahrs.pitch_sensor);
+    angle_ef_error.y = fast_wrap_180_cd(_angle_ef_target.y - _ahrs.pitch_sensor);
 
     if (_accel_yaw_max > 0.0f) {
         // set earth-frame feed forward rate for yaw
@@ -257,7 +264,7 @@ void AC_AttitudeControl::angle_ef_roll_pitch_rate_ef_yaw(float roll_angle_ef, fl
     }
 
     // convert earth-frame angle errors to body-frame angle errors
-    frame_conversion_ef_to_bf(angle_ef_error, _angle_bf_error);
+    update_angle_bf_error(_angle_ef_target, angle_ef_error);
 
     // convert body-frame angle errors to body-frame rate targets
     update_rate_bf_targets();
@@ -266,7 +273,7 @@ void AC_AttitudeControl::angle_ef_roll_pitch_rate_ef_yaw(float roll_angle_ef, fl
     _rate_ef_desired.x = 0;
     _rate_ef_desired.y = 0;
     // convert earth-frame feed forward rates to body-frame feed forward rates
-    frame_conversion_ef_to_bf(_rate_ef_desired, _rate_bf_desired);
+    update_rate_bf_feedforward(_rate_ef_desired);
     _rate_bf_target += _rate_bf_desired;
 
     // body-frame to motor outputs should be called separately
@@ -284,17 +291,19 @@ void AC_AttitudeControl::angle_ef_roll_pitch_yaw(float roll_angle_ef, float pitc
     _angle_ef_target.z = yaw_angle_ef;
 
     // calculate earth frame errors
-    angle_ef_error.x = wrap_180_cd_float(_angle_ef_target.x - _ahrs.roll_sensor);
-    angle_ef_error.y = wrap_180_cd_float(_angle_ef_target.y - _ahrs.pitch_sensor);
-    angle_ef_error.z = wrap_180_cd_float(_angle_ef_target.z - _ahrs.yaw_sensor);
+    angle_ef_error.x = fast_wrap_180_cd(_angle_ef_target.x - _ahrs.roll_sensor);
+    angle_ef_error.y = fast_wrap_180_cd(_angle_ef_target.y - _ahrs.pitch_sensor);
+    angle_ef_error.z = fast_wrap_180_cd(_angle_ef_target.z - _ahrs.yaw_sensor);
 
-    // constrain the yaw angle error
-    if (slew_yaw) {
+    // constrain the yaw angle error, and aim at the yaw it leads to
+    Vector3f angle_ef_target = _angle_ef_target;
+    if (slew_yaw && fabsf(angle_ef_error.z) > _slew_yaw) {
         angle_ef_error.z = constrain_float(angle_ef_error.z,-_slew_yaw,_slew_yaw);
+        angle_ef_target.z = _ahrs.yaw_sensor + angle_ef_error.z;
     }
 
     // convert earth-frame angle errors to body-frame angle errors
-    frame_conversion_ef_to_bf(angle_ef_error, _angle_bf_error);
+    update_angle_bf_error(angle_ef_target, angle_ef_error);
 
     // convert body-frame angle errors to body-frame rate targets
     update_rate_bf_targets();
@@ -351,13 +360,13 @@ void AC_AttitudeControl::rate_ef_roll_pitch_yaw(float roll_rate_ef, float pitch_
     _angle_ef_target.y = constrain_float(_angle_ef_target.y, -_aparm.angle_max, _aparm.angle_max);
 
     // convert earth-frame angle errors to body-frame angle errors
-    frame_conversion_ef_to_bf(angle_ef_error, _angle_bf_error);
+    update_angle_bf_error(_angle_ef_target, angle_ef_error);
 
     // convert body-frame angle errors to body-frame rate targets
     update_rate_bf_targets();
 
     // convert earth-frame rates to body-frame rates
-    frame_conversion_ef_to_bf(_rate_ef_desired, _rate_bf_desired);
+    update_rate_bf_feedforward(_rate_ef_desired);
 
     // add body frame rate feed forward
     _rate_bf_target += _rate_bf_desired;
@@ -416,23 +425,23 @@ void AC_AttitudeControl::rate_bf_roll_pitch_yaw(float roll_rate_bf, float pitch_
         update_ef_yaw_angle_and_error(_rate_ef_desired.z, angle_ef_error, AC_ATTITUDE_RATE_STAB_ACRO_OVERSHOOT_ANGLE_MAX);
 
         // convert earth-frame angle errors to body-frame angle errors
-        frame_conversion_ef_to_bf(angle_ef_error, _angle_bf_error);
+        update_angle_bf_error(_angle_ef_target, angle_ef_error);
     } else {
         _acro_angle_switch = 4500;
         integrate_bf_rate_error_to_angle_errors();
         if (frame_conversion_bf_to_ef(_angle_bf_error, angle_ef_error)) {
-            _angle_ef_target.x = wrap_180_cd_float(angle_ef_error.x + _ahrs.roll_sensor);
-            _angle_ef_target.y = wrap_180_cd_float(angle_ef_error.y + _ahrs.pitch_sensor);
+            _angle_ef_target.x = fast_wrap_180_cd(angle_ef_error.x + _ahrs.roll_sensor);
+            _angle_ef_target.y = fast_wrap_180_cd(angle_ef_error.y + _ahrs.pitch_sensor);
             _angle_ef_target.z = wrap_360_cd_float(angle_ef_error.z + _ahrs.yaw_sensor);
         }
         if (_angle_ef_target.y > 9000.0f) {
-            _angle_ef_target.x = wrap_180_cd_float(_angle_ef_target.x + 18000.0f);
-            _angle_ef_target.y = wrap_180_cd_float(18000.0f - _angle_ef_target.y);
+            _angle_ef_target.x = fast_wrap_180_cd(_angle_ef_target.x + 18000.0f);
+            _angle_ef_target.y = fast_wrap_180_cd(18000.0f - _angle_ef_target.y);
             _angle_ef_target.z = wrap_360_cd_float(_angle_ef_target.z + 18000.0f);
         }
         if (_angle_ef_target.y < -9000.0f) {
-            _angle_ef_target.x = wrap_180_cd_float(_angle_ef_target.x + 18000.0f);
-            _angle_ef_target.y = wrap_180_cd_float(-18000.0f - _angle_ef_target.y);
+            _angle_ef_target.x = fast_wrap_180_cd(_angle_ef_target.x + 18000.0f);
+            _angle_ef_target.y = fast_wrap_180_cd(-18000.0f - _angle_ef_target.y);
             _angle_ef_target.z = wrap_360_cd_float(_angle_ef_target.z + 18000.0f);
         }
     }
@@ -484,10 +493,85 @@ bool AC_AttitudeControl::frame_conversion_bf_to_ef(const Vector3f& bf_vector, Ve
     return true;
 }
 
+// angle_error_bf_quat - body-frame rotation in centi-degrees that takes the vehicle attitude in dcm to the earth-frame roll, pitch and yaw target in centi-degrees
+//  the rotation axis scaled by the angle, so for small errors this matches converting the earth-frame angle errors with frame_conversion_ef_to_bf
+void AC_AttitudeControl::angle_error_bf_quat(const Matrix3f& dcm, const Vector3f& angle_ef_target, Vector3f& angle_bf_error)
+{
+    // target attitude quaternion from the half angles
+    float sr, cr, sp, cp, sy, cy;
+    fast_sincosf(angle_ef_target.x * (0.5f / AC_ATTITUDE_CONTROL_DEGX100), &sr, &cr);
+    fast_sincosf(angle_ef_target.y * (0.5f / AC_ATTITUDE_CONTROL_DEGX100), &sp, &cp);
+    fast_sincosf(angle_ef_target.z * (0.5f / AC_ATTITUDE_CONTROL_DEGX100), &sy, &cy);
+    Quaternion target(cr*cp*cy + sr*sp*sy,
+                      sr*cp*cy - cr*sp*sy,
+                      cr*sp*cy + sr*cp*sy,
+                      cr*cp*sy - sr*sp*cy);
+
+    // vehicle attitude quaternion, without trig
+    Quaternion vehicle;
+    vehicle.from_rotation_matrix(dcm);
+
+    // rotation from the vehicle to the target attitude in the body frame
+    Quaternion error = vehicle.inverse() * target;
+
+    // take the shorter way round
+    if (error.q1 < 0.0f) {
+        error.q1 = -error.q1;
+        error.q2 = -error.q2;
+        error.q3 = -error.q3;
+        error.q4 = -error.q4;
+    }
+
+    // convert to a rotation vector
+    angle_bf_error = Vector3f(error.q2, error.q3, error.q4);
+    float sin_half_angle = angle_bf_error.length();
+    if (sin_half_angle > 1.0e-6f) {
+        angle_bf_error *= 2.0f * fast_atan2f(sin_half_angle, error.q1) / sin_half_angle * AC_ATTITUDE_CONTROL_DEGX100;
+    } else {
+        angle_bf_error *= 2.0f * AC_ATTITUDE_CONTROL_DEGX100;
+    }
+}
+
+// rate_ef_to_bf_quat - body-frame rates of the vehicle in dcm that match the earth-frame roll, pitch and yaw rates of the target attitude
+//  the target's angular velocity is found in earth axes and rotated into the vehicle's body axes, so it is in the same frame as angle_error_bf_quat
+void AC_AttitudeControl::rate_ef_to_bf_quat(const Matrix3f& dcm, const Vector3f& angle_ef_target, const Vector3f& rate_ef, Vector3f& rate_bf)
+{
+    float sp, cp, sy, cy;
+    fast_sincosf(angle_ef_target.y * (1.0f / AC_ATTITUDE_CONTROL_DEGX100), &sp, &cp);
+    fast_sincosf(angle_ef_target.z * (1.0f / AC_ATTITUDE_CONTROL_DEGX100), &sy, &cy);
+
+    // roll about the target's x axis, pitch about the axis after yaw, yaw about down
+    Vector3f rate_ned(cy*cp*rate_ef.x - sy*rate_ef.y,
+                      sy*cp*rate_ef.x + cy*rate_ef.y,
+                      -sp*rate_ef.x + rate_ef.z);
+    rate_bf = dcm.mul_transpose(rate_ned);
+}
+
 //
 // protected methods
 //
 
+// update_angle_bf_error - set _angle_bf_error from the earth-frame angle target, or from the errors to it
+void AC_AttitudeControl::update_angle_bf_error(const Vector3f& angle_ef_target, const Vector3f& angle_ef_error)
+{
+    if (_quat_error_enabled) {
+        // the float target against the attitude matrix, free of the rounding in roll_sensor etc
+        angle_error_bf_quat(_ahrs.get_dcm_matrix(), angle_ef_target, _angle_bf_error);
+    } else {
+        frame_conversion_ef_to_bf(angle_ef_error, _angle_bf_error);
+    }
+}
+
+// update_rate_bf_feedforward - set _rate_bf_desired from earth-frame feed forward rates, in the same frame as _angle_bf_error
+void AC_AttitudeControl::update_rate_bf_feedforward(const Vector3f& rate_ef)
+{
+    if (_quat_error_enabled) {
+        rate_ef_to_bf_quat(_ahrs.get_dcm_matrix(), _angle_ef_target, rate_ef, _rate_bf_desired);
+    } else {
+        frame_conversion_ef_to_bf(rate_ef, _rate_bf_desired);
+    }
+}
+
 //
 // stabilized rate controller (body-frame) methods
 //
@@ -496,7 +580,7 @@ bool AC_AttitudeControl::frame_conversion_bf_to_ef(const Vector3f& bf_vector, Ve
 void AC_AttitudeControl::update_ef_roll_angle_and_error(float roll_rate_ef, Vector3f &angle_ef_error, float overshoot_max)
 {
     // calculate angle error with maximum of +- max angle overshoot
-    angle_ef_error.x = wrap_180_cd_float(_angle_ef_target.x - _ahrs.roll_sensor);
+    angle_ef_error.x = fast_wrap_180_cd(_angle_ef_target.x - _ahrs.roll_sensor);
     angle_ef_error.x  = constrain_float(angle_ef_error.x, -overshoot_max, overshoot_max);
 
     // update roll angle target to be within max angle overshoot of our roll angle
@@ -504,7 +588,7 @@ void AC_AttitudeControl::update_ef_roll_angle_and_error(float roll_rate_ef, Vect
 
     // increment the roll angle target
     _angle_ef_target.x += roll_rate_ef * _dt;
-    _angle_ef_target.x = wrap_180_cd_float(_angle_ef_target.x);
+    _angle_ef_target.x = fast_wrap_180_cd(_angle_ef_target.x);
 }
 
 // update_ef_pitch_angle_and_error - update _angle_ef_target.y using an earth frame pitch rate request
@@ -512,7 +596,7 @@ void AC_AttitudeControl::update_ef_pitch_angle_and_error(float pitch_rate_ef, Ve
 {
     // calculate angle error with maximum of +- max angle overshoot
     // To-Do: should we do something better as we cross 90 degrees?
-    angle_ef_error.y = wrap_180_cd_float(_angle_ef_target.y - _ahrs.pitch_sensor);
+    angle_ef_error.y = fast_wrap_180_cd(_angle_ef_target.y - _ahrs.pitch_sensor);
     angle_ef_error.y  = constrain_float(angle_ef_error.y, -overshoot_max, overshoot_max);
 
     // update pitch angle target to be within max angle overshoot of our pitch angle
@@ -520,14 +604,14 @@ void AC_AttitudeControl::update_ef_pitch_angle_and_error(float pitch_rate_ef, Ve
 
     // increment the pitch angle target
     _angle_ef_target.y += pitch_rate_ef * _dt;
-    _angle_ef_target.y = wrap_180_cd_float(_angle_ef_target.y);
+    _angle_ef_target.y = fast_wrap_180_cd(_angle_ef_target.y);
 }
 
 // update_ef_yaw_angle_and_error - update _angle_ef_target.z using an earth frame yaw rate request
 void AC_AttitudeControl::update_ef_yaw_angle_and_error(float yaw_rate_ef, Vector3f &angle_ef_error, float overshoot_max)
 {
     // calculate angle error with maximum of +- max angle overshoot
-    angle_ef_error.z = wrap_180_cd_float(_angle_ef_target.z - _ahrs.yaw_sensor);
+    angle_ef_error.z = fast_wrap_180_cd(_angle_ef_target.z - _ahrs.yaw_sensor);
     angle_ef_error.z  = constrain_float(angle_ef_error.z, -overshoot_max, overshoot_max);
 
     // update yaw angle target to be within max angle overshoot of our current heading
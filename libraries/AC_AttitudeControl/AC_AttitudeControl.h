@@ -41,6 +41,7 @@
 #define AC_ATTITUDE_400HZ_DT                            0.0025f // delta time in seconds for 400hz update rate
 
 #define AC_ATTITUDE_CONTROL_RATE_BF_FF_DEFAULT          1       // body-frame rate feedforward enabled by default
+#define AC_ATTITUDE_CONTROL_QUAT_ERROR_DEFAULT          1       // body-frame angle error and feed forward from quaternions by default
 
 class AC_AttitudeControl {
 public:
@@ -134,6 +135,12 @@ public:
     //  returns false if conversion fails due to gimbal lock
     bool frame_conversion_bf_to_ef(const Vector3f& bf_vector, Vector3f &ef_vector);
 
+    // angle_error_bf_quat - body-frame rotation in centi-degrees that takes the vehicle attitude in dcm to an earth-frame roll, pitch and yaw target in centi-degrees
+    static void angle_error_bf_quat(const Matrix3f& dcm, const Vector3f& angle_ef_target, Vector3f& angle_bf_error);
+
+    // rate_ef_to_bf_quat - body-frame rates of the vehicle in dcm that match earth-frame roll, pitch and yaw rates of the target attitude
+    static void rate_ef_to_bf_quat(const Matrix3f& dcm, const Vector3f& angle_ef_target, const Vector3f& rate_ef, Vector3f& rate_bf);
+
     //
     // public accessor functions
     //
@@ -223,6 +230,12 @@ protected:
     // update_ef_yaw_angle_and_error - update _angle_ef_target.z using an earth frame yaw rate request
     void update_ef_yaw_angle_and_error(float yaw_rate_ef, Vector3f &angle_ef_error, float overshoot_max);
 
+    // update_angle_bf_error - sets _angle_bf_error from the earth-frame angle target using the quaternion error, or from the errors to it using the euler rate conversion, depending on QUAT_ERR
+    void update_angle_bf_error(const Vector3f& angle_ef_target, const Vector3f& angle_ef_error);
+
+    // update_rate_bf_feedforward - sets _rate_bf_desired from earth-frame feed forward rates, in the frame update_angle_bf_error uses
+    void update_rate_bf_feedforward(const Vector3f& rate_ef);
+
     // integrate_bf_rate_error_to_angle_errors - calculates body frame angle errors
     //   body-frame feed forward rates (centi-degrees / second) taken from _angle_bf_error
     //   angle errors in centi-degrees placed in _angle_bf_error
@@ -265,6 +278,7 @@ protected:
     AP_Float            _accel_pitch_max;          // maximum rotation acceleration for earth-frame pitch axis
     AP_Float            _accel_yaw_max;           // maximum rotation acceleration for earth-frame yaw axis
     AP_Int8             _rate_bf_ff_enabled;    // Enable/Disable body frame rate feed forward
+    AP_Int8             _quat_error_enabled;    // Enable/Disable quaternion body frame angle error
 
     AP_Float _roll_lead_w;
     AP_Float _roll_lead_r;
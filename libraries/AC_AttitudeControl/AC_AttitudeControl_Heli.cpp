@@ -269,8 +269,7 @@ static LowPassFilterFloat rate_dynamics_filter;     // Rate Dynamics filter
 
     // Make swash rate vector
     Vector2f swashratevector;
-    swashratevector.x = cosf(cc_angle);
-    swashratevector.y = sinf(cc_angle);
+    fast_sincosf(cc_angle, &swashratevector.y, &swashratevector.x);
     swashratevector.normalize();
 
     // rotate the output
@@ -0,0 +1,186 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+//
+// Comparison of the euler and quaternion body-frame angle error and
+// rate feed forward calculations in AC_AttitudeControl, for agreement
+// at small errors and time per call
+//
+
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Param.h>
+#include <AP_HAL.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_PX4.h>
+#include <AP_HAL_Linux.h>
+#include <AP_HAL_Empty.h>
+#include <AP_Math.h>
+#include <AP_ADC.h>
+#include <AP_ADC_AnalogSource.h>
+#include <AP_InertialSensor.h>
+#include <AP_Baro.h>
+#include <AP_Compass.h>
+#include <AP_Declination.h>
+#include <AP_GPS.h>
+#include <AP_Airspeed.h>
+#include <AP_AHRS.h>
+#include <AP_NavEKF.h>
+#include <AP_Vehicle.h>
+#include <AP_Mission.h>
+#include <AP_Rally.h>
+#include <AP_Terrain.h>
+#include <AP_Notify.h>
+#include <AP_BattMonitor.h>
+#include <AP_OpticalFlow.h>
+#include <AP_Curve.h>
+#include <AP_Motors.h>
+#include <RC_Channel.h>
+#include <DataFlash.h>
+#include <Filter.h>
+#include <GCS_MAVLink.h>
+#include <SITL.h>
+#include <StorageManager.h>
+#include <AC_PID.h>
+#include <AC_P.h>
+#include <AC_AttitudeControl.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#define NUM_CASES   50
+#define NUM_REPEATS 200
+
+// vehicle attitudes, with the trig the AHRS caches for them
+static struct {
+    Matrix3f dcm;
+    Vector3f angle_cd;
+    float sin_roll, cos_roll, sin_pitch, cos_pitch;
+} cases[NUM_CASES];
+
+// earth-frame targets and feed forward rates
+static Vector3f targets[NUM_CASES];
+static Vector3f rates[NUM_CASES];
+
+/*
+  the existing path: earth-frame errors from the euler angles, then
+  the same conversion as frame_conversion_ef_to_bf()
+ */
+static void euler_error_bf(uint8_t i, Vector3f &angle_bf_error)
+{
+    Vector3f angle_ef_error(fast_wrap_180_cd(targets[i].x - cases[i].angle_cd.x),
+                            fast_wrap_180_cd(targets[i].y - cases[i].angle_cd.y),
+                            fast_wrap_180_cd(targets[i].z - cases[i].angle_cd.z));
+    angle_bf_error.x = angle_ef_error.x - cases[i].sin_pitch * angle_ef_error.z;
+    angle_bf_error.y = cases[i].cos_roll * angle_ef_error.y + cases[i].sin_roll * cases[i].cos_pitch * angle_ef_error.z;
+    angle_bf_error.z = -cases[i].sin_roll * angle_ef_error.y + cases[i].cos_pitch * cases[i].cos_roll * angle_ef_error.z;
+}
+
+// the existing feed forward: frame_conversion_ef_to_bf() at the vehicle attitude
+static void euler_rate_bf(uint8_t i, Vector3f &rate_bf)
+{
+    const Vector3f &r = rates[i];
+    rate_bf.x = r.x - cases[i].sin_pitch * r.z;
+    rate_bf.y = cases[i].cos_roll * r.y + cases[i].sin_roll * cases[i].cos_pitch * r.z;
+    rate_bf.z = -cases[i].sin_roll * r.y + cases[i].cos_pitch * cases[i].cos_roll * r.z;
+}
+
+/*
+  attitudes spread over +-40 degrees of roll and pitch and all
+  headings, with targets up to max_error_cd away on each axis
+ */
+static void setup_cases(float max_error_cd)
+{
+    for (uint8_t i=0; i<NUM_CASES; i++) {
+        float roll = 0.7f * sinf(i * 1.1f);
+        float pitch = 0.7f * sinf(i * 2.3f + 1);
+        float yaw = wrap_PI(i * 0.9f);
+        cases[i].dcm.from_euler(roll, pitch, yaw);
+        cases[i].angle_cd = Vector3f(roll, pitch, yaw) * AC_ATTITUDE_CONTROL_DEGX100;
+        cases[i].sin_roll = sinf(roll);
+        cases[i].cos_roll = cosf(roll);
+        cases[i].sin_pitch = sinf(pitch);
+        cases[i].cos_pitch = cosf(pitch);
+        targets[i] = cases[i].angle_cd + Vector3f(sinf(i * 0.7f), cosf(i * 1.9f), sinf(i * 3.1f + 2)) * max_error_cd;
+        rates[i] = Vector3f(cosf(i * 1.3f), sinf(i * 0.4f), cosf(i * 2.7f)) * 9000;
+    }
+}
+
+/*
+  largest difference between the euler and quaternion paths over the
+  cases, for the angle error in cdeg and the feed forward in cdeg/s
+ */
+static void compare(float &angle_diff, float &rate_diff)
+{
+    angle_diff = 0;
+    rate_diff = 0;
+    for (uint8_t i=0; i<NUM_CASES; i++) {
+        Vector3f euler, quat;
+        euler_error_bf(i, euler);
+        AC_AttitudeControl::angle_error_bf_quat(cases[i].dcm, targets[i], quat);
+        angle_diff = max(angle_diff, (euler - quat).length());
+        euler_rate_bf(i, euler);
+        AC_AttitudeControl::rate_ef_to_bf_quat(cases[i].dcm, targets[i], rates[i], quat);
+        rate_diff = max(rate_diff, (euler - quat).length());
+    }
+}
+
+void setup()
+{
+    hal.console->println("attitude error comparison");
+
+    float angle_diff, rate_diff;
+
+    // on target the feed forward paths agree, and at small errors the
+    // angle errors agree to first order
+    setup_cases(0);
+    compare(angle_diff, rate_diff);
+    hal.console->printf("on target: feed forward max difference %.2f cdeg/s %s\n",
+                        rate_diff, rate_diff < 5.0f ? "OK" : "FAILED");
+
+    setup_cases(20);
+    compare(angle_diff, rate_diff);
+    hal.console->printf("errors up to 20 cdeg: max difference %.2f cdeg %s\n",
+                        angle_diff, angle_diff < 1.0f ? "OK" : "FAILED");
+
+    // at large errors the euler path includes the coupling of the axes,
+    // and its feed forward is for the vehicle rather than the target
+    setup_cases(3000);
+    compare(angle_diff, rate_diff);
+    hal.console->printf("errors up to 30 deg: max difference %.0f cdeg, feed forward %.0f cdeg/s\n\n",
+                        angle_diff, rate_diff);
+}
+
+void loop()
+{
+    Vector3f error, rate;
+    // the results are summed so the calls are not optimised away
+    float sum = 0;
+
+    // one controller update: the angle error and the feed forward
+    uint32_t t0 = hal.scheduler->micros();
+    for (uint16_t r=0; r<NUM_REPEATS; r++) {
+        for (uint8_t i=0; i<NUM_CASES; i++) {
+            euler_error_bf(i, error);
+            euler_rate_bf(i, rate);
+            sum += error.x + rate.y;
+        }
+    }
+    uint32_t t_euler = hal.scheduler->micros() - t0;
+
+    t0 = hal.scheduler->micros();
+    for (uint16_t r=0; r<NUM_REPEATS; r++) {
+        for (uint8_t i=0; i<NUM_CASES; i++) {
+            AC_AttitudeControl::angle_error_bf_quat(cases[i].dcm, targets[i], error);
+            AC_AttitudeControl::rate_ef_to_bf_quat(cases[i].dcm, targets[i], rates[i], rate);
+            sum += error.x + rate.y;
+        }
+    }
+    uint32_t t_quat = hal.scheduler->micros() - t0;
+
+    const float scale = 1000.0f / (NUM_REPEATS * NUM_CASES);
+    hal.console->printf("euler %.1f nsec/call, quaternion %.1f nsec/call (sum %.0f)\n",
+                        t_euler * scale, t_quat * scale, sum);
+
+    hal.scheduler->delay(5000);
+}
+
+AP_HAL_MAIN();
@@ -122,7 +122,9 @@ AC_WPNav::AC_WPNav(const AP_InertialNav& inav, const AP_AHRS& ahrs, AC_PosContro
     _track_leash_length(0.0f),
     _slow_down_dist(0.0f),
     _spline_time(0.0f),
-    _spline_time_scale(0.0f),
+    _spline_dist(0.0f),
+    _spline_length(0.0f),
+    _spline_table_idx(0),
     _spline_vel_scaler(0.0f),
     _yaw(0.0f)
 {
@@ -834,6 +836,9 @@ void AC_WPNav::set_spline_origin_and_destination(const Vector3f& origin, const V
         update_spline_solution(origin, destination, _spline_origin_vel, _spline_destination_vel);
     }
 
+    // convert starting spline time (including any overrun carried from the previous segment) to distance along the new segment
+    _spline_dist = spline_dist_from_time(_spline_time);
+
     // initialise yaw heading to current heading
     _yaw = _attitude_control.angle_ef_targets().z;
 
@@ -887,6 +892,9 @@ void AC_WPNav::set_spline_dest_and_vel(const Vector3f& dest_pos, const Vector3f&
         update_spline_solution(_origin, _destination, _spline_origin_vel, _spline_destination_vel);
     }
 
+    // start at the beginning of the new segment
+    _spline_dist = 0.0f;
+
     // initialise yaw heading to current heading
     _yaw = _attitude_control.angle_ef_targets().z;
 
@@ -943,8 +951,78 @@ void AC_WPNav::update_spline_solution(const Vector3f& origin, const Vector3f& de
     _hermite_spline_solution[1] = origin_vel;
     _hermite_spline_solution[2] = -origin*3.0f -origin_vel*2.0f + dest*3.0f - dest_vel;
     _hermite_spline_solution[3] = origin*2.0f + origin_vel -dest*2.0f + dest_vel;
+
+    // rebuild arc length table for the new solution
+    update_spline_table();
  }
 
+/// update_spline_table - fills the arc length table for the current spline solution
+///     called from update_spline_solution so the per-cycle target advancement is a table lookup
+void AC_WPNav::update_spline_table()
+{
+    Vector3f prev_pos = _hermite_spline_solution[0];
+    Vector3f pos, vel;
+
+    _spline_table[0] = 0.0f;
+    for (uint8_t i=1; i<=WPNAV_SPLINE_TABLE_SIZE; i++) {
+        calc_spline_pos_vel((float)i / WPNAV_SPLINE_TABLE_SIZE, pos, vel);
+        _spline_table[i] = _spline_table[i-1] + (pos - prev_pos).length();
+        prev_pos = pos;
+    }
+    _spline_length = _spline_table[WPNAV_SPLINE_TABLE_SIZE];
+    _spline_table_idx = 0;
+}
+
+/// spline_time_from_dist - returns the spline time at which the target has travelled dist cm along the segment
+///     times beyond 1.0 are extrapolated so overrun can be carried into the next segment
+float AC_WPNav::spline_time_from_dist(float dist)
+{
+    if (dist <= 0.0f) {
+        _spline_table_idx = 0;
+        return 0.0f;
+    }
+    if (dist >= _spline_length) {
+        _spline_table_idx = WPNAV_SPLINE_TABLE_SIZE-1;
+        if (_spline_length <= 0.0f) {
+            return 1.0f;
+        }
+        return 1.0f + (dist - _spline_length) / _spline_length;
+    }
+
+    // the target normally moves forward so start searching from the last interval used
+    while (_spline_table_idx > 0 && _spline_table[_spline_table_idx] > dist) {
+        _spline_table_idx--;
+    }
+    while (_spline_table_idx < WPNAV_SPLINE_TABLE_SIZE-1 && _spline_table[_spline_table_idx+1] < dist) {
+        _spline_table_idx++;
+    }
+
+    // interpolate within the interval
+    float interval_len = _spline_table[_spline_table_idx+1] - _spline_table[_spline_table_idx];
+    float frac = 0.0f;
+    if (interval_len > 0.0f) {
+        frac = (dist - _spline_table[_spline_table_idx]) / interval_len;
+    }
+    return (_spline_table_idx + frac) / WPNAV_SPLINE_TABLE_SIZE;
+}
+
+/// spline_dist_from_time - returns the distance in cm along the segment at the given spline time
+float AC_WPNav::spline_dist_from_time(float spline_time) const
+{
+    if (spline_time <= 0.0f) {
+        return 0.0f;
+    }
+    if (spline_time >= 1.0f) {
+        return _spline_length;
+    }
+    float pos = spline_time * WPNAV_SPLINE_TABLE_SIZE;
+    uint8_t idx = (uint8_t)pos;
+    if (idx >= WPNAV_SPLINE_TABLE_SIZE) {
+        return _spline_length;
+    }
+    return _spline_table[idx] + (pos - idx) * (_spline_table[idx+1] - _spline_table[idx]);
+}
+
 /// advance_spline_target_along_track - move target location along track from origin to destination
 void AC_WPNav::advance_spline_target_along_track(float dt)
 {
@@ -954,8 +1032,11 @@ void AC_WPNav::advance_spline_target_along_track(float dt)
         // update target position and velocity from spline calculator
         calc_spline_pos_vel(_spline_time, target_pos, target_vel);
 
-        // update velocity
-        float spline_dist_to_wp = (_destination - target_pos).length();
+        // update velocity using the remaining distance along the spline
+        float spline_dist_to_wp = _spline_length - _spline_dist;
+        if (spline_dist_to_wp < 0.0f) {
+            spline_dist_to_wp = 0.0f;
+        }
 
         // if within the stopping distance from destination, set target velocity to sqrt of distance * 2 * acceleration
         if (!_flags.fast_waypoint && spline_dist_to_wp < _slow_down_dist) {
@@ -971,24 +1052,19 @@ void AC_WPNav::advance_spline_target_along_track(float dt)
             _spline_vel_scaler = _wp_speed_cms;
         }
 
-        // scale the spline_time by the velocity we've calculated vs the velocity that came out of the spline calculator
-        float target_vel_length = target_vel.length();
-        if (target_vel_length != 0.0f) {
-            _spline_time_scale = _spline_vel_scaler/target_vel_length;
-        }
-
         // update target position
         _pos_control.set_pos_target(target_pos);
 
         // update the yaw
         _yaw = RadiansToCentiDegrees(fast_atan2(target_vel.y,target_vel.x));
 
-        // advance spline time to next step
-        _spline_time += _spline_time_scale*dt;
+        // advance target along the spline by the distance travelled at the target velocity
+        _spline_dist += _spline_vel_scaler*dt;
+        _spline_time = spline_time_from_dist(_spline_dist);
 
         // we will reach the next waypoint in the next step so set reached_destination flag
         // To-Do: is this one step too early?
-        if (_spline_time >= 1.0f) {
+        if (_spline_dist >= _spline_length) {
             _flags.reached_destination = true;
         }
     }
@@ -45,6 +45,8 @@
 
 #define WPNAV_YAW_DIST_MIN                 200      // minimum track length which will lead to target yaw being updated to point at next waypoint.  Under this distance the yaw target will be frozen at the current heading
 
+#define WPNAV_SPLINE_TABLE_SIZE             16      // number of intervals in each spline segment's arc length table
+
 class AC_WPNav
 {
 public:
@@ -275,6 +277,17 @@ protected:
     /// 	relies on update_spline_solution being called since the previous
     void calc_spline_pos_vel(float spline_time, Vector3f& position, Vector3f& velocity);
 
+    /// update_spline_table - fills the arc length table for the current spline solution
+    ///     called from update_spline_solution so the per-cycle target advancement is a table lookup
+    void update_spline_table();
+
+    /// spline_time_from_dist - returns the spline time at which the target has travelled dist cm along the segment
+    ///     times beyond 1.0 are extrapolated so overrun can be carried into the next segment
+    float spline_time_from_dist(float dist);
+
+    /// spline_dist_from_time - returns the distance in cm along the segment at the given spline time
+    float spline_dist_from_time(float spline_time) const;
+
     // references to inertial nav and ahrs libraries
     const AP_InertialNav&   _inav;
     const AP_AHRS&          _ahrs;
@@ -315,7 +328,10 @@ protected:
 
     // spline variables
     float       _spline_time;           // current spline time between origin and destination
-    float       _spline_time_scale;     // current spline time between origin and destination
+    float       _spline_dist;           // distance in cm the target has travelled along the spline segment
+    float       _spline_length;         // total length in cm of the spline segment
+    float       _spline_table[WPNAV_SPLINE_TABLE_SIZE+1];   // distance in cm along the segment at evenly spaced spline times from 0 to 1
+    uint8_t     _spline_table_idx;      // table interval holding _spline_dist.  only moves forward during a segment
     Vector3f    _spline_origin_vel;     // the target velocity vector at the origin of the spline segment
     Vector3f    _spline_destination_vel;// the target velocity vector at the destination point of the spline segment
     Vector3f    _hermite_spline_solution[4]; // array describing spline path between origin and destination
@@ -120,7 +120,10 @@ bool AP_ADC_ADS1115::init()
     _gain = ADS1115_PGA_4P096; 
     _i2c_sem = hal.i2c->get_semaphore();
 
-    hal.scheduler->register_timer_process(AP_HAL_MEMBERPROC(&AP_ADC_ADS1115::_update));
+    // prefer the I2C bus thread, polling for the 10Hz conversions at 100Hz
+    if (!hal.i2c->register_periodic_process(AP_HAL_MEMBERPROC(&AP_ADC_ADS1115::_update), 10000)) {
+        hal.scheduler->register_timer_process(AP_HAL_MEMBERPROC(&AP_ADC_ADS1115::_update));
+    }
     hal.scheduler->resume_timer_procs();
 
     return true;
@@ -101,11 +101,11 @@ AP_AHRS_DCM::matrix_update(float _G_Dt)
     // value
     _omega.zero();
 
-    // average across all healthy gyros. This reduces noise on systems
-    // with more than one gyro    
+    // average across all healthy gyros that have not been voted out.
+    // This reduces noise on systems with more than one gyro
     uint8_t healthy_count = 0;    
     for (uint8_t i=0; i<_ins.get_gyro_count(); i++) {
-        if (_ins.get_gyro_health(i)) {
+        if (_ins.use_gyro(i)) {
             _omega += _ins.get_gyro(i);
             healthy_count++;
         }
@@ -226,7 +226,9 @@ AP_AHRS_DCM::renorm(Vector3f const &a, Vector3f &result)
     // we don't want to compound the error by making DCM less
     // accurate.
 
-    renorm_val = 1.0f / a.length();
+    // a zero, infinite or nan length gives a renorm_val outside the
+    // limits below
+    renorm_val = fast_inv_sqrtf(a * a);
 
     // keep the average for reporting
     _renorm_val_sum += renorm_val;
@@ -745,10 +747,12 @@ AP_AHRS_DCM::drift_correction(float deltat)
     float tilt = pythagorous2(GA_e.x, GA_e.y);
 
     // equation 11
-    float theta = atan2f(GA_b[besti].y, GA_b[besti].x);
+    float theta = fast_atan2f(GA_b[besti].y, GA_b[besti].x);
 
     // equation 12
-    Vector3f GA_e2 = Vector3f(cosf(theta)*tilt, sinf(theta)*tilt, GA_e.z);
+    float sin_theta, cos_theta;
+    fast_sincosf(theta, &sin_theta, &cos_theta);
+    Vector3f GA_e2 = Vector3f(cos_theta*tilt, sin_theta*tilt, GA_e.z);
 
     // step 6
     error = GA_b[besti] % GA_e2;
@@ -761,7 +765,7 @@ AP_AHRS_DCM::drift_correction(float deltat)
     // accelerometers at high roll angles as long as we have a GPS
     if (AP_AHRS_DCM::use_compass()) {
         if (have_gps() && gps_gain == 1.0f) {
-            error[besti].z *= sinf(fabsf(roll));
+            error[besti].z *= fast_sinf(fabsf(roll));
         } else {
             error[besti].z = 0;
         }
@@ -914,7 +918,12 @@ AP_AHRS_DCM::euler_angles(void)
 {
     _body_dcm_matrix = _dcm_matrix;
     _body_dcm_matrix.rotateXYinv(_trim);
-    _body_dcm_matrix.to_euler(&roll, &pitch, &yaw);
+
+    // as Matrix3::to_euler(), with the fast approximations as this
+    // runs every loop
+    pitch = -fast_safe_asin(_body_dcm_matrix.c.x);
+    roll = fast_atan2f(_body_dcm_matrix.c.y, _body_dcm_matrix.c.z);
+    yaw = fast_atan2f(_body_dcm_matrix.b.x, _body_dcm_matrix.a.x);
 
     update_cd_values();
 }
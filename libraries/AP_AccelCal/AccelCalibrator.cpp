@@ -251,6 +251,37 @@ void AccelCalibrator::set_status(enum accel_cal_status_t status) {
     };
 }
 
+/*
+  one Gauss-Newton step of the first N parameters of fit_param.
+  Returns false if the normal equations can't be solved
+ */
+template <uint8_t N>
+bool AccelCalibrator::fit_step(struct param_t& fit_param) const
+{
+    LMSolver<N> solver;
+
+    for(uint16_t k = 0; k<_samples_collected; k++) {
+        Vector3f sample;
+        get_sample(k, sample);
+
+        float jacob[ACCEL_CAL_MAX_NUM_PARAMS];
+
+        calc_jacob(sample, fit_param, jacob);
+        solver.add_sample(jacob, calc_residual(sample, fit_param));
+    }
+
+    float delta[N];
+    if(!solver.solve(0.0f, delta)) {
+        return false;
+    }
+
+    float* param_array = (float*)&fit_param;
+    for(uint8_t i=0; i < N; i++) {
+        param_array[i] -= delta[i];
+    }
+    return true;
+}
+
 void AccelCalibrator::run_fit(uint8_t max_iterations, float& fitness)
 {
     if(_sample_buffer == NULL) {
@@ -260,46 +291,21 @@ void AccelCalibrator::run_fit(uint8_t max_iterations, float& fitness)
     float min_fitness = fitness;
 
     struct param_t fit_param = _params;
-    float* param_array = (float*)&fit_param;
     uint8_t num_iterations = 0;
 
     while(num_iterations < max_iterations) {
         float last_fitness = fitness;
 
-        float JTJ[ACCEL_CAL_MAX_NUM_PARAMS*ACCEL_CAL_MAX_NUM_PARAMS];
-        float JTFI[ACCEL_CAL_MAX_NUM_PARAMS];
-
-        memset(&JTJ,0,sizeof(JTJ));
-        memset(&JTFI,0,sizeof(JTFI));
-
-        for(uint16_t k = 0; k<_samples_collected; k++) {
-            Vector3f sample;
-            get_sample(k, sample);
-
-            float jacob[ACCEL_CAL_MAX_NUM_PARAMS];
-
-            calc_jacob(sample, fit_param, jacob);
-
-            for(uint8_t i = 0; i < get_num_params(); i++) {
-                // compute JTJ
-                for(uint8_t j = 0; j < get_num_params(); j++) {
-                    JTJ[i*get_num_params()+j] += jacob[i] * jacob[j];
-                }
-                // compute JTFI
-                JTFI[i] += jacob[i] * calc_residual(sample, fit_param);
-            }
+        bool solved;
+        if (get_num_params() == 9) {
+            solved = fit_step<9>(fit_param);
+        } else {
+            solved = fit_step<6>(fit_param);
         }
-
-        if(!inverse(JTJ, JTJ, get_num_params())) {
+        if(!solved) {
             return;
         }
 
-        for(uint8_t row=0; row < get_num_params(); row++) {
-            for(uint8_t col=0; col < get_num_params(); col++) {
-                param_array[row] -= JTFI[col] * JTJ[row*get_num_params()+col];
-            }
-        }
-
         fitness = calc_mean_squared_residuals(fit_param);
 
         if(isnan(fitness) || isinf(fitness)) {
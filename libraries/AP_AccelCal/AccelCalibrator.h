@@ -76,6 +76,7 @@ private:
     float calc_mean_squared_residuals() const;
     float calc_mean_squared_residuals(const struct param_t& params) const;
     void calc_jacob(const Vector3f& sample, const struct param_t& params, float* ret) const;
+    template <uint8_t N> bool fit_step(struct param_t& fit_param) const;
     void run_fit(uint8_t max_iterations, float& fitness);
 };
 #endif //__ACCELCALIBRATOR_H__
@@ -43,7 +43,11 @@ bool AP_Airspeed_I2C::init(void)
     _collect();
     i2c_sem->give();
     if (_last_sample_time_ms != 0) {
-        hal.scheduler->register_timer_process(AP_HAL_MEMBERPROC(&AP_Airspeed_I2C::_timer));
+        // prefer the I2C bus thread. A 200Hz poll collects each
+        // measurement within 5ms of its completion
+        if (!hal.i2c->register_periodic_process(AP_HAL_MEMBERPROC(&AP_Airspeed_I2C::_timer), 5000)) {
+            hal.scheduler->register_timer_process(AP_HAL_MEMBERPROC(&AP_Airspeed_I2C::_timer));
+        }
         return true;
     }
     return false;
@@ -343,7 +343,7 @@ void AP_Baro::update(void)
     }
 
     // ensure the climb rate filter is updated
-    _climb_rate_filter.update(get_altitude(), get_last_update());
+    _climb_rate_filter.update(get_altitude(), get_sample_time_ms());
 }
 
 /*
@@ -8,6 +8,7 @@
 #include <Filter.h>
 #include <DerivativeFilter.h>
 #include <AP_Buffer.h>
+#include "../AP_HAL/utility/RingBuffer.h"
 
 // maximum number of sensor instances
 #if HAL_CPU_CLASS == HAL_CPU_CLASS_16
@@ -24,6 +25,13 @@
 #define BARO_MAX_DRIVERS 2
 #endif
 
+// number of timestamped samples queued per sensor between updates
+#if HAL_CPU_CLASS == HAL_CPU_CLASS_16
+#define BARO_SAMPLE_QUEUE_SIZE 10
+#else
+#define BARO_SAMPLE_QUEUE_SIZE 24
+#endif
+
 class AP_Baro_Backend;
 
 class AP_Baro
@@ -106,6 +114,11 @@ public:
     uint32_t get_last_update(void) const { return get_last_update(_primary); }
     uint32_t get_last_update(uint8_t instance) const { return sensors[_primary].last_update_ms; }
 
+    // get the millis() time at which the samples averaged into the
+    // current pressure were taken
+    uint32_t get_sample_time_ms(void) const { return get_sample_time_ms(_primary); }
+    uint32_t get_sample_time_ms(uint8_t instance) const { return sensors[instance].sample_time_ms; }
+
     // settable parameters
     static const struct AP_Param::GroupInfo var_info[];
 
@@ -122,6 +135,7 @@ public:
     struct {
         AP_Buffer<float,10> press_buffer;
         AP_Buffer<float,10> temp_buffer;
+        AP_Buffer<uint32_t,10> time_buffer;
     } _hil;
 
     // register a new sensor, claiming a sensor slot. If we are out of
@@ -145,8 +159,16 @@ private:
     // what is the primary sensor at the moment?
     uint8_t _primary;
 
+    // a sample queued by a backend
+    struct baro_sample {
+        float pressure;
+        float temperature;
+        uint32_t time_us;
+    };
+
     struct sensor {
         uint32_t last_update_ms;        // last update time in ms
+        uint32_t sample_time_ms;        // time the published samples were taken
         bool healthy:1;                 // true if sensor is healthy
         bool alt_ok:1;                  // true if calculated altitude is ok
         bool calibrated:1;              // true if calculated calibrated successfully
@@ -155,6 +177,7 @@ private:
         float altitude;                 // calculated altitude
         AP_Float ground_temperature;
         AP_Float ground_pressure;
+        ObjectBuffer<baro_sample, BARO_SAMPLE_QUEUE_SIZE> samples;
     } sensors[BARO_MAX_INSTANCES];
 
     AP_Int8                             _alt_offset;
@@ -162,7 +185,7 @@ private:
     float                               _EAS2TAS;
     float                               _external_temperature;
     uint32_t                            _last_external_temperature_ms;
-    DerivativeFilterFloat_Size7         _climb_rate_filter;
+    FastDerivativeFilterFloat_Size7     _climb_rate_filter;
     bool                                _hil_mode:1;
 
     void SimpleAtmosphere(const float alt, float &sigma, float &delta, float &theta);
@@ -53,8 +53,6 @@ extern const AP_HAL::HAL& hal;
 AP_Baro_BMP085::AP_Baro_BMP085(AP_Baro &baro) :
     AP_Baro_Backend(baro),
     _instance(0),
-    _temp_sum(0),
-    _press_sum(0),
     _count(0),
     BMP085_State(0),
     ac1(0), ac2(0), ac3(0), b1(0), b2(0), mb(0), mc(0), md(0),
@@ -150,14 +148,8 @@ void AP_Baro_BMP085::update(void)
         return;
     }
 
-    float temperature = 0.1f * _temp_sum / _count;
-    float pressure = _press_sum / _count;
-
     _count = 0;
-    _temp_sum = 0;
-    _press_sum = 0;
-
-    _copy_to_frontend(_instance, pressure, temperature);
+    _publish_samples(_instance);
 }
 
 // Send command to Read Pressure
@@ -223,7 +215,7 @@ void AP_Baro_BMP085::Calculate()
     x1 = ((int32_t)RawTemp - ac6) * ac5 >> 15;
     x2 = ((int32_t) mc << 11) / (x1 + md);
     b5 = x1 + x2;
-    _temp_sum += (b5 + 8) >> 4;
+    float temperature = 0.1f * ((b5 + 8) >> 4);
 
     // Pressure calculations
     b6 = b5 - 4000;
@@ -245,12 +237,9 @@ void AP_Baro_BMP085::Calculate()
     x1 = (p >> 8) * (p >> 8);
     x1 = (x1 * 3038) >> 16;
     x2 = (-7357 * p) >> 16;
-    _press_sum += p + ((x1 + x2 + 3791) >> 4);
+    float pressure = p + ((x1 + x2 + 3791) >> 4);
 
-    _count++;
-    if (_count == 254) {
-        _temp_sum *= 0.5f;
-        _press_sum *= 0.5f;
-        _count /= 2;
+    if (_push_sample(_instance, pressure, temperature, hal.scheduler->micros())) {
+        _count++;
     }
 }
@@ -16,9 +16,7 @@ public:
 
 private:
     uint8_t         _instance;
-    float		    _temp_sum;
-    float			_press_sum;
-    uint8_t			_count;
+    uint8_t			_count;         // samples queued since the last update
 
     // Flymaple has no EOC pin, so use times instead
     uint32_t        _last_press_read_command_time;
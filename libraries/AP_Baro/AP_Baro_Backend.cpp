@@ -20,4 +20,60 @@ void AP_Baro_Backend::_copy_to_frontend(uint8_t instance, float pressure, float
     _frontend.sensors[instance].pressure = pressure;
     _frontend.sensors[instance].temperature = temperature;
     _frontend.sensors[instance].last_update_ms = hal.scheduler->millis();
+    _frontend.sensors[instance].sample_time_ms = _frontend.sensors[instance].last_update_ms;
+}
+
+/*
+  queue a sample for the frontend. Each sample keeps its own time, so
+  nothing is lost to accumulators saturating when updates are slow
+ */
+bool AP_Baro_Backend::_push_sample(uint8_t instance, float pressure, float temperature, uint32_t time_us)
+{
+    if (instance >= _frontend._num_sensors) {
+        return false;
+    }
+    AP_Baro::baro_sample sample;
+    sample.pressure = pressure;
+    sample.temperature = temperature;
+    sample.time_us = time_us;
+    return _frontend.sensors[instance].samples.push(sample);
+}
+
+/*
+  average the queued samples into the frontend, recording the mean
+  time they were taken. Returns false if there were no new samples
+ */
+bool AP_Baro_Backend::_publish_samples(uint8_t instance)
+{
+    if (instance >= _frontend._num_sensors) {
+        return false;
+    }
+    AP_Baro::baro_sample sample;
+    float pressure_sum = 0;
+    float temperature_sum = 0;
+    uint32_t first_us = 0;
+    uint32_t offset_sum_us = 0;
+    uint8_t count = 0;
+
+    while (_frontend.sensors[instance].samples.pop(sample)) {
+        // sum time offsets rather than times to avoid overflow
+        if (count == 0) {
+            first_us = sample.time_us;
+        }
+        offset_sum_us += sample.time_us - first_us;
+        pressure_sum += sample.pressure;
+        temperature_sum += sample.temperature;
+        count++;
+    }
+    if (count == 0) {
+        return false;
+    }
+
+    _copy_to_frontend(instance, pressure_sum / count, temperature_sum / count);
+
+    // convert to a millis() time using the age of the samples, which
+    // stays correct when micros() wraps
+    uint32_t age_us = hal.scheduler->micros() - (first_us + offset_sum_us / count);
+    _frontend.sensors[instance].sample_time_ms = _frontend.sensors[instance].last_update_ms - age_us / 1000;
+    return true;
 }
@@ -24,6 +24,13 @@ protected:
     AP_Baro &_frontend;
 
     void _copy_to_frontend(uint8_t instance, float pressure, float temperature);
+
+    // queue a sample taken at time_us. This is lock free, so it can be
+    // called from a timer process
+    bool _push_sample(uint8_t instance, float pressure, float temperature, uint32_t time_us);
+
+    // copy the average of the queued samples to the frontend
+    bool _publish_samples(uint8_t instance);
 };
 
 #endif // __AP_BARO_BACKEND_H__
@@ -68,6 +68,7 @@ void AP_Baro::setHIL(uint8_t instance, float pressure, float temperature)
     }
     _hil.press_buffer.push_back(pressure);
     _hil.temp_buffer.push_back(temperature);
+    _hil.time_buffer.push_back(hal.scheduler->micros());
 }
 
 // Read the sensor
@@ -75,21 +76,14 @@ void AP_Baro_HIL::update(void)
 {
     float pressure = 0.0;
     float temperature = 0.0;
-    float pressure_sum = 0.0;
-    float temperature_sum = 0.0;
-    uint32_t sum_count = 0;
+    uint32_t time_us = 0;
 
     while (_frontend._hil.press_buffer.is_empty() == false){
-        _frontend._hil.press_buffer.pop_front(pressure);
-        pressure_sum += pressure; // Pressure in Pascals
-        _frontend._hil.temp_buffer.pop_front(temperature);
-        temperature_sum += temperature; // degrees celcius
-        sum_count++;
+        _frontend._hil.press_buffer.pop_front(pressure); // Pressure in Pascals
+        _frontend._hil.temp_buffer.pop_front(temperature); // degrees celcius
+        _frontend._hil.time_buffer.pop_front(time_us);
+        _push_sample(0, pressure, temperature, time_us);
     }
 
-    if (sum_count > 0) {
-        pressure_sum /= (float)sum_count;
-        temperature_sum /= (float)sum_count;
-        _copy_to_frontend(0, pressure_sum, temperature_sum);
-    }
+    _publish_samples(0);
 }
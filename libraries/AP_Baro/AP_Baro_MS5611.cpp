@@ -37,6 +37,10 @@ extern const AP_HAL::HAL& hal;
 #define CMD_CONVERT_D1_OSR4096 0x48   // Maximum resolution (oversampling)
 #define CMD_CONVERT_D2_OSR4096 0x58   // Maximum resolution (oversampling)
 
+// an OSR4096 conversion takes up to 9.04ms, and a reading is timed at
+// the middle of its conversion
+#define MS5611_CONVERSION_MIDPOINT_US 4520
+
 // SPI Device //////////////////////////////////////////////////////////////////
 
 AP_SerialBus_SPI::AP_SerialBus_SPI(enum AP_HAL::SPIDevice device, enum AP_HAL::SPIDeviceDriver::bus_speed speed) :
@@ -97,6 +101,26 @@ void AP_SerialBus_SPI::sem_give()
     _spi_sem->give();
 }
 
+/*
+  read the ADC and start the next conversion in one batch, with the
+  device deselected between the two
+ */
+bool AP_SerialBus_SPI::queue_adc_read(uint8_t next_cmd, AP_HAL::MemberProc cb)
+{
+    memset(_queued_tx, 0, sizeof(_queued_tx));
+    _queued_tx[4] = next_cmd;
+    const AP_HAL::SPIDeviceDriver::Transfer transfers[2] = {
+        { tx : _queued_tx,     rx : _queued_rx, len : 4, cs_change : true },
+        { tx : &_queued_tx[4], rx : NULL,       len : 1, cs_change : false }
+    };
+    return _spi->queue_transfers(transfers, 2, cb);
+}
+
+uint32_t AP_SerialBus_SPI::queued_adc_value()
+{
+    return (((uint32_t)_queued_rx[1])<<16) | (((uint32_t)_queued_rx[2])<<8) | ((uint32_t)_queued_rx[3]);
+}
+
 
 /// I2C SerialBus
 AP_SerialBus_I2C::AP_SerialBus_I2C(uint8_t addr) :
@@ -157,9 +181,9 @@ void AP_SerialBus_I2C::sem_give()
 AP_Baro_MS5611::AP_Baro_MS5611(AP_Baro &baro, AP_SerialBus *serial, bool use_timer) :
     AP_Baro_Backend(baro),
     _serial(serial),
-    _updated(false),
     _state(0),
     _last_timer(0),
+    _queued_read_pending(false),
     _use_timer(use_timer)
 {
     _instance = _frontend.register_sensor();
@@ -189,10 +213,8 @@ AP_Baro_MS5611::AP_Baro_MS5611(AP_Baro &baro, AP_SerialBus *serial, bool use_tim
     _last_timer = hal.scheduler->micros();
     _state = 0;
 
-    _s_D1 = 0;
-    _s_D2 = 0;
-    _d1_count = 0;
-    _d2_count = 0;
+    D1 = 0;
+    D2 = 0;
 
     _serial->sem_give();
 
@@ -253,6 +275,12 @@ bool AP_Baro_MS5611::_check_crc(void)
   Read the sensor. This is a state machine
   We read one time Temperature (state=1) and then 4 times Pressure (states 2-5)
   temperature does not change so quickly...
+
+  Each pressure reading is compensated with the latest temperature
+  reading and queued for the frontend with the time it was taken.
+  On buses with a transfer queue the read and the next conversion
+  command are run by the bus thread, so the timer thread does not wait
+  for other devices on the bus
 */
 void AP_Baro_MS5611::_timer(void)
 {
@@ -261,54 +289,63 @@ void AP_Baro_MS5611::_timer(void)
         return;
     }
 
+    if (_queued_read_pending) {
+        return;
+    }
+    _queued_read_pending = true;
+    if (_serial->queue_adc_read(_next_command(), AP_HAL_MEMBERPROC(&AP_Baro_MS5611::_queued_read_done))) {
+        return;
+    }
+    _queued_read_pending = false;
+
     if (!_serial->sem_take_nonblocking()) {
         return;
     }
 
+    uint32_t value = _serial->read_24bits(0);
+    _serial->write(_next_command());
+    _process_adc(value);
+
+    _last_timer = hal.scheduler->micros();
+    _serial->sem_give();
+}
+
+/*
+  completion of a queued read, called from the bus thread
+ */
+void AP_Baro_MS5611::_queued_read_done(void)
+{
+    _process_adc(_serial->queued_adc_value());
+    _last_timer = hal.scheduler->micros();
+    _queued_read_pending = false;
+}
+
+/*
+  the conversion to start after reading the current state
+ */
+uint8_t AP_Baro_MS5611::_next_command(void) const
+{
+    return _state == 4 ? CMD_CONVERT_D2_OSR4096 : CMD_CONVERT_D1_OSR4096;
+}
+
+/*
+  handle the result of the conversion for the current state and move
+  to the next
+ */
+void AP_Baro_MS5611::_process_adc(uint32_t value)
+{
     if (_state == 0) {
         // On state 0 we read temp
-        uint32_t d2 = _serial->read_24bits(0);
-        if (d2 != 0) {
-            _s_D2 += d2;
-            _d2_count++;
-            if (_d2_count == 32) {
-                // we have summed 32 values. This only happens
-                // when we stop reading the barometer for a long time
-                // (more than 1.2 seconds)
-                _s_D2 >>= 1;
-                _d2_count = 16;
-            }
-        }
-        _state++;
-        _serial->write(CMD_CONVERT_D1_OSR4096);      // Command to read pressure
-    } else {
-        uint32_t d1 = _serial->read_24bits(0);;
-        if (d1 != 0) {
-            // occasional zero values have been seen on the PXF
-            // board. These may be SPI errors, but safest to ignore
-            _s_D1 += d1;
-            _d1_count++;
-            if (_d1_count == 128) {
-                // we have summed 128 values. This only happens
-                // when we stop reading the barometer for a long time
-                // (more than 1.2 seconds)
-                _s_D1 >>= 1;
-                _d1_count = 64;
-            }
-            // Now a new reading exists
-            _updated = true;
-        }
-        _state++;
-        if (_state == 5) {
-            _serial->write(CMD_CONVERT_D2_OSR4096); // Command to read temperature
-            _state = 0;
-        } else {
-            _serial->write(CMD_CONVERT_D1_OSR4096); // Command to read pressure
+        if (value != 0) {
+            D2 = value;
         }
+    } else if (value != 0 && !is_zero(D2)) {
+        // occasional zero values have been seen on the PXF
+        // board. These may be SPI errors, but safest to ignore
+        D1 = value;
+        _calculate(_last_timer + MS5611_CONVERSION_MIDPOINT_US);
     }
-
-    _last_timer = hal.scheduler->micros();
-    _serial->sem_give();
+    _state = (_state + 1) % 5;
 }
 
 void AP_Baro_MS5611::update()
@@ -319,33 +356,11 @@ void AP_Baro_MS5611::update()
         accumulate();
     }
 
-    if (!_updated) {
-        return;
-    }
-    uint32_t sD1, sD2;
-    uint8_t d1count, d2count;
-
-    // Suspend timer procs because these variables are written to
-    // in "_update".
-    hal.scheduler->suspend_timer_procs();
-    sD1 = _s_D1; _s_D1 = 0;
-    sD2 = _s_D2; _s_D2 = 0;
-    d1count = _d1_count; _d1_count = 0;
-    d2count = _d2_count; _d2_count = 0;
-    _updated = false;
-    hal.scheduler->resume_timer_procs();
-    
-    if (d1count != 0) {
-        D1 = ((float)sD1) / d1count;
-    }
-    if (d2count != 0) {
-        D2 = ((float)sD2) / d2count;
-    }
-    _calculate();
+    _publish_samples(_instance);
 }
 
 // Calculate Temperature and compensated Pressure in real units (Celsius degrees*100, mbar*100).
-void AP_Baro_MS5611::_calculate()
+void AP_Baro_MS5611::_calculate(uint32_t time_us)
 {
     float dT;
     float TEMP;
@@ -356,9 +371,7 @@ void AP_Baro_MS5611::_calculate()
     // sub -20c temperature compensation is not included
 
     // we do the calculations using floating point
-    // as this is much faster on an AVR2560, and also allows
-    // us to take advantage of the averaging of D1 and D1 over
-    // multiple samples, giving us more precision
+    // as this is much faster on an AVR2560
     dT = D2-(((uint32_t)C5)<<8);
     TEMP = (dT * C6)/8388608;
     OFF = C2 * 65536.0f + (C4 * dT) / 128;
@@ -377,7 +390,7 @@ void AP_Baro_MS5611::_calculate()
 
     float pressure = (D1*SENS/2097152 - OFF)/32768;
     float temperature = (TEMP + 2000) * 0.01f;
-    _copy_to_frontend(_instance, pressure, temperature);
+    _push_sample(_instance, pressure, temperature, time_us);
 }
 
 /*
@@ -32,6 +32,14 @@ public:
 
     /** Release the internal semaphore for this device. */
     virtual void sem_give() = 0;
+
+    /** Queue a read of the ADC followed by the command next_cmd, calling
+     * cb from the bus thread when done. Returns false if the bus has no
+     * transfer queue, in which case the blocking calls must be used */
+    virtual bool queue_adc_read(uint8_t next_cmd, AP_HAL::MemberProc cb) { return false; }
+
+    /** The value from the last queued ADC read */
+    virtual uint32_t queued_adc_value() { return 0; }
 };
 
 /** SPI serial device. */
@@ -47,12 +55,18 @@ public:
     bool sem_take_nonblocking();
     bool sem_take_blocking();
     void sem_give();
+    bool queue_adc_read(uint8_t next_cmd, AP_HAL::MemberProc cb);
+    uint32_t queued_adc_value();
 
 private:
     enum AP_HAL::SPIDevice _device;
     enum AP_HAL::SPIDeviceDriver::bus_speed _speed;
     AP_HAL::SPIDeviceDriver *_spi;
     AP_HAL::Semaphore *_spi_sem;
+
+    // buffers for queued transfers, in use until the callback
+    uint8_t _queued_tx[5];
+    uint8_t _queued_rx[4];
 };
 
 /** I2C serial device. */
@@ -84,24 +98,24 @@ private:
     AP_SerialBus *_serial;
     uint8_t _instance;
 
-    void _calculate();
+    void _calculate(uint32_t time_us);
     bool _check_crc();
 
     void _timer();
+    void _queued_read_done();
+    uint8_t _next_command() const;
+    void _process_adc(uint32_t value);
 
     /* Asynchronous state: */
-    volatile bool            _updated;
-    volatile uint8_t         _d1_count;
-    volatile uint8_t         _d2_count;
-    volatile uint32_t        _s_D1, _s_D2;
     uint8_t                  _state;
-    uint32_t                 _last_timer;
+    volatile uint32_t        _last_timer;
+    volatile bool            _queued_read_pending;
 
     bool _use_timer;
 
     // Internal calibration registers
     uint16_t                 C1,C2,C3,C4,C5,C6;
-    float                    D1,D2;
+    float                    D1,D2;         // latest readings, owned by _timer() or the bus thread
 };
 
 #endif //  __AP_BARO_MS5611_H__
@@ -54,23 +54,12 @@ void AP_Baro_PX4::update(void)
         struct px4_instance &instance = instances[i];
         while (::read(instance.fd, &baro_report, sizeof(baro_report)) == sizeof(baro_report) &&
                baro_report.timestamp != instance.last_timestamp) {
-            instance.pressure_sum += baro_report.pressure; // Pressure in mbar
-            instance.temperature_sum += baro_report.temperature; // degrees celcius
-            instance.sum_count++;
+            // pressure in mbar, temperature in degrees celcius
+            _push_sample(instance.instance, baro_report.pressure * 100, baro_report.temperature,
+                         (uint32_t)baro_report.timestamp);
             instance.last_timestamp = baro_report.timestamp;
         }
-    }
-
-    for (uint8_t i=0; i<_num_instances; i++) {
-        struct px4_instance &instance = instances[i];
-        if (instance.sum_count > 0) {
-            float pressure = (instance.pressure_sum / instance.sum_count) * 100;
-            float temperature = instance.temperature_sum / instance.sum_count;
-            instance.pressure_sum = 0;
-            instance.temperature_sum = 0;
-            instance.sum_count = 0;
-            _copy_to_frontend(instance.instance, pressure, temperature);
-        }
+        _publish_samples(instance.instance);
     }
 }
 
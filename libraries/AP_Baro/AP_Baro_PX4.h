@@ -17,9 +17,6 @@ private:
     struct px4_instance {
         uint8_t instance;
         int fd;
-        float pressure_sum;
-        float temperature_sum;
-        uint32_t sum_count;
         uint64_t last_timestamp;
     } instances[BARO_MAX_INSTANCES];
 };
@@ -219,7 +219,9 @@ void AP_Compass_AK8963_MPU9250::_backend_reset()
 
 bool AP_Compass_AK8963_MPU9250::_backend_init()
 {
-    _backend->write(MPUREG_USER_CTRL, BIT_USER_CTRL_I2C_MST_EN);    /* I2C Master mode */
+    /* I2C Master mode, keeping the other bits as the IMU driver may be using the FIFO */
+    uint8_t user_ctrl = _backend->read(MPUREG_USER_CTRL);
+    _backend->write(MPUREG_USER_CTRL, user_ctrl | BIT_USER_CTRL_I2C_MST_EN);
     _backend->write(MPUREG_I2C_MST_CTRL, I2C_MST_CLOCK_400KHZ);    /*  I2C configuration multi-master  IIC 400KHz */
 
     return true;
@@ -304,9 +306,7 @@ AP_Compass_AK8963::AP_Compass_AK8963(Compass &compass) :
     _last_accum_time(0)
 {
     _initialised = false;
-    _mag_x_accum =_mag_y_accum = _mag_z_accum = 0;
     _mag_x =_mag_y = _mag_z = 0;
-    _accum_count = 0;
     _magnetometer_adc_resolution = AK8963_16BIT_ADC;
 }
 
@@ -503,23 +503,7 @@ void AP_Compass_AK8963::read()
         return;
     }
 
-    if (_accum_count == 0) {
-        /* We're not ready to publish*/
-        return;
-    }
-
-    /* Update */
-    Vector3f field(_mag_x_accum * magnetometer_ASA[0],
-                   _mag_y_accum * magnetometer_ASA[1],
-                   _mag_z_accum * magnetometer_ASA[2]);
-
-    field /= _accum_count;
-    _mag_x_accum = _mag_y_accum = _mag_z_accum = 0;
-    _accum_count = 0;
-
-    rotate_field(field, _compass_instance);
-    correct_field(field, _compass_instance);
-    publish_filtered_field(field, _compass_instance);
+    publish_samples(_compass_instance);
 }
 
 void AP_Compass_AK8963::_start_conversion()
@@ -529,7 +513,6 @@ void AP_Compass_AK8963::_start_conversion()
     static const uint8_t count = 0x09;
 
     _backend_init();
-    _backend->write(MPUREG_USER_CTRL, BIT_USER_CTRL_I2C_MST_EN);    /* I2C Master mode */
     _backend->write(MPUREG_I2C_SLV0_ADDR, AK8963_I2C_ADDR | READ_FLAG);  /* Set the I2C slave addres of AK8963 and set for read. */
     _backend->write(MPUREG_I2C_SLV0_REG, address); /* I2C slave 0 register address from where to begin data transfer */
     _backend->write(MPUREG_I2C_SLV0_CTRL, I2C_SLV0_EN | count); /* Enable I2C and set @count byte */
@@ -544,15 +527,10 @@ void AP_Compass_AK8963::_collect_samples()
     if (!read_raw()) {
         error("read_raw failed\n");
     } else {
-        _mag_x_accum += _mag_x;
-        _mag_y_accum += _mag_y;
-        _mag_z_accum += _mag_z;
-        _accum_count++;
-        if (_accum_count == 10) {
-             _mag_x_accum /= 2;
-             _mag_y_accum /= 2;
-             _mag_z_accum /= 2;
-             _accum_count = 5;
-        }
+        Vector3f field(_mag_x * magnetometer_ASA[0],
+                       _mag_y * magnetometer_ASA[1],
+                       _mag_z * magnetometer_ASA[2]);
+        rotate_field(field, _compass_instance);
+        push_sample(field, hal.scheduler->micros(), _compass_instance);
     }
 }
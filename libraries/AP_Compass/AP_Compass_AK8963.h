@@ -73,11 +73,6 @@ private:
     void                _start_conversion();
     void                _collect_samples();
 
-    float               _mag_x_accum;
-    float               _mag_y_accum;
-    float               _mag_z_accum;
-    uint32_t            _accum_count;
-
     bool                _initialised;
     state_t             _state;
     uint8_t             _magnetometer_adc_resolution;
@@ -21,6 +21,10 @@ AP_Compass_Backend::AP_Compass_Backend(Compass &compass) :
  * 4. publish_unfiltered_field - this (optionally) provides a corrected
  *      point sample for fusion into the EKF
  * 5. publish_filtered_field - legacy filtered magnetic field
+ *
+ * Backends normally only call rotate_field and then push_sample,
+ * which may be done from a timer. publish_samples then runs steps
+ * 2 to 5 on each queued sample from the backend's read()
  */
 
 void AP_Compass_Backend::rotate_field(Vector3f &mag, uint8_t instance)
@@ -37,6 +41,60 @@ void AP_Compass_Backend::rotate_field(Vector3f &mag, uint8_t instance)
     }
 }
 
+/*
+  queue a rotated, uncorrected sample taken at time_us. This is lock
+  free, so it is safe to call from a timer process. Returns false if
+  the queue is full because the backend has not been read for too long
+ */
+bool AP_Compass_Backend::push_sample(const Vector3f &mag, uint32_t time_us, uint8_t instance)
+{
+    Compass::mag_sample sample;
+    sample.field = mag;
+    sample.time_us = time_us;
+    return _compass._state[instance].samples.push(sample);
+}
+
+/*
+  pass each queued sample to the calibrator and the EKF point sample
+  interface, then publish their average as the filtered field, stamped
+  with the mean time the samples were taken. Returns false if there
+  were no new samples
+ */
+bool AP_Compass_Backend::publish_samples(uint8_t instance)
+{
+    Compass::mag_state &state = _compass._state[instance];
+    Compass::mag_sample sample;
+    Vector3f sum;
+    uint32_t first_us = 0;
+    uint32_t offset_sum_us = 0;
+    uint8_t count = 0;
+
+    while (state.samples.pop(sample)) {
+        publish_raw_field(sample.field, sample.time_us, instance);
+        correct_field(sample.field, instance);
+        publish_unfiltered_field(sample.field, sample.time_us, instance);
+
+        // sum time offsets rather than times to avoid overflow
+        if (count == 0) {
+            first_us = sample.time_us;
+        }
+        offset_sum_us += sample.time_us - first_us;
+        sum += sample.field;
+        count++;
+    }
+    if (count == 0) {
+        return false;
+    }
+
+    // convert to a millis() time using the age of the samples, which
+    // stays correct when micros() wraps
+    uint32_t age_us = hal.scheduler->micros() - (first_us + offset_sum_us / count);
+    state.sample_time_ms = hal.scheduler->millis() - age_us / 1000;
+
+    publish_filtered_field(sum / count, instance);
+    return true;
+}
+
 void AP_Compass_Backend::publish_raw_field(const Vector3f &mag, uint32_t time_us, uint8_t instance)
 {
     Compass::mag_state &state = _compass._state[instance];
@@ -56,9 +56,15 @@ protected:
      * 4. publish_unfiltered_field - this (optionally) provides a corrected
      *      point sample for fusion into the EKF
      * 5. publish_filtered_field - legacy filtered magnetic field
+     *
+     * Backends normally only call rotate_field and then push_sample,
+     * which may be done from a timer. publish_samples then runs steps
+     * 2 to 5 on each queued sample from the backend's read()
      */
 
     void rotate_field(Vector3f &mag, uint8_t instance);
+    bool push_sample(const Vector3f &mag, uint32_t time_us, uint8_t instance);
+    bool publish_samples(uint8_t instance);
     void publish_raw_field(const Vector3f &mag, uint32_t time_us, uint8_t instance);
     void correct_field(Vector3f &mag, uint8_t i);
     void publish_unfiltered_field(const Vector3f &mag, uint32_t time_us, uint8_t instance);
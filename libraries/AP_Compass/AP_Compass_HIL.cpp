@@ -60,14 +60,7 @@ void AP_Compass_HIL::read()
     // try to accumulate one more sample, so we have the latest data
     accumulate();
 
-    if (_count == 0) return;
-
-    _sum /= _count;
-
-    publish_filtered_field(_sum, _compass_instance);
-
-    _sum.zero();
-    _count = 0;
+    publish_samples(_compass_instance);
 }
 
 void AP_Compass_HIL::accumulate(void)
@@ -82,17 +75,7 @@ void AP_Compass_HIL::accumulate(void)
     // rotate raw_field from sensor frame to body frame
     rotate_field(raw_field, _compass_instance);
 
-    // publish raw_field (uncorrected point sample) for calibration use
-    publish_raw_field(raw_field, time_us, _compass_instance);
-
-    // correct raw_field for known errors
-    correct_field(raw_field, _compass_instance);
-
-    // publish raw_field (corrected point sample) for EKF use
-    publish_unfiltered_field(raw_field, time_us, _compass_instance);
-
-    // accumulate into averaging filter
-    _sum += raw_field;
-    _count++;
+    // queue for correction and publishing in read()
+    push_sample(raw_field, time_us, _compass_instance);
   }
 }
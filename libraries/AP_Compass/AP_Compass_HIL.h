@@ -17,8 +17,6 @@ public:
 
 private:
 	uint8_t     _compass_instance;
-	Vector3f _sum;
-    uint32_t _count;
 };
 
 #endif
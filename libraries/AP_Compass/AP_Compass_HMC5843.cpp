@@ -65,9 +65,6 @@ AP_Compass_HMC5843::AP_Compass_HMC5843(Compass &compass):
     _mag_x(0),
     _mag_y(0),
     _mag_z(0),
-    _mag_x_accum(0),
-    _mag_y_accum(0),
-    _mag_z_accum(0),
     _accum_count(0),
     _last_accum_time(0),
     _compass_instance(0),
@@ -165,22 +162,22 @@ void AP_Compass_HMC5843::accumulate(void)
    _i2c_sem->give();
 
    if (result) {
-	  // the _mag_N values are in the range -2048 to 2047, so we can
-	  // accumulate up to 15 of them in an int16_t. Let's make it 14
-	  // for ease of calculation. We expect to do reads at 10Hz, and
-	  // we get new data at most 75Hz, so we don't expect to
-	  // accumulate more than 8 before a read
-	  _mag_x_accum += _mag_x;
-	  _mag_y_accum += _mag_y;
-	  _mag_z_accum += _mag_z;
-	  _accum_count++;
-	  if (_accum_count == 14) {
-		 _mag_x_accum /= 2;
-		 _mag_y_accum /= 2;
-		 _mag_z_accum /= 2;
-		 _accum_count = 7;
-	  }
-	  _last_accum_time = tnow;
+      // queue each reading with its own time, rather than summing
+      // them into accumulators that can saturate
+      Vector3f field(_mag_x * calibration[0],
+                     _mag_y * calibration[1],
+                     _mag_z * calibration[2]);
+
+      // rotate to the desired orientation
+      if (_product_id == AP_COMPASS_TYPE_HMC5883L) {
+          field.rotate(ROTATION_YAW_90);
+      }
+      rotate_field(field, _compass_instance);
+
+      if (push_sample(field, tnow, _compass_instance)) {
+          _accum_count++;
+      }
+      _last_accum_time = tnow;
    }
 }
 
@@ -381,22 +378,7 @@ void AP_Compass_HMC5843::read()
 	   }
 	}
 
-    Vector3f field(_mag_x_accum * calibration[0],
-                   _mag_y_accum * calibration[1],
-                   _mag_z_accum * calibration[2]);
-    field /= _accum_count;
-
 	_accum_count = 0;
-	_mag_x_accum = _mag_y_accum = _mag_z_accum = 0;
-
-    // rotate to the desired orientation
-    if (_product_id == AP_COMPASS_TYPE_HMC5883L) {
-        field.rotate(ROTATION_YAW_90);
-    }
-
-
-    rotate_field(field, _compass_instance);
-    correct_field(field, _compass_instance);
-    publish_filtered_field(field, _compass_instance);
+    publish_samples(_compass_instance);
     _retry_time = 0;
 }
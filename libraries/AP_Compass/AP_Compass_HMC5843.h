@@ -25,10 +25,7 @@ private:
     int16_t			    _mag_x;
     int16_t			    _mag_y;
     int16_t			    _mag_z;
-    int16_t             _mag_x_accum;
-    int16_t             _mag_y_accum;
-    int16_t             _mag_z_accum;
-    uint8_t			    _accum_count;
+    uint8_t			    _accum_count;       // samples queued since the last read
     uint32_t            _last_accum_time;
 
     uint8_t             _compass_instance;
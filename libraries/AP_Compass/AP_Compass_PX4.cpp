@@ -93,14 +93,12 @@ bool AP_Compass_PX4::init(void)
 
         // remember if the compass is external
         set_external(_instance[i], ioctl(_mag_fd[i], MAGIOCGEXTERNAL, 0) > 0);
-        _count[i] = 0;
-        _sum[i].zero();
     }
 
     // give the driver a chance to run, and gather one sample
     hal.scheduler->delay(40);
     accumulate();
-    if (_count[0] == 0) {
+    if (!publish_samples(_instance[0])) {
         hal.console->printf("Failed initial compass accumulate\n");        
     }
 
@@ -113,16 +111,7 @@ void AP_Compass_PX4::read(void)
     accumulate();
 
     for (uint8_t i=0; i<_num_sensors; i++) {
-        uint8_t frontend_instance = _instance[i];
-        // avoid division by zero if we haven't received any mag reports
-        if (_count[i] == 0) continue;
-
-        _sum[i] /= _count[i];
-
-        publish_filtered_field(_sum[i], frontend_instance);
-    
-        _sum[i].zero();
-        _count[i] = 0;
+        publish_samples(_instance[i]);
     }
 }
 
@@ -141,18 +130,8 @@ void AP_Compass_PX4::accumulate(void)
             // rotate raw_field from sensor frame to body frame
             rotate_field(raw_field, frontend_instance);
 
-            // publish raw_field (uncorrected point sample) for calibration use
-            publish_raw_field(raw_field, time_us, frontend_instance);
-
-            // correct raw_field for known errors
-            correct_field(raw_field, frontend_instance);
-
-            // publish raw_field (corrected point sample) for EKF use
-            publish_unfiltered_field(raw_field, time_us, frontend_instance);
-
-            // accumulate into averaging filter
-            _sum[i] += raw_field;
-            _count[i]++;
+            // queue for correction and publishing in read()
+            push_sample(raw_field, time_us, frontend_instance);
 
             _last_timestamp[i] = mag_report.timestamp;
         }
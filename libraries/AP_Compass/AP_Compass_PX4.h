@@ -22,8 +22,6 @@ private:
     
     uint8_t  _instance[COMPASS_MAX_INSTANCES];
     int      _mag_fd[COMPASS_MAX_INSTANCES];
-    Vector3f _sum[COMPASS_MAX_INSTANCES];
-    uint32_t _count[COMPASS_MAX_INSTANCES];
     uint64_t _last_timestamp[COMPASS_MAX_INSTANCES];
 };
 
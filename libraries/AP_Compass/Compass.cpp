@@ -45,8 +45,8 @@ const AP_Param::GroupInfo Compass::var_info[] PROGMEM = {
 
     // @Param: LEARN
     // @DisplayName: Learn compass offsets automatically
-    // @Description: Enable or disable the automatic learning of compass offsets
-    // @Values: 0:Disabled,1:Enabled
+    // @Description: Enable or disable the automatic learning of compass offsets. InFlight learns the offsets and the motor interference from the field expected by the EKF. InFlight is only supported by Copter, other vehicles use Enabled instead
+    // @Values: 0:Disabled,1:Enabled,2:InFlight
     // @User: Advanced
     AP_GROUPINFO("LEARN",  3, Compass, _learn, COMPASS_LEARN_DEFAULT),
 
@@ -387,6 +387,9 @@ Compass::Compass(void) :
     for (uint8_t i=0; i<COMPASS_MAX_BACKEND; i++) {
         _backends[i] = NULL;
     }    
+    for (uint8_t i=0; i<COMPASS_MAX_INSTANCES; i++) {
+        _learn_state[i] = learn_state();
+    }
 
 #if COMPASS_MAX_INSTANCES > 1
     // default device ids to zero.  init() method will overwrite with the actual device ids
@@ -12,6 +12,7 @@
 #include "CompassCalibrator.h"
 #include "AP_Compass_Backend.h"
 #include <AP_Buffer.h>
+#include "../AP_HAL/utility/RingBuffer.h"
 
 // compass product id
 #define AP_COMPASS_TYPE_UNKNOWN         0x00
@@ -27,6 +28,11 @@
 #define AP_COMPASS_MOT_COMP_THROTTLE    0x01
 #define AP_COMPASS_MOT_COMP_CURRENT     0x02
 
+// offset learning types (for use with _learn)
+#define COMPASS_LEARN_NONE              0
+#define COMPASS_LEARN_INTERNAL          1
+#define COMPASS_LEARN_INFLIGHT          2
+
 // setup default mag orientation for some board types
 #if CONFIG_HAL_BOARD == HAL_BOARD_APM1
 # define MAG_BOARD_ORIENTATION ROTATION_ROLL_180
@@ -46,6 +52,16 @@
 #define COMPASS_MAX_BACKEND   1   
 #endif
 
+/**
+   number of timestamped samples queued per instance between reads. This
+   covers the fastest sensor between two 10Hz reads
+ */
+#if HAL_CPU_CLASS >= HAL_CPU_CLASS_75
+#define COMPASS_SAMPLE_QUEUE_SIZE 24
+#else
+#define COMPASS_SAMPLE_QUEUE_SIZE 10
+#endif
+
 #define AP_COMPASS_MAX_XYZ_ANG_DIFF radians(50.0f)
 #define AP_COMPASS_MAX_XY_ANG_DIFF radians(30.0f)
 #define AP_COMPASS_MAX_XY_LENGTH_DIFF 100.0f
@@ -132,6 +148,11 @@ public:
     const Vector3f &get_unfiltered_field(uint8_t i) const { return _state[i].unfiltered_field; }
     const Vector3f &get_unfiltered_field(void) const { return get_unfiltered_field(get_primary()); }
 
+    // millis() time at which the samples averaged into get_field() were
+    // taken, which can be well before the read that published them
+    uint32_t last_sample_time_ms(uint8_t i) const { return _state[i].sample_time_ms; }
+    uint32_t last_sample_time_ms(void) const { return last_sample_time_ms(get_primary()); }
+
     // compass calibrator interface
     void compass_cal_update();
 
@@ -194,6 +215,25 @@ public:
     ///
     void learn_offsets(void);
 
+    /// Learn offsets and the motor interference vector in flight from
+    /// the field the navigation filter expects. Each compass is
+    /// compared with the expected field when it has a new reading, and
+    /// the fit over a window of readings is applied if it is consistent
+    ///
+    /// @param  expected_field      body frame field expected at the vehicle's attitude
+    /// @param  ekf_mag_bias        body frame field bias of the primary compass estimated by the EKF
+    ///
+    void learn_inflight(const Vector3f &expected_field, const Vector3f &ekf_mag_bias);
+
+    /// Discard the readings collected by learn_inflight() since its
+    /// last update, for example when the vehicle lands
+    ///
+    void learn_inflight_reset(void);
+
+    /// return true if in-flight learning is selected and supported by
+    /// this vehicle
+    bool learn_inflight_enabled() const;
+
     /// return true if the compass should be used for yaw calculations
     bool use_for_yaw(uint8_t i) const;
     bool use_for_yaw(void) const;
@@ -346,6 +386,12 @@ private:
     // throttle expressed as a percentage from 0 ~ 1.0 or current expressed in amps
     float       _thr_or_curr;
 
+    // a body frame, uncorrected sample queued by a backend
+    struct mag_sample {
+        Vector3f    field;
+        uint32_t    time_us;
+    };
+
     struct mag_state {
         AP_Int8     external;
         bool        healthy;
@@ -384,10 +430,31 @@ private:
         bool        updated_unfiltered_field;
         Vector3f    raw_field;
         Vector3f    unfiltered_field;
+
+        // samples pushed by the backend since the last read
+        ObjectBuffer<mag_sample, COMPASS_SAMPLE_QUEUE_SIZE> samples;
+
+        // when the samples averaged into field were taken
+        uint32_t    sample_time_ms;
     } _state[COMPASS_MAX_INSTANCES];
 
     CompassCalibrator _calibrator[COMPASS_MAX_INSTANCES];
 
+    // sums of the differences r between the expected and corrected
+    // fields, and of the throttle or current x, over a learning window
+    struct learn_state {
+        uint16_t    count;
+        float       sum_x;
+        float       sum_x_sq;
+        Vector3f    sum_r;
+        Vector3f    sum_rx;
+        Vector3f    sum_r_sq;
+        Vector3f    sum_bias;
+        uint32_t    last_update_ms;
+    } _learn_state[COMPASS_MAX_INSTANCES];
+
+    void learn_inflight_update(uint8_t i);
+
     // if we want HIL only
     bool _hil_mode:1;
 };
@@ -57,6 +57,12 @@
  * The fitting algorithm used is Levenberg-Marquardt. See also:
  * http://en.wikipedia.org/wiki/Levenberg%E2%80%93Marquardt_algorithm
  *
+ * The sphere fit starts from a linear least squares sphere fit which is
+ * updated as each sample is accepted. Each iteration of the fit is spread
+ * over several calls to update(), processing at most
+ * COMPASS_CAL_SAMPLES_PER_UPDATE samples per call, so all compasses can be
+ * calibrated at once within the time of the scheduler task.
+ *
  * The sample acceptance distance is determined as follows:
  * Every point should be atleast separated by D distance:
  *
@@ -82,6 +88,12 @@
 
 extern const AP_HAL::HAL& hal;
 
+// damping factor between the two steps tried in each fit iteration
+static const float lma_damping = 10.0f;
+
+// scaling of samples in the seed fit
+static const float seed_scale = 1.0e-3f;
+
 ////////////////////////////////////////////////////////////
 ///////////////////// PUBLIC INTERFACE /////////////////////
 ////////////////////////////////////////////////////////////
@@ -158,6 +170,9 @@ void CompassCalibrator::new_sample(const Vector3f& sample) {
     if(running() && _samples_collected < COMPASS_CAL_NUM_SAMPLES && accept_sample(sample)) {
         _sample_buffer[_samples_collected].set(sample);
         _samples_collected++;
+        if(_status == COMPASS_CAL_RUNNING_STEP_ONE) {
+            add_seed_sample(sample);
+        }
     }
 }
 
@@ -170,14 +185,19 @@ void CompassCalibrator::update(bool &failure) {
 
     if(_status == COMPASS_CAL_RUNNING_STEP_ONE) {
         if (_fit_step >= 10) {
-            if(_fitness == _initial_fitness || isnan(_fitness)) {           //if true, means that fitness is diverging instead of converging
+            //if true, means that fitness is diverging instead of converging
+            if((_fitness == _initial_fitness && _fitness > sq(_tolerance)) || isnan(_fitness)) {
                 set_status(COMPASS_CAL_FAILED);
                 failure = true;
             }
             set_status(COMPASS_CAL_RUNNING_STEP_TWO);
         } else {
-            run_sphere_fit();
-            _fit_step++;
+            if (_fit_step == 0 && _fit_sample == 0 && !_fit_evaluating) {
+                seed_sphere_fit();
+            }
+            if (run_fit_chunk(false)) {
+                _fit_step++;
+            }
         }
     } else if(_status == COMPASS_CAL_RUNNING_STEP_TWO) {
         if (_fit_step >= 35) {
@@ -188,11 +208,13 @@ void CompassCalibrator::update(bool &failure) {
                 failure = true;
             }
         } else if (_fit_step < 15) {
-            run_sphere_fit();
-            _fit_step++;
+            if (run_fit_chunk(false)) {
+                _fit_step++;
+            }
         } else {
-            run_ellipsoid_fit();
-            _fit_step++;
+            if (run_fit_chunk(true)) {
+                _fit_step++;
+            }
         }
     }
 }
@@ -209,16 +231,14 @@ bool CompassCalibrator::fitting() const {
 }
 
 void CompassCalibrator::initialize_fit() {
-    //initialize _fitness before starting a fit
-    if (_samples_collected != 0) {
-        _fitness = calc_mean_squared_residuals(_params);
-    } else {
-        _fitness = 1.0e30f;
-    }
+    //_fitness is found by the first iteration of the fit
+    _fitness = 1.0e30f;
     _ellipsoid_lambda = 1.0f;
     _sphere_lambda = 1.0f;
     _initial_fitness = _fitness;
     _fit_step = 0;
+    _fit_sample = 0;
+    _fit_evaluating = false;
 }
 
 void CompassCalibrator::reset_state() {
@@ -228,6 +248,7 @@ void CompassCalibrator::reset_state() {
     _params.offset.zero();
     _params.diag = Vector3f(1.0f,1.0f,1.0f);
     _params.offdiag.zero();
+    _sphere_seed.reset();
 
     initialize_fit();
 }
@@ -400,26 +421,6 @@ float CompassCalibrator::calc_residual(const Vector3f& sample, const param_t& pa
     return params.radius - (softiron*(sample+params.offset)).length();
 }
 
-float CompassCalibrator::calc_mean_squared_residuals() const
-{
-    return calc_mean_squared_residuals(_params);
-}
-
-float CompassCalibrator::calc_mean_squared_residuals(const param_t& params) const
-{
-    if(_sample_buffer == NULL || _samples_collected == 0) {
-        return 1.0e30f;
-    }
-    float sum = 0.0f;
-    for(uint16_t i=0; i < _samples_collected; i++){
-        Vector3f sample = _sample_buffer[i].get();
-        float resid = calc_residual(sample, params);
-        sum += sq(resid);
-    }
-    sum /= _samples_collected;
-    return sum;
-}
-
 void CompassCalibrator::calc_sphere_jacob(const Vector3f& sample, const param_t& params, float* ret) const{
     const Vector3f &offset = params.offset;
     const Vector3f &diag = params.diag;
@@ -443,90 +444,6 @@ void CompassCalibrator::calc_sphere_jacob(const Vector3f& sample, const param_t&
     ret[3] = -1.0f * (((offdiag.y * A) + (offdiag.z * B) + (diag.z    * C))/length);
 }
 
-void CompassCalibrator::run_sphere_fit()
-{
-    if(_sample_buffer == NULL) {
-        return;
-    }
-
-    const float lma_damping = 10.0f;
-
-    float fitness = _fitness;
-    float fit1, fit2;
-    param_t fit1_params, fit2_params;
-    fit1_params = fit2_params = _params;
-
-    float JTJ[COMPASS_CAL_NUM_SPHERE_PARAMS*COMPASS_CAL_NUM_SPHERE_PARAMS];
-    float JTJ2[COMPASS_CAL_NUM_SPHERE_PARAMS*COMPASS_CAL_NUM_SPHERE_PARAMS];
-    float JTFI[COMPASS_CAL_NUM_SPHERE_PARAMS];
-
-    memset(&JTJ,0,sizeof(JTJ));
-    memset(&JTJ2,0,sizeof(JTJ2));
-    memset(&JTFI,0,sizeof(JTFI));
-
-    for(uint16_t k = 0; k<_samples_collected; k++) {
-        Vector3f sample = _sample_buffer[k].get();
-
-        float sphere_jacob[COMPASS_CAL_NUM_SPHERE_PARAMS];
-
-        calc_sphere_jacob(sample, fit1_params, sphere_jacob);
-
-        for(uint8_t i = 0;i < COMPASS_CAL_NUM_SPHERE_PARAMS; i++) {
-            // compute JTJ
-            for(uint8_t j = 0; j < COMPASS_CAL_NUM_SPHERE_PARAMS; j++) {
-                JTJ[i*COMPASS_CAL_NUM_SPHERE_PARAMS+j] += sphere_jacob[i] * sphere_jacob[j];
-                JTJ2[i*COMPASS_CAL_NUM_SPHERE_PARAMS+j] += sphere_jacob[i] * sphere_jacob[j];   //a backup JTJ for LM
-            }
-            // compute JTFI
-            JTFI[i] += sphere_jacob[i] * calc_residual(sample, fit1_params);
-        }
-    }
-
-
-    //------------------------Levenberg-part-starts-here---------------------------------//
-    //refer: http://en.wikipedia.org/wiki/Levenberg%E2%80%93Marquardt_algorithm#Choice_of_damping_parameter
-    for(uint8_t i = 0; i < COMPASS_CAL_NUM_SPHERE_PARAMS; i++) {
-        JTJ[i*COMPASS_CAL_NUM_SPHERE_PARAMS+i] += _sphere_lambda;
-        JTJ2[i*COMPASS_CAL_NUM_SPHERE_PARAMS+i] += _sphere_lambda/lma_damping;
-    }
-
-    if(!inverse(JTJ, JTJ, 4)) {
-        return;
-    }
-
-    if(!inverse(JTJ2, JTJ2, 4)) {
-        return;
-    }
-
-    for(uint8_t row=0; row < COMPASS_CAL_NUM_SPHERE_PARAMS; row++) {
-        for(uint8_t col=0; col < COMPASS_CAL_NUM_SPHERE_PARAMS; col++) {
-            fit1_params.get_sphere_params()[row] -= JTFI[col] * JTJ[row*COMPASS_CAL_NUM_SPHERE_PARAMS+col];
-            fit2_params.get_sphere_params()[row] -= JTFI[col] * JTJ2[row*COMPASS_CAL_NUM_SPHERE_PARAMS+col];
-        }
-    }
-
-    fit1 = calc_mean_squared_residuals(fit1_params);
-    fit2 = calc_mean_squared_residuals(fit2_params);
-
-    if(fit1 > _fitness && fit2 > _fitness){
-        _sphere_lambda *= lma_damping;
-    } else if(fit2 < _fitness && fit2 < fit1) {
-        _sphere_lambda /= lma_damping;
-        fit1_params = fit2_params;
-        fitness = fit2;
-    } else if(fit1 < _fitness){
-        fitness = fit1;
-    }
-    //--------------------Levenberg-part-ends-here--------------------------------//
-
-    if(!isnan(fitness) && fitness < _fitness) {
-        _fitness = fitness;
-        _params = fit1_params;
-    }
-}
-
-
-
 void CompassCalibrator::calc_ellipsoid_jacob(const Vector3f& sample, const param_t& params, float* ret) const{
     const Vector3f &offset = params.offset;
     const Vector3f &diag = params.diag;
@@ -556,89 +473,155 @@ void CompassCalibrator::calc_ellipsoid_jacob(const Vector3f& sample, const param
     ret[8] = -1.0f * (((sample.z + offset.z) * B) + ((sample.y + offset.y) * C))/length;
 }
 
-void CompassCalibrator::run_ellipsoid_fit()
+bool CompassCalibrator::run_fit_chunk(bool ellipsoid)
 {
     if(_sample_buffer == NULL) {
-        return;
+        return true;
     }
 
-    const float lma_damping = 10.0f;
-
-
-    float fitness = _fitness;
-    float fit1, fit2;
-    param_t fit1_params, fit2_params;
-    fit1_params = fit2_params = _params;
-
-
-    float JTJ[COMPASS_CAL_NUM_ELLIPSOID_PARAMS*COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
-    float JTJ2[COMPASS_CAL_NUM_ELLIPSOID_PARAMS*COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
-    float JTFI[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
-
-    memset(&JTJ,0,sizeof(JTJ));
-    memset(&JTJ2,0,sizeof(JTJ2));
-    memset(&JTFI,0,sizeof(JTFI));
-
-    for(uint16_t k = 0; k<_samples_collected; k++) {
-        Vector3f sample = _sample_buffer[k].get();
+    uint16_t end = min(_fit_sample + COMPASS_CAL_SAMPLES_PER_UPDATE, _samples_collected);
 
-        float ellipsoid_jacob[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
-
-        calc_ellipsoid_jacob(sample, fit1_params, ellipsoid_jacob);
-
-        for(uint8_t i = 0;i < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; i++) {
-            // compute JTJ
-            for(uint8_t j = 0; j < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; j++) {
-                JTJ [i*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+j] += ellipsoid_jacob[i] * ellipsoid_jacob[j];
-                JTJ2[i*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+j] += ellipsoid_jacob[i] * ellipsoid_jacob[j];
+    if(!_fit_evaluating) {
+        // accumulate the normal equations at the current parameters
+        if(_fit_sample == 0) {
+            _sphere_solver.reset();
+            _ellipsoid_solver.reset();
+        }
+        for(uint16_t k = _fit_sample; k < end; k++) {
+            Vector3f sample = _sample_buffer[k].get();
+            float resid = calc_residual(sample, _params);
+
+            if(ellipsoid) {
+                float ellipsoid_jacob[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+                calc_ellipsoid_jacob(sample, _params, ellipsoid_jacob);
+                _ellipsoid_solver.add_sample(ellipsoid_jacob, resid);
+            } else {
+                float sphere_jacob[COMPASS_CAL_NUM_SPHERE_PARAMS];
+                calc_sphere_jacob(sample, _params, sphere_jacob);
+                _sphere_solver.add_sample(sphere_jacob, resid);
             }
-            // compute JTFI
-            JTFI[i] += ellipsoid_jacob[i] * calc_residual(sample, fit1_params);
         }
-    }
-
+        _fit_sample = end;
+        if(_fit_sample < _samples_collected) {
+            return false;
+        }
+        _fit_sample = 0;
+
+        //------------------------Levenberg-part-starts-here---------------------------------//
+        //refer: http://en.wikipedia.org/wiki/Levenberg%E2%80%93Marquardt_algorithm#Choice_of_damping_parameter
+        float delta1[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+        float delta2[COMPASS_CAL_NUM_ELLIPSOID_PARAMS];
+        float *fit1_array, *fit2_array;
+        uint8_t num_params;
+
+        _fit1_params = _fit2_params = _params;
+        if(ellipsoid) {
+            if(!_ellipsoid_solver.solve(_ellipsoid_lambda, delta1) ||
+               !_ellipsoid_solver.solve(_ellipsoid_lambda/lma_damping, delta2)) {
+                return true;
+            }
+            fit1_array = _fit1_params.get_ellipsoid_params();
+            fit2_array = _fit2_params.get_ellipsoid_params();
+            num_params = COMPASS_CAL_NUM_ELLIPSOID_PARAMS;
+        } else {
+            if(!_sphere_solver.solve(_sphere_lambda, delta1) ||
+               !_sphere_solver.solve(_sphere_lambda/lma_damping, delta2)) {
+                return true;
+            }
+            fit1_array = _fit1_params.get_sphere_params();
+            fit2_array = _fit2_params.get_sphere_params();
+            num_params = COMPASS_CAL_NUM_SPHERE_PARAMS;
+        }
 
+        for(uint8_t i=0; i < num_params; i++) {
+            fit1_array[i] -= delta1[i];
+            fit2_array[i] -= delta2[i];
+        }
 
-    //------------------------Levenberg-part-starts-here---------------------------------//
-    //refer: http://en.wikipedia.org/wiki/Levenberg%E2%80%93Marquardt_algorithm#Choice_of_damping_parameter
-    for(uint8_t i = 0; i < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; i++) {
-        JTJ[i*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+i] += _ellipsoid_lambda;
-        JTJ2[i*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+i] += _ellipsoid_lambda/lma_damping;
+        memset(_fit_sq_sums, 0, sizeof(_fit_sq_sums));
+        _fit_evaluating = true;
+        return false;
     }
 
-    if(!inverse(JTJ, JTJ, 9)) {
-        return;
+    // sum the squared residuals of the current and the two candidate parameters
+    for(uint16_t k = _fit_sample; k < end; k++) {
+        Vector3f sample = _sample_buffer[k].get();
+        _fit_sq_sums[0] += sq(calc_residual(sample, _params));
+        _fit_sq_sums[1] += sq(calc_residual(sample, _fit1_params));
+        _fit_sq_sums[2] += sq(calc_residual(sample, _fit2_params));
     }
-
-    if(!inverse(JTJ2, JTJ2, 9)) {
-        return;
+    _fit_sample = end;
+    if(_fit_sample < _samples_collected) {
+        return false;
     }
+    _fit_sample = 0;
+    _fit_evaluating = false;
 
-    for(uint8_t row=0; row < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; row++) {
-        for(uint8_t col=0; col < COMPASS_CAL_NUM_ELLIPSOID_PARAMS; col++) {
-            fit1_params.get_ellipsoid_params()[row] -= JTFI[col] * JTJ[row*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+col];
-            fit2_params.get_ellipsoid_params()[row] -= JTFI[col] * JTJ2[row*COMPASS_CAL_NUM_ELLIPSOID_PARAMS+col];
-        }
+    finish_fit_iteration(ellipsoid);
+    return true;
+}
+
+void CompassCalibrator::finish_fit_iteration(bool ellipsoid)
+{
+    _fitness = _fit_sq_sums[0] / _samples_collected;
+    if(_fit_step == 0) {
+        _initial_fitness = _fitness;
     }
 
-    fit1 = calc_mean_squared_residuals(fit1_params);
-    fit2 = calc_mean_squared_residuals(fit2_params);
+    float fitness = _fitness;
+    float fit1 = _fit_sq_sums[1] / _samples_collected;
+    float fit2 = _fit_sq_sums[2] / _samples_collected;
+    float &lambda = ellipsoid ? _ellipsoid_lambda : _sphere_lambda;
 
     if(fit1 > _fitness && fit2 > _fitness){
-        _ellipsoid_lambda *= lma_damping;
+        lambda *= lma_damping;
     } else if(fit2 < _fitness && fit2 < fit1) {
-        _ellipsoid_lambda /= lma_damping;
-        fit1_params = fit2_params;
+        lambda /= lma_damping;
+        _fit1_params = _fit2_params;
         fitness = fit2;
     } else if(fit1 < _fitness){
         fitness = fit1;
     }
     //--------------------Levenberg-part-ends-here--------------------------------//
 
-    if(fitness < _fitness) {
+    if(!isnan(fitness) && fitness < _fitness) {
         _fitness = fitness;
-        _params = fit1_params;
+        _params = _fit1_params;
+    }
+}
+
+void CompassCalibrator::add_seed_sample(const Vector3f& sample)
+{
+    // |s|^2 = 2*c.s + (r^2 - |c|^2) is linear in the centre c and
+    // r^2 - |c|^2. Samples are scaled to keep the normal equations
+    // well conditioned
+    Vector3f s = sample * seed_scale;
+    float row[COMPASS_CAL_NUM_SPHERE_PARAMS] = { 2*s.x, 2*s.y, 2*s.z, 1.0f };
+    _sphere_seed.add_sample(row, s.length_squared());
+}
+
+void CompassCalibrator::seed_sphere_fit()
+{
+    float solution[COMPASS_CAL_NUM_SPHERE_PARAMS];
+    if(!_sphere_seed.solve(0.0f, solution)) {
+        return;
+    }
+
+    Vector3f centre(solution[0], solution[1], solution[2]);
+    float radius_sq = solution[3] + centre.length_squared();
+    if(radius_sq <= 0.0f) {
+        return;
+    }
+    centre /= seed_scale;
+    float radius = sqrtf(radius_sq) / seed_scale;
+
+    // only start from a seed in the range fit_acceptable() allows
+    if(isnan(radius) || radius <= 150 || radius >= 950 ||
+       fabsf(centre.x) >= 1000 || fabsf(centre.y) >= 1000 || fabsf(centre.z) >= 1000) {
+        return;
     }
+    _params.radius = radius;
+    _params.offset = -centre;
 }
 
 
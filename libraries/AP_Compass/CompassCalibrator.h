@@ -4,6 +4,9 @@
 #define COMPASS_CAL_NUM_ELLIPSOID_PARAMS 9
 #define COMPASS_CAL_NUM_SAMPLES 300
 
+// samples processed by each call to update() while fitting
+#define COMPASS_CAL_SAMPLES_PER_UPDATE 50
+
 //RMS tolerance
 #define COMPASS_CAL_DEFAULT_TOLERANCE 5.0f
 
@@ -93,6 +96,18 @@ private:
     uint16_t _samples_collected;
     uint16_t _samples_thinned;
 
+    // incremental fit state. An iteration accumulates the normal
+    // equations over the samples, then evaluates the two candidate
+    // steps over the samples, a chunk per call to update()
+    LMSolver<COMPASS_CAL_NUM_SPHERE_PARAMS> _sphere_seed;
+    LMSolver<COMPASS_CAL_NUM_SPHERE_PARAMS> _sphere_solver;
+    LMSolver<COMPASS_CAL_NUM_ELLIPSOID_PARAMS> _ellipsoid_solver;
+    param_t _fit1_params;
+    param_t _fit2_params;
+    float _fit_sq_sums[3];
+    uint16_t _fit_sample;
+    bool _fit_evaluating;
+
     bool set_status(compass_cal_status_t status);
 
     // returns true if sample should be added to buffer
@@ -111,14 +126,17 @@ private:
     void thin_samples();
 
     float calc_residual(const Vector3f& sample, const param_t& params) const;
-    float calc_mean_squared_residuals(const param_t& params) const;
-    float calc_mean_squared_residuals() const;
 
-    void calc_sphere_jacob(const Vector3f& sample, const param_t& params, float* ret) const;
-    void run_sphere_fit();
+    // algebraic sphere fit of the accepted samples, used to start the fit
+    void add_seed_sample(const Vector3f& sample);
+    void seed_sphere_fit();
 
+    void calc_sphere_jacob(const Vector3f& sample, const param_t& params, float* ret) const;
     void calc_ellipsoid_jacob(const Vector3f& sample, const param_t& params, float* ret) const;
-    void run_ellipsoid_fit();
+
+    // runs part of a fit iteration, returning true when it is complete
+    bool run_fit_chunk(bool ellipsoid);
+    void finish_fit_iteration(bool ellipsoid);
 
     uint16_t get_random();
 };
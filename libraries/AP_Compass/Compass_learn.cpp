@@ -1,9 +1,40 @@
 /// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+#include <AP_Vehicle.h>
 #include "Compass.h"
 
 // don't allow any axis of the offset to go above 2000
 #define COMPASS_OFS_LIMIT 2000
 
+// don't allow any axis of the motor compensation to go above 1000
+#define COMPASS_MOT_LIMIT 1000
+
+// readings in each in-flight learning window, 20 seconds at 10Hz
+#define COMPASS_LEARN_WINDOW 200
+
+// largest RMS difference from the expected field left by the fit of a
+// window for it to be applied
+#define COMPASS_LEARN_MAX_RMS 50.0f
+
+// largest offset change accepted from one window
+#define COMPASS_LEARN_MAX_CHANGE 200.0f
+
+// fraction of the correction from each window that is applied
+#define COMPASS_LEARN_GAIN 0.5f
+
+// largest change of the motor correction at the mean throttle or
+// current of a window applied to the compass used by the EKF. The EKF
+// follows offset changes, but sees this as a step in the field
+#define COMPASS_LEARN_MAX_MOTOR_STEP 20.0f
+
+// in-flight learning needs the vehicle to call learn_inflight(). Other
+// vehicles fall back to the internal learning
+#define COMPASS_LEARN_INFLIGHT_AVAILABLE APM_BUILD_TYPE(APM_BUILD_ArduCopter)
+
+// spread of throttle or current (in amps) needed in a window to
+// separate the motor interference from the offsets
+#define COMPASS_LEARN_MIN_THR_SD  0.05f
+#define COMPASS_LEARN_MIN_CURR_SD 2.0f
+
 /*
  *  this offset learning algorithm is inspired by this paper from Bill Premerlani
  *
@@ -27,7 +58,8 @@
 void
 Compass::learn_offsets(void)
 {
-    if (_learn == 0) {
+    if (_learn != COMPASS_LEARN_INTERNAL &&
+        (_learn != COMPASS_LEARN_INFLIGHT || COMPASS_LEARN_INFLIGHT_AVAILABLE)) {
         // auto-calibration is disabled
         return;
     }
@@ -124,3 +156,142 @@ Compass::learn_offsets(void)
         _state[k].offset.set(new_offsets);
     }
 }
+
+bool
+Compass::learn_inflight_enabled() const
+{
+    return COMPASS_LEARN_INFLIGHT_AVAILABLE && _learn == COMPASS_LEARN_INFLIGHT;
+}
+
+/*
+ *  in-flight learning of the offsets and motor interference. The
+ *  difference between the field the EKF expects and the corrected
+ *  field should be zero. What is left is modelled on each axis as
+ *
+ *    r = offset_change + motor_change * x
+ *
+ *  where x is the throttle or current used for motor compensation. The
+ *  sums for a least squares fit of the model are updated with each
+ *  reading, and at the end of a window the fit is applied if what it
+ *  leaves is small. The motor interference is only fitted if the
+ *  throttle or current varied enough during the window.
+ *
+ *  The EKF estimates the offset error of the primary compass in its
+ *  body field states, so for the primary the expected field includes
+ *  them and the offset change also moves the learned bias into the
+ *  offsets. The EKF shifts its body field states by offset changes, so
+ *  the learner and the EKF do not both correct the same error.
+ */
+void
+Compass::learn_inflight(const Vector3f &expected_field, const Vector3f &ekf_mag_bias)
+{
+    if (!learn_inflight_enabled()) {
+        return;
+    }
+
+    for (uint8_t k=0; k<_compass_count; k++) {
+        const mag_state &state = _state[k];
+        learn_state &learn = _learn_state[k];
+
+        if (!state.healthy || state.last_update_ms == learn.last_update_ms) {
+            continue;
+        }
+        learn.last_update_ms = state.last_update_ms;
+
+        const float x = _thr_or_curr;
+        Vector3f r = expected_field - state.field;
+        if (k == get_primary()) {
+            r += ekf_mag_bias;
+            learn.sum_bias += ekf_mag_bias;
+        }
+
+        learn.count++;
+        learn.sum_x += x;
+        learn.sum_x_sq += x * x;
+        for (uint8_t i=0; i<3; i++) {
+            learn.sum_r[i] += r[i];
+            learn.sum_rx[i] += r[i] * x;
+            learn.sum_r_sq[i] += r[i] * r[i];
+        }
+
+        if (learn.count >= COMPASS_LEARN_WINDOW) {
+            learn_inflight_update(k);
+            uint32_t last_update_ms = learn.last_update_ms;
+            learn = learn_state();
+            learn.last_update_ms = last_update_ms;
+        }
+    }
+}
+
+void
+Compass::learn_inflight_reset(void)
+{
+    for (uint8_t k=0; k<COMPASS_MAX_INSTANCES; k++) {
+        uint32_t last_update_ms = _learn_state[k].last_update_ms;
+        _learn_state[k] = learn_state();
+        _learn_state[k].last_update_ms = last_update_ms;
+    }
+}
+
+/*
+  fit the model to a complete window for instance k and apply part of
+  the correction to its offsets and motor compensation
+ */
+void
+Compass::learn_inflight_update(uint8_t k)
+{
+    const learn_state &learn = _learn_state[k];
+    const float n = learn.count;
+
+    float mean_x = learn.sum_x / n;
+    float var_x = learn.sum_x_sq / n - mean_x * mean_x;
+    float min_sd = (_motor_comp_type == AP_COMPASS_MOT_COMP_CURRENT) ? COMPASS_LEARN_MIN_CURR_SD : COMPASS_LEARN_MIN_THR_SD;
+    bool fit_motor = _motor_comp_type != AP_COMPASS_MOT_COMP_DISABLED && var_x > sq(min_sd);
+
+    Vector3f offset_change, motor_change;
+    float sum_var = 0;
+    for (uint8_t i=0; i<3; i++) {
+        float mean_r = learn.sum_r[i] / n;
+        float var_r = learn.sum_r_sq[i] / n - mean_r * mean_r;
+        if (fit_motor) {
+            motor_change[i] = (learn.sum_rx[i] / n - mean_x * mean_r) / var_x;
+            // the variance explained by the motor term is removed
+            var_r -= sq(motor_change[i]) * var_x;
+        }
+        offset_change[i] = mean_r - motor_change[i] * mean_x;
+        sum_var += max(var_r, 0);
+    }
+
+    if (k == get_primary()) {
+        // move the bias learned by the EKF into the offsets
+        offset_change -= learn.sum_bias / n;
+
+        // limit the step the EKF sees from the motor correction
+        float motor_step = (motor_change * (mean_x * COMPASS_LEARN_GAIN)).length();
+        if (motor_step > COMPASS_LEARN_MAX_MOTOR_STEP) {
+            motor_change *= COMPASS_LEARN_MAX_MOTOR_STEP / motor_step;
+        }
+    }
+
+    // confidence gating: the model must explain the readings well and
+    // the change must be plausible
+    if (offset_change.is_nan() || motor_change.is_nan() ||
+        sum_var > sq(COMPASS_LEARN_MAX_RMS) ||
+        offset_change.length() > COMPASS_LEARN_MAX_CHANGE) {
+        return;
+    }
+
+    Vector3f new_offsets = _state[k].offset.get() + offset_change * COMPASS_LEARN_GAIN;
+    new_offsets.x = constrain_float(new_offsets.x, -COMPASS_OFS_LIMIT, COMPASS_OFS_LIMIT);
+    new_offsets.y = constrain_float(new_offsets.y, -COMPASS_OFS_LIMIT, COMPASS_OFS_LIMIT);
+    new_offsets.z = constrain_float(new_offsets.z, -COMPASS_OFS_LIMIT, COMPASS_OFS_LIMIT);
+    _state[k].offset.set(new_offsets);
+
+    if (fit_motor) {
+        Vector3f new_motor = _state[k].motor_compensation.get() + motor_change * COMPASS_LEARN_GAIN;
+        new_motor.x = constrain_float(new_motor.x, -COMPASS_MOT_LIMIT, COMPASS_MOT_LIMIT);
+        new_motor.y = constrain_float(new_motor.y, -COMPASS_MOT_LIMIT, COMPASS_MOT_LIMIT);
+        new_motor.z = constrain_float(new_motor.z, -COMPASS_MOT_LIMIT, COMPASS_MOT_LIMIT);
+        _state[k].motor_compensation.set(new_motor);
+    }
+}
@@ -49,8 +49,8 @@ const AP_Param::GroupInfo AP_GPS::var_info[] PROGMEM = {
 #if GPS_MAX_INSTANCES > 1
     // @Param: AUTO_SWITCH
     // @DisplayName: Automatic Switchover Setting
-    // @Description: Automatic switchover to GPS reporting best lock
-    // @Values: 0:Disabled,1:Enabled
+    // @Description: Automatic switchover to GPS reporting best lock, or blending of the GPS solutions weighted by their reported accuracy
+    // @Values: 0:Disabled,1:UseBest,2:Blend
     // @User: Advanced
     AP_GROUPINFO("AUTO_SWITCH", 3, AP_GPS, _auto_switch, 1),
 #endif
@@ -110,6 +110,24 @@ const AP_Param::GroupInfo AP_GPS::var_info[] PROGMEM = {
     // @User: Advanced
     AP_GROUPINFO("UBLOX_NO_FIX", 10, AP_GPS, _ublox_no_fix, 0),
 
+    // @Param: DELAY_MS
+    // @DisplayName: GPS delay in milliseconds
+    // @Description: Lag of the position and velocity from the first GPS. If zero 200 milliseconds is used
+    // @Units: milliseconds
+    // @Range: 0 250
+    // @User: Advanced
+    AP_GROUPINFO("DELAY_MS", 11, AP_GPS, _delay_ms[0], 0),
+
+#if GPS_MAX_INSTANCES > 1
+    // @Param: DELAY_MS2
+    // @DisplayName: GPS 2 delay in milliseconds
+    // @Description: Lag of the position and velocity from the second GPS. If zero 200 milliseconds is used
+    // @Units: milliseconds
+    // @Range: 0 250
+    // @User: Advanced
+    AP_GROUPINFO("DELAY_MS2", 12, AP_GPS, _delay_ms[1], 0),
+#endif
+
     AP_GROUPEND
 };
 
@@ -118,6 +136,11 @@ void AP_GPS::init(DataFlash_Class *dataflash, const AP_SerialManager& serial_man
 {
     _DataFlash = dataflash;
     primary_instance = 0;
+#if GPS_MAX_INSTANCES > 1
+    state[GPS_BLENDED_INSTANCE].instance = GPS_BLENDED_INSTANCE;
+    _blended_lag = get_lag(0);
+    _blend_source = -1;
+#endif
 
     // search for serial ports with gps protocol
     _port[0] = serial_manager.find_serial(AP_SerialManager::SerialProtocol_GPS, 0);
@@ -296,7 +319,13 @@ AP_GPS::GPS_Status
 AP_GPS::highest_supported_status(void) const
 {
 #if GPS_RTK_AVAILABLE
-
+    if (primary_instance == GPS_BLENDED_INSTANCE) {
+        GPS_Status highest = NO_GPS;
+        for (uint8_t i=0; i<GPS_MAX_INSTANCES; i++) {
+            highest = max(highest, highest_supported_status(i));
+        }
+        return highest;
+    }
     if (drivers[primary_instance] != NULL)
         return drivers[primary_instance]->highest_supported_status();
 #endif
@@ -375,7 +404,7 @@ AP_GPS::update(void)
         if (state[i].status != NO_GPS) {
             num_instances = i+1;
         }
-        if (_auto_switch) {            
+        if (_auto_switch == 1) {
             if (i == primary_instance) {
                 continue;
             }
@@ -397,6 +426,10 @@ AP_GPS::update(void)
             primary_instance = 0;
         }
     }
+    if (_auto_switch == 2) {
+        update_blending();
+        primary_instance = GPS_BLENDED_INSTANCE;
+    }
 #else
     num_instances = 1;
 #endif // GPS_MAX_INSTANCES
@@ -488,12 +521,19 @@ void
 AP_GPS::send_mavlink_gps_raw(mavlink_channel_t chan)
 {
     static uint32_t last_send_time_ms[MAVLINK_COMM_NUM_BUFFERS];
-    if (status(0) > AP_GPS::NO_GPS) {
+    // the first receiver, or the blended solution when it is in use
+    uint8_t instance = 0;
+#if GPS_MAX_INSTANCES > 1
+    if (primary_instance == GPS_BLENDED_INSTANCE) {
+        instance = GPS_BLENDED_INSTANCE;
+    }
+#endif
+    if (status(instance) > AP_GPS::NO_GPS) {
         // when we have a GPS then only send new data
-        if (last_send_time_ms[chan] == last_message_time_ms(0)) {
+        if (last_send_time_ms[chan] == last_message_time_ms(instance)) {
             return;
         }
-        last_send_time_ms[chan] = last_message_time_ms(0);
+        last_send_time_ms[chan] = last_message_time_ms(instance);
     } else {
         // when we don't have a GPS then send at 1Hz
         uint32_t now = hal.scheduler->millis();
@@ -502,19 +542,19 @@ AP_GPS::send_mavlink_gps_raw(mavlink_channel_t chan)
         }
         last_send_time_ms[chan] = now;
     }
-    const Location &loc = location(0);
+    const Location &loc = location(instance);
     mavlink_msg_gps_raw_int_send(
         chan,
-        last_fix_time_ms(0)*(uint64_t)1000,
-        status(0),
+        last_fix_time_ms(instance)*(uint64_t)1000,
+        status(instance),
         loc.lat,        // in 1E7 degrees
         loc.lng,        // in 1E7 degrees
         loc.alt * 10UL, // in mm
-        get_hdop(0),
+        get_hdop(instance),
         65535,
-        ground_speed(0)*100,  // cm/s
-        ground_course_cd(0), // 1/100 degrees,
-        num_sats(0));
+        ground_speed(instance)*100,  // cm/s
+        ground_course_cd(instance), // 1/100 degrees,
+        num_sats(instance));
 }
 
 #if GPS_MAX_INSTANCES > 1
@@ -568,3 +608,238 @@ AP_GPS::send_mavlink_gps2_rtk(mavlink_channel_t chan)
 }
 #endif
 #endif
+
+/*
+  the lag of an instance's fix. For the blended solution this is the
+  weighted lag of the receivers' fixes
+ */
+float
+AP_GPS::get_lag(uint8_t instance) const
+{
+#if GPS_MAX_INSTANCES > 1
+    if (instance == GPS_BLENDED_INSTANCE) {
+        return _blended_lag;
+    }
+#endif
+    if (_delay_ms[instance] > 0) {
+        return _delay_ms[instance] * 0.001f;
+    }
+    return GPS_DEFAULT_LAG;
+}
+
+#if GPS_MAX_INSTANCES > 1
+// receivers whose last message is older than this are not blended
+#define GPS_BLEND_TIMEOUT_MS 500
+
+// time constant with which the output offset after a change of source decays
+#define GPS_BLEND_OFFSET_TC 10.0f
+
+// milliseconds in a GPS week
+#define GPS_MSEC_PER_WEEK (7*86400*1000L)
+
+/*
+  update the blended solution when a receiver has new data. With two
+  receivers with a 3D fix the solutions are blended, otherwise the
+  best receiver is used. When the source of the output changes the
+  difference between the old and new sources is held as an offset
+  which decays, so the output has no step
+ */
+void
+AP_GPS::update_blending(void)
+{
+    GPS_State &bstate = state[GPS_BLENDED_INSTANCE];
+    GPS_timing &btiming = timing[GPS_BLENDED_INSTANCE];
+    uint32_t tnow = hal.scheduler->millis();
+
+    uint32_t last_message_ms = 0;
+    for (uint8_t i=0; i<GPS_MAX_INSTANCES; i++) {
+        last_message_ms = max(last_message_ms, timing[i].last_message_time_ms);
+    }
+    if (last_message_ms == btiming.last_message_time_ms) {
+        return;
+    }
+
+    // the previous output, to hide a change of source
+    const Location prev_location = bstate.location;
+    const Vector3f prev_velocity = bstate.velocity;
+    const GPS_Status prev_status = bstate.status;
+    const uint32_t prev_sample_ms = btiming.last_fix_time_ms - (uint32_t)(_blended_lag * 1000);
+
+    uint8_t healthy[GPS_MAX_INSTANCES];
+    uint8_t count = 0;
+    for (uint8_t i=0; i<GPS_MAX_INSTANCES; i++) {
+        if (state[i].status >= GPS_OK_FIX_3D &&
+            tnow - timing[i].last_message_time_ms < GPS_BLEND_TIMEOUT_MS) {
+            healthy[count++] = i;
+        }
+    }
+
+    int8_t source;
+    if (count >= 2) {
+        source = GPS_BLENDED_INSTANCE;
+        calc_blended_state(healthy, count);
+    } else {
+        uint8_t best = 0;
+        for (uint8_t i=1; i<GPS_MAX_INSTANCES; i++) {
+            if (state[i].status > state[best].status) {
+                best = i;
+            }
+        }
+        source = best;
+        bstate = state[best];
+        bstate.instance = GPS_BLENDED_INSTANCE;
+        btiming = timing[best];
+        _blended_lag = get_lag(best);
+    }
+
+    if (source != _blend_source) {
+        if (_blend_source != -1 && prev_status >= GPS_OK_FIX_2D && bstate.status >= GPS_OK_FIX_2D) {
+            // move the old output to the sample time of the new source
+            // and hold the difference
+            uint32_t sample_ms = btiming.last_fix_time_ms - (uint32_t)(_blended_lag * 1000);
+            float dt = (int32_t)(sample_ms - prev_sample_ms) * 0.001f;
+            Location old_location = prev_location;
+            location_offset(old_location, prev_velocity.x * dt, prev_velocity.y * dt);
+            old_location.alt -= prev_velocity.z * dt * 100;
+            Vector2f ne = location_diff(bstate.location, old_location);
+            _blend_output_offset = Vector3f(ne.x, ne.y, (bstate.location.alt - old_location.alt) * 0.01f);
+        } else {
+            _blend_output_offset.zero();
+        }
+        _blend_source = source;
+    } else {
+        float dt = (tnow - _blend_update_ms) * 0.001f;
+        _blend_output_offset *= max(1.0f - dt / GPS_BLEND_OFFSET_TC, 0.0f);
+    }
+    _blend_update_ms = tnow;
+
+    location_offset(bstate.location, _blend_output_offset.x, _blend_output_offset.y);
+    bstate.location.alt -= _blend_output_offset.z * 100;
+}
+
+/*
+  blend the receivers in healthy[] into the blended state. Each is
+  weighted by the inverse square of its reported accuracy, or of its
+  HDOP if any of them do not report accuracy. The fixes are moved to a
+  common sample time with their velocities before they are combined
+ */
+void
+AP_GPS::calc_blended_state(const uint8_t *healthy, uint8_t count)
+{
+    GPS_State &bstate = state[GPS_BLENDED_INSTANCE];
+    GPS_timing &btiming = timing[GPS_BLENDED_INSTANCE];
+
+    bool use_hacc = true, use_vacc = true, use_sacc = true;
+    for (uint8_t k=0; k<count; k++) {
+        const GPS_State &s = state[healthy[k]];
+        use_hacc = use_hacc && s.have_horizontal_accuracy && s.horizontal_accuracy > 0;
+        use_vacc = use_vacc && s.have_vertical_accuracy && s.vertical_accuracy > 0;
+        use_sacc = use_sacc && s.have_speed_accuracy && s.speed_accuracy > 0;
+    }
+
+    float hpos_weight[GPS_MAX_INSTANCES];
+    float vpos_weight[GPS_MAX_INSTANCES];
+    float vel_weight[GPS_MAX_INSTANCES];
+    float hsum = 0, vsum = 0, ssum = 0;
+    uint8_t ref = 0;
+    for (uint8_t k=0; k<count; k++) {
+        const GPS_State &s = state[healthy[k]];
+        float dop = max(s.hdop, 1) * 0.01f;
+        hpos_weight[k] = 1.0f / sq(use_hacc ? s.horizontal_accuracy : dop);
+        vpos_weight[k] = 1.0f / sq(use_vacc ? s.vertical_accuracy : dop);
+        vel_weight[k] = 1.0f / sq(use_sacc ? s.speed_accuracy : dop);
+        hsum += hpos_weight[k];
+        vsum += vpos_weight[k];
+        ssum += vel_weight[k];
+        if (hpos_weight[k] > hpos_weight[ref]) {
+            ref = k;
+        }
+    }
+    for (uint8_t k=0; k<count; k++) {
+        hpos_weight[k] /= hsum;
+        vpos_weight[k] /= vsum;
+        vel_weight[k] /= ssum;
+    }
+
+    // sample times of the fixes in seconds, relative to the arrival
+    // of the fix from the most accurate receiver
+    const uint8_t iref = healthy[ref];
+    float sample_time[GPS_MAX_INSTANCES];
+    float blend_time = 0;
+    uint32_t last_message_ms = 0;
+    for (uint8_t k=0; k<count; k++) {
+        uint8_t i = healthy[k];
+        sample_time[k] = (int32_t)(timing[i].last_fix_time_ms - timing[iref].last_fix_time_ms) * 0.001f - get_lag(i);
+        blend_time += hpos_weight[k] * sample_time[k];
+        last_message_ms = max(last_message_ms, timing[i].last_message_time_ms);
+    }
+
+    Vector2f ne_offset;
+    float alt_offset_cm = 0;
+    Vector3f velocity;
+    float inv_hacc_sq = 0, inv_vacc_sq = 0, inv_sacc_sq = 0;
+    bstate = state[iref];
+    for (uint8_t k=0; k<count; k++) {
+        const GPS_State &s = state[healthy[k]];
+        float dt = blend_time - sample_time[k];
+        Vector2f ne = location_diff(state[iref].location, s.location);
+        ne.x += s.velocity.x * dt;
+        ne.y += s.velocity.y * dt;
+        ne_offset += ne * hpos_weight[k];
+        alt_offset_cm += vpos_weight[k] * ((s.location.alt - state[iref].location.alt) - s.velocity.z * dt * 100);
+        velocity += s.velocity * vel_weight[k];
+
+        bstate.status = (GPS_Status)min(bstate.status, s.status);
+        bstate.hdop = min(bstate.hdop, s.hdop);
+        bstate.have_vertical_velocity = bstate.have_vertical_velocity && s.have_vertical_velocity;
+        if (healthy[k] != iref) {
+            bstate.num_sats = min(bstate.num_sats + s.num_sats, 255);
+        }
+        if (use_hacc) {
+            inv_hacc_sq += 1.0f / sq(s.horizontal_accuracy);
+        }
+        if (use_vacc) {
+            inv_vacc_sq += 1.0f / sq(s.vertical_accuracy);
+        }
+        if (use_sacc) {
+            inv_sacc_sq += 1.0f / sq(s.speed_accuracy);
+        }
+    }
+
+    bstate.instance = GPS_BLENDED_INSTANCE;
+    location_offset(bstate.location, ne_offset.x, ne_offset.y);
+    bstate.location.alt += alt_offset_cm;
+    bstate.velocity = velocity;
+    bstate.ground_speed = pythagorous2(velocity.x, velocity.y);
+    bstate.ground_course_cd = wrap_360_cd(degrees(atan2f(velocity.y, velocity.x)) * 100);
+    bstate.have_horizontal_accuracy = use_hacc;
+    bstate.have_vertical_accuracy = use_vacc;
+    bstate.have_speed_accuracy = use_sacc;
+    if (use_hacc) {
+        bstate.horizontal_accuracy = 1.0f / sqrtf(inv_hacc_sq);
+    }
+    if (use_vacc) {
+        bstate.vertical_accuracy = 1.0f / sqrtf(inv_vacc_sq);
+    }
+    if (use_sacc) {
+        bstate.speed_accuracy = 1.0f / sqrtf(inv_sacc_sq);
+    }
+
+    // all of the blended timing is taken from the reference
+    // receiver. The blended sample is blend_time after its fix arrived,
+    // which is last_fix_time_ms - lag, and the GPS time is moved from
+    // its sample by the same amount
+    btiming.last_fix_time_ms = timing[iref].last_fix_time_ms + (uint32_t)(max(blend_time, 0.0f) * 1000);
+    btiming.last_message_time_ms = last_message_ms;
+    _blended_lag = max(-blend_time, 0.0f);
+    int32_t week_ms = (int32_t)state[iref].time_week_ms + (int32_t)((blend_time + get_lag(iref)) * 1000);
+    if (week_ms < 0) {
+        week_ms += GPS_MSEC_PER_WEEK;
+        bstate.time_week--;
+    } else if (week_ms >= GPS_MSEC_PER_WEEK) {
+        week_ms -= GPS_MSEC_PER_WEEK;
+        bstate.time_week++;
+    }
+    bstate.time_week_ms = week_ms;
+}
+#endif // GPS_MAX_INSTANCES > 1
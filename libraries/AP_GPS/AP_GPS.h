@@ -38,6 +38,20 @@
 #define GPS_MAX_INSTANCES 1
 #endif
 
+/**
+   with more than one receiver a blended solution can be used, which
+   is kept in the state after the receivers' own
+ */
+#if GPS_MAX_INSTANCES > 1
+#define GPS_BLENDED_INSTANCE GPS_MAX_INSTANCES
+#define GPS_NUM_STATES (GPS_MAX_INSTANCES+1)
+#else
+#define GPS_NUM_STATES 1
+#endif
+
+// lag in seconds of the position and velocity when GPS_DELAY_MS is zero
+#define GPS_DEFAULT_LAG 0.2f
+
 #if HAL_CPU_CLASS >= HAL_CPU_CLASS_75
 #define GPS_RTK_AVAILABLE 1
 #else
@@ -310,7 +324,10 @@ public:
     }
 
     // the expected lag (in seconds) in the position and velocity readings from the gps
-    float get_lag() const { return 0.2f; }
+    float get_lag(uint8_t instance) const;
+    float get_lag() const {
+        return get_lag(primary_instance);
+    }
 
     // set position for HIL
     void setHIL(uint8_t instance, GPS_Status status, uint64_t time_epoch_ms, 
@@ -335,6 +352,7 @@ public:
     AP_Int8 _min_elevation;
     AP_Int16 _spd_err_ow;
     AP_Int16 _ublox_no_fix;
+    AP_Int16 _delay_ms[GPS_MAX_INSTANCES];
     
     // handle sending of initialisation strings to the GPS
     void send_blob_start(uint8_t instance, const prog_char *_blob, uint16_t size);
@@ -347,7 +365,7 @@ public:
     void inject_data(uint8_t *data, uint8_t len);
     void inject_data(uint8_t instance, uint8_t *data, uint8_t len);
 
-    //MAVLink Status Sending
+    //MAVLink Status Sending. GPS_RAW_INT reports the blended solution when it is in use
     void send_mavlink_gps_raw(mavlink_channel_t chan);
 #if GPS_MAX_INSTANCES > 1    
     void send_mavlink_gps2_raw(mavlink_channel_t chan);
@@ -368,8 +386,8 @@ private:
         // the time we got our last fix in system milliseconds
         uint32_t last_message_time_ms;
     };
-    GPS_timing timing[GPS_MAX_INSTANCES];
-    GPS_State state[GPS_MAX_INSTANCES];
+    GPS_timing timing[GPS_NUM_STATES];
+    GPS_State state[GPS_NUM_STATES];
     AP_GPS_Backend *drivers[GPS_MAX_INSTANCES];
     AP_HAL::UARTDriver *_port[GPS_MAX_INSTANCES];
 
@@ -407,6 +425,17 @@ private:
 
     void detect_instance(uint8_t instance);
     void update_instance(uint8_t instance);
+
+#if GPS_MAX_INSTANCES > 1
+    // blending of the receivers into state[GPS_BLENDED_INSTANCE]
+    float _blended_lag;
+    int8_t _blend_source;               // instance the output came from, GPS_BLENDED_INSTANCE when blended
+    Vector3f _blend_output_offset;      // NED offset in metres hiding a change of source, decays to zero
+    uint32_t _blend_update_ms;
+
+    void update_blending(void);
+    void calc_blended_state(const uint8_t *healthy, uint8_t count);
+#endif
 };
 
 #include <GPS_Backend.h>
@@ -112,12 +112,11 @@ AP_GPS_NMEA::AP_GPS_NMEA(AP_GPS &_gps, AP_GPS::GPS_State &_state, AP_HAL::UARTDr
 
 bool AP_GPS_NMEA::read(void)
 {
-    int16_t numc;
+    uint8_t c;
     bool parsed = false;
 
-    numc = port->available();
-    while (numc--) {
-        if (_decode(port->read())) {
+    while (read_byte(c)) {
+        if (_decode(c)) {
             parsed = true;
         }
     }
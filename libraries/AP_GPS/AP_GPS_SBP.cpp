@@ -108,8 +108,8 @@ void
 AP_GPS_SBP::_sbp_process() 
 {
 
-    while (port->available() > 0) {
-        uint8_t temp = port->read();
+    uint8_t temp;
+    while (read_byte(temp)) {
         uint16_t crc;
 
 
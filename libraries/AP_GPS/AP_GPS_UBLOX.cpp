@@ -148,8 +148,6 @@ AP_GPS_UBLOX::send_next_rate_update(void)
 bool
 AP_GPS_UBLOX::read(void)
 {
-    uint8_t data;
-    int16_t numc;
     bool parsed = false;
     uint32_t millis_now = hal.scheduler->millis();
 
@@ -160,110 +158,164 @@ AP_GPS_UBLOX::read(void)
         _save_cfg();
     }
 
-    numc = port->available();
-    for (int16_t i = 0; i < numc; i++) {        // Process bytes received
-
-        // read the next byte
-        data = port->read();
+    const uint8_t *data;
+    uint16_t n;
+    while ((n = read_block(data)) != 0) {
+        if (_scan_block(data, n)) {
+            parsed = true;
+        }
+    }
+    return parsed;
+}
 
-	reset:
-        switch(_step) {
+/*
+  scan a block of received bytes. Bytes before a preamble are skipped
+  with memchr() and payloads are copied and checksummed in runs, so
+  only the header and checksum bytes go through the state machine
+ */
+bool
+AP_GPS_UBLOX::_scan_block(const uint8_t *data, uint16_t len)
+{
+    bool parsed = false;
+    uint16_t i = 0;
 
-        // Message preamble detection
-        //
-        // If we fail to match any of the expected bytes, we reset
-        // the state machine and re-consider the failed byte as
-        // the first byte of the preamble.  This improves our
-        // chances of recovering from a mismatch and makes it less
-        // likely that we will be fooled by the preamble appearing
-        // as data in some other message.
-        //
-        case 1:
-            if (PREAMBLE2 == data) {
-                _step++;
+    while (i < len) {
+        if (_step == 0) {
+            const uint8_t *p = (const uint8_t *)memchr(&data[i], PREAMBLE1, len - i);
+            if (p == NULL) {
                 break;
             }
-            _step = 0;
-            Debug("reset %u", __LINE__);
-        // FALLTHROUGH
-        case 0:
-            if(PREAMBLE1 == data)
-                _step++;
-            break;
-
-        // Message header processing
-        //
-        // We sniff the class and message ID to decide whether we
-        // are going to gather the message bytes or just discard
-        // them.
-        //
-        // We always collect the length so that we can avoid being
-        // fooled by preamble bytes in messages.
-        //
-        case 2:
-            _step++;
-            _class = data;
-            _ck_b = _ck_a = data;                               // reset the checksum accumulators
-            break;
-        case 3:
-            _step++;
-            _ck_b += (_ck_a += data);                   // checksum byte
-            _msg_id = data;
-            break;
-        case 4:
-            _step++;
-            _ck_b += (_ck_a += data);                   // checksum byte
-            _payload_length = data;                             // payload length low byte
-            break;
-        case 5:
-            _step++;
-            _ck_b += (_ck_a += data);                   // checksum byte
-
-            _payload_length += (uint16_t)(data<<8);
-            if (_payload_length > 512) {
-                Debug("large payload %u", (unsigned)_payload_length);
-                // assume very large payloads are line noise
-                _payload_length = 0;
-                _step = 0;
-				goto reset;
+            i = (p - data) + 1;
+            _step = 1;
+        } else if (_step == 6) {
+            uint16_t n = _payload_length - _payload_counter;
+            if (n > len - i) {
+                n = len - i;
             }
-            _payload_counter = 0;                               // prepare to receive payload
-            break;
-
-        // Receive message data
-        //
-        case 6:
-            _ck_b += (_ck_a += data);                   // checksum byte
             if (_payload_counter < sizeof(_buffer)) {
-                _buffer.bytes[_payload_counter] = data;
+                memcpy(&_buffer.bytes[_payload_counter], &data[i],
+                       min(n, sizeof(_buffer) - _payload_counter));
+            }
+            for (uint16_t j=0; j<n; j++) {
+                _ck_b += (_ck_a += data[i+j]);
             }
-            if (++_payload_counter == _payload_length)
+            _payload_counter += n;
+            if (_payload_counter == _payload_length) {
                 _step++;
-            break;
+            }
+            i += n;
+        } else if (_parse_byte(data[i++])) {
+            parsed = true;
+        }
+    }
+    return parsed;
+}
 
-        // Checksum and message processing
-        //
-        case 7:
+/*
+  run one byte through the state machine, returning true when it
+  completes a message that was parsed
+ */
+bool
+AP_GPS_UBLOX::_parse_byte(uint8_t data)
+{
+reset:
+    switch(_step) {
+
+    // Message preamble detection
+    //
+    // If we fail to match any of the expected bytes, we reset
+    // the state machine and re-consider the failed byte as
+    // the first byte of the preamble.  This improves our
+    // chances of recovering from a mismatch and makes it less
+    // likely that we will be fooled by the preamble appearing
+    // as data in some other message.
+    //
+    case 1:
+        if (PREAMBLE2 == data) {
             _step++;
-            if (_ck_a != data) {
-                Debug("bad cka %x should be %x", data, _ck_a);
-                _step = 0;
-				goto reset;
-            }
             break;
-        case 8:
+        }
+        _step = 0;
+        Debug("reset %u", __LINE__);
+    // FALLTHROUGH
+    case 0:
+        if(PREAMBLE1 == data)
+            _step++;
+        break;
+
+    // Message header processing
+    //
+    // We sniff the class and message ID to decide whether we
+    // are going to gather the message bytes or just discard
+    // them.
+    //
+    // We always collect the length so that we can avoid being
+    // fooled by preamble bytes in messages.
+    //
+    case 2:
+        _step++;
+        _class = data;
+        _ck_b = _ck_a = data;                               // reset the checksum accumulators
+        break;
+    case 3:
+        _step++;
+        _ck_b += (_ck_a += data);                   // checksum byte
+        _msg_id = data;
+        break;
+    case 4:
+        _step++;
+        _ck_b += (_ck_a += data);                   // checksum byte
+        _payload_length = data;                             // payload length low byte
+        break;
+    case 5:
+        _step++;
+        _ck_b += (_ck_a += data);                   // checksum byte
+
+        _payload_length += (uint16_t)(data<<8);
+        if (_payload_length > 512) {
+            Debug("large payload %u", (unsigned)_payload_length);
+            // assume very large payloads are line noise
+            _payload_length = 0;
             _step = 0;
-            if (_ck_b != data) {
-                Debug("bad ckb %x should be %x", data, _ck_b);
-                break;                                                  // bad checksum
-            }
+				goto reset;
+        }
+        _payload_counter = 0;                               // prepare to receive payload
+        if (_payload_length == 0) {
+            _step++;                                        // no payload, go to the checksum
+        }
+        break;
 
-            if (_parse_gps()) {
-                parsed = true;
-            }
+    // Receive message data
+    //
+    case 6:
+        _ck_b += (_ck_a += data);                   // checksum byte
+        if (_payload_counter < sizeof(_buffer)) {
+            _buffer.bytes[_payload_counter] = data;
+        }
+        if (++_payload_counter == _payload_length)
+            _step++;
+        break;
+
+    // Checksum and message processing
+    //
+    case 7:
+        _step++;
+        if (_ck_a != data) {
+            Debug("bad cka %x should be %x", data, _ck_a);
+            _step = 0;
+				goto reset;
+        }
+        break;
+    case 8:
+        _step = 0;
+        if (_ck_b != data) {
+            Debug("bad ckb %x should be %x", data, _ck_b);
+            break;                                                  // bad checksum
         }
+
+        return _parse_gps();
     }
-    return parsed;
+    return false;
 }
 
 // Private Methods /////////////////////////////////////////////////////////////
@@ -319,6 +319,8 @@ private:
 
     // Buffer parse & GPS state update
     bool        _parse_gps();
+    bool        _scan_block(const uint8_t *data, uint16_t len);
+    bool        _parse_byte(uint8_t data);
 
     // used to update fix between status and position packets
     AP_GPS::GPS_Status next_fix;
@@ -21,13 +21,36 @@ extern const AP_HAL::HAL& hal;
 AP_GPS_Backend::AP_GPS_Backend(AP_GPS &_gps, AP_GPS::GPS_State &_state, AP_HAL::UARTDriver *_port) :
     port(_port),
     gps(_gps),
-    state(_state)
+    state(_state),
+    _rx_len(0),
+    _rx_pos(0)
 {
     state.have_speed_accuracy = false;
     state.have_horizontal_accuracy = false;
     state.have_vertical_accuracy = false;
 }
 
+/*
+  read the next block of received bytes from the port
+ */
+bool AP_GPS_Backend::_fill_block(void)
+{
+    _rx_pos = 0;
+    _rx_len = port->read_bytes(_rx_block, sizeof(_rx_block));
+    return _rx_len != 0;
+}
+
+uint16_t AP_GPS_Backend::read_block(const uint8_t *&data)
+{
+    if (_rx_pos == _rx_len && !_fill_block()) {
+        return 0;
+    }
+    data = &_rx_block[_rx_pos];
+    uint16_t n = _rx_len - _rx_pos;
+    _rx_pos = _rx_len;
+    return n;
+}
+
 int32_t AP_GPS_Backend::swap_int32(int32_t v) const
 {
     const uint8_t *b = (const uint8_t *)&v;
@@ -23,6 +23,13 @@
 #include <GCS_MAVLink.h>
 #include <AP_GPS.h>
 
+// size of the block the port is read in
+#if HAL_CPU_CLASS < HAL_CPU_CLASS_75
+#define GPS_RX_BLOCK_SIZE 16
+#else
+#define GPS_RX_BLOCK_SIZE 64
+#endif
+
 class AP_GPS_Backend
 {
 public:
@@ -58,6 +65,21 @@ protected:
     AP_GPS &gps;                        ///< access to frontend (for parameters)
     AP_GPS::GPS_State &state;           ///< public state for this instance
 
+    /*
+      received bytes are read from the port in blocks. read_block()
+      returns the unread part of the current block, reading a new one
+      when it is empty, and marks it used. read_byte() takes one byte
+      at a time. Both return zero/false once the port is empty
+     */
+    uint16_t read_block(const uint8_t *&data);
+    bool read_byte(uint8_t &c) {
+        if (_rx_pos == _rx_len && !_fill_block()) {
+            return false;
+        }
+        c = _rx_block[_rx_pos++];
+        return true;
+    }
+
     // common utility functions
     int32_t swap_int32(int32_t v) const;
     int16_t swap_int16(int16_t v) const;
@@ -72,6 +94,13 @@ protected:
        assumes MTK19 millisecond form of bcd_time
     */
     void make_gps_time(uint32_t bcd_date, uint32_t bcd_milliseconds);
+
+private:
+    bool _fill_block(void);
+
+    uint8_t _rx_block[GPS_RX_BLOCK_SIZE];
+    uint8_t _rx_len;
+    uint8_t _rx_pos;
 };
 
 #endif // __AP_GPS_BACKEND_H__
@@ -0,0 +1,276 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+//
+// Benchmark of the cost of reading the GPS port, replaying a byte
+// stream into the UBLOX and NMEA drivers through a port that reads in
+// blocks and through one that only supports single byte reads.
+//
+// Both sides run the same block parsers. The single byte port uses the
+// default UARTDriver::read_bytes(), which makes one read() call per
+// byte as a HAL without its own read_bytes() does. The difference is
+// the cost of the per-byte port calls, not of the old per-byte UBX
+// state machine, which is no longer in the tree
+//
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Param.h>
+#include <AP_HAL.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_PX4.h>
+#include <AP_HAL_Linux.h>
+#include <AP_HAL_Empty.h>
+#include <AP_GPS.h>
+#include <DataFlash.h>
+#include <AP_InertialSensor.h>
+#include <AP_ADC.h>
+#include <GCS_MAVLink.h>
+#include <AP_Baro.h>
+#include <Filter.h>
+#include <AP_AHRS.h>
+#include <AP_Compass.h>
+#include <AP_Declination.h>
+#include <AP_Airspeed.h>
+#include <AP_Vehicle.h>
+#include <AP_ADC_AnalogSource.h>
+#include <AP_Mission.h>
+#include <StorageManager.h>
+#include <AP_Terrain.h>
+#include <AP_Math.h>
+#include <AP_Notify.h>
+#include <AP_BoardLED.h>
+#include <AP_NavEKF.h>
+#include <AP_Rally.h>
+#include <AP_Scheduler.h>
+#include <AP_BattMonitor.h>
+#include <AP_SerialManager.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+AP_GPS gps;
+
+// number of 5Hz solutions in the stream
+#define NUM_EPOCHS  10
+
+// bytes arriving between calls to read(), about 20ms at 38400 baud
+#define ARRIVAL_BYTES 77
+
+#define NUM_REPEATS 20
+
+/*
+  a port that replays a recorded stream, making ARRIVAL_BYTES more of
+  it available for each call to the parser
+ */
+class ReplayUART : public AP_HAL::UARTDriver {
+public:
+    ReplayUART(bool block_reads) :
+        _block_reads(block_reads), _data(NULL), _len(0), _pos(0), _arrived(0) {}
+
+    void replay(const uint8_t *data, uint16_t len) {
+        _data = data;
+        _len = len;
+        _pos = 0;
+        _arrived = 0;
+    }
+    bool arrive(uint16_t n) {
+        if (_arrived == _len) {
+            return false;
+        }
+        _arrived = min(_arrived + n, _len);
+        return true;
+    }
+
+    void begin(uint32_t baud) {}
+    void begin(uint32_t baud, uint16_t rxSpace, uint16_t txSpace) {}
+    void end() {}
+    void flush() {}
+    bool is_initialized() { return true; }
+    void set_blocking_writes(bool blocking) {}
+    bool tx_pending() { return false; }
+
+    int16_t available() { return _arrived - _pos; }
+    int16_t txspace() { return 1024; }
+    int16_t read() {
+        if (_pos == _arrived) {
+            return -1;
+        }
+        return _data[_pos++];
+    }
+    uint16_t read_bytes(uint8_t *buffer, uint16_t count) {
+        if (!_block_reads) {
+            return AP_HAL::UARTDriver::read_bytes(buffer, count);
+        }
+        count = min(count, _arrived - _pos);
+        memcpy(buffer, &_data[_pos], count);
+        _pos += count;
+        return count;
+    }
+
+    // configuration messages from the drivers are discarded
+    size_t write(uint8_t c) { return 1; }
+    size_t write(const uint8_t *buffer, size_t size) { return size; }
+
+private:
+    bool _block_reads;
+    const uint8_t *_data;
+    uint16_t _len;
+    uint16_t _pos;
+    uint16_t _arrived;
+};
+
+static ReplayUART byte_uart(false);
+static ReplayUART block_uart(true);
+
+static uint8_t ubx_stream[NUM_EPOCHS * (4*8 + 28 + 16 + 52 + 36 + 5)];
+static uint16_t ubx_len;
+static char nmea_stream[NUM_EPOCHS * 160];
+static uint16_t nmea_len;
+
+/*
+  append a UBX NAV message with its checksum
+ */
+static void add_ubx(uint8_t msg_id, const uint8_t *payload, uint16_t len)
+{
+    uint8_t *p = &ubx_stream[ubx_len];
+    p[0] = 0xb5;
+    p[1] = 0x62;
+    p[2] = 0x01;
+    p[3] = msg_id;
+    p[4] = len & 0xFF;
+    p[5] = len >> 8;
+    memcpy(&p[6], payload, len);
+    uint8_t ck_a = 0, ck_b = 0;
+    for (uint16_t i=2; i<len+6; i++) {
+        ck_b += (ck_a += p[i]);
+    }
+    p[len+6] = ck_a;
+    p[len+7] = ck_b;
+    ubx_len += len + 8;
+}
+
+/*
+  append an NMEA sentence with its checksum
+ */
+static void add_nmea(const char *body)
+{
+    uint8_t sum = 0;
+    for (const char *c=body; *c; c++) {
+        sum ^= *c;
+    }
+    nmea_len += snprintf(&nmea_stream[nmea_len], sizeof(nmea_stream) - nmea_len,
+                         "$%s*%02X\r\n", body, (unsigned)sum);
+}
+
+/*
+  build the streams: POSLLH, STATUS, SOL and VELNED for each epoch
+  with a few bytes of line noise between epochs, and RMC and GGA
+  sentences for the same times
+ */
+static void build_streams(void)
+{
+    uint8_t payload[52];
+    for (uint8_t e=0; e<NUM_EPOCHS; e++) {
+        uint32_t itow = 100000 + e*200;
+        int32_t lat = -353632620 + e*10;
+        int32_t lng = 1491652370 + e*10;
+
+        memset(payload, 0, sizeof(payload));
+        memcpy(&payload[0], &itow, 4);
+        memcpy(&payload[4], &lng, 4);
+        memcpy(&payload[8], &lat, 4);
+        add_ubx(0x02, payload, 28);
+
+        memset(payload, 0, sizeof(payload));
+        memcpy(&payload[0], &itow, 4);
+        payload[4] = 3;             // 3D fix
+        payload[5] = 1;             // fix ok
+        add_ubx(0x03, payload, 16);
+
+        memset(payload, 0, sizeof(payload));
+        memcpy(&payload[0], &itow, 4);
+        payload[8] = 1800 & 0xFF;   // week
+        payload[9] = 1800 >> 8;
+        payload[10] = 3;
+        payload[11] = 1;
+        payload[47] = 10;           // satellites
+        add_ubx(0x06, payload, 52);
+
+        memset(payload, 0, sizeof(payload));
+        memcpy(&payload[0], &itow, 4);
+        add_ubx(0x12, payload, 36);
+
+        for (uint8_t i=0; i<5; i++) {
+            ubx_stream[ubx_len++] = 0x55 + i;
+        }
+
+        char body[100];
+        snprintf(body, sizeof(body), "GPRMC,0100%02u.%02u,A,3521.7957,S,14909.9142,E,000.0,000.0,010115,,",
+                 (unsigned)(e/5), (unsigned)((e%5)*20));
+        add_nmea(body);
+        snprintf(body, sizeof(body), "GPGGA,0100%02u.%02u,3521.7957,S,14909.9142,E,1,10,0.9,584.0,M,0.0,M,,",
+                 (unsigned)(e/5), (unsigned)((e%5)*20));
+        add_nmea(body);
+    }
+}
+
+/*
+  replay a stream through a parser, returning the time taken and the
+  number of reads that returned a new fix
+ */
+static uint32_t run_parser(AP_GPS_Backend *backend, ReplayUART &uart,
+                           const uint8_t *data, uint16_t len, uint16_t &fixes)
+{
+    fixes = 0;
+    uint32_t t0 = hal.scheduler->micros();
+    for (uint8_t r=0; r<NUM_REPEATS; r++) {
+        uart.replay(data, len);
+        while (uart.arrive(ARRIVAL_BYTES)) {
+            if (backend->read()) {
+                fixes++;
+            }
+        }
+    }
+    return hal.scheduler->micros() - t0;
+}
+
+static AP_GPS::GPS_State state[4];
+static AP_GPS_Backend *ubx_bytes, *ubx_block, *nmea_bytes, *nmea_block;
+
+void setup()
+{
+    hal.console->println("GPS parser benchmark");
+
+    build_streams();
+
+    ubx_bytes  = new AP_GPS_UBLOX(gps, state[0], &byte_uart);
+    ubx_block  = new AP_GPS_UBLOX(gps, state[1], &block_uart);
+    nmea_bytes = new AP_GPS_NMEA(gps, state[2], &byte_uart);
+    nmea_block = new AP_GPS_NMEA(gps, state[3], &block_uart);
+}
+
+void loop()
+{
+    uint16_t fixes_bytes, fixes_block;
+    uint32_t t_bytes, t_block;
+
+    t_bytes = run_parser(ubx_bytes, byte_uart, ubx_stream, ubx_len, fixes_bytes);
+    t_block = run_parser(ubx_block, block_uart, ubx_stream, ubx_len, fixes_block);
+    hal.console->printf("UBLOX %u bytes x %u: single byte port %lu usec, block port %lu usec, fixes %u/%u\n",
+                        (unsigned)ubx_len, (unsigned)NUM_REPEATS,
+                        (unsigned long)t_bytes, (unsigned long)t_block,
+                        (unsigned)fixes_bytes, (unsigned)fixes_block);
+
+    t_bytes = run_parser(nmea_bytes, byte_uart, (const uint8_t *)nmea_stream, nmea_len, fixes_bytes);
+    t_block = run_parser(nmea_block, block_uart, (const uint8_t *)nmea_stream, nmea_len, fixes_block);
+    hal.console->printf("NMEA  %u bytes x %u: single byte port %lu usec, block port %lu usec, fixes %u/%u\n\n",
+                        (unsigned)nmea_len, (unsigned)NUM_REPEATS,
+                        (unsigned long)t_bytes, (unsigned long)t_block,
+                        (unsigned)fixes_bytes, (unsigned)fixes_block);
+
+    hal.scheduler->delay(5000);
+}
+
+AP_HAL_MAIN();
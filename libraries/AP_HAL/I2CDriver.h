@@ -40,6 +40,12 @@ public:
                                           uint8_t* data) = 0;
 #endif
 
+    /* register_periodic_process: optional, run proc every period_us
+       from a thread that serves this bus, so slow devices do not delay
+       the timer thread. Returns false if the HAL has no bus thread, in
+       which case the driver should register a timer process */
+    virtual bool register_periodic_process(AP_HAL::MemberProc proc, uint32_t period_us) { return false; }
+
     virtual uint8_t lockup_count() = 0;
     void ignore_errors(bool b) { _ignore_errors = b; }
     virtual AP_HAL::Semaphore* get_semaphore() = 0;
@@ -39,7 +39,27 @@ public:
     };
 
     virtual void set_bus_speed(enum bus_speed speed) {}
-    
+
+    /**
+       optional queued transfer interface. A batch of transfers is run
+       back to back by a bus thread, with the device selected for the
+       whole batch unless cs_change is set on a transfer, and cb is
+       called from that thread when the batch is complete. The buffers
+       must stay valid until then.
+
+       Returns false if the HAL has no transfer queue or the queue is
+       full, in which case the driver should use transaction()
+     */
+    struct Transfer {
+        const uint8_t *tx;
+        uint8_t *rx;
+        uint16_t len;
+        bool cs_change;     // deselect the device after this transfer
+    };
+
+    virtual bool queue_transfers(const Transfer *transfers, uint8_t count,
+                                 AP_HAL::MemberProc cb) { return false; }
+
 };
 
 #endif // __AP_HAL_SPI_DRIVER_H__
@@ -19,6 +19,22 @@
 #include "utility/print_vprintf.h"
 #include "UARTDriver.h"
 
+/*
+   default block read, for ports without their own
+ */
+uint16_t AP_HAL::UARTDriver::read_bytes(uint8_t *buffer, uint16_t count)
+{
+    uint16_t n = 0;
+    while (n < count) {
+        int16_t c = read();
+        if (c == -1) {
+            break;
+        }
+        buffer[n++] = c;
+    }
+    return n;
+}
+
 /* 
    BetterStream method implementations
    These are implemented in AP_HAL to ensure consistent behaviour on
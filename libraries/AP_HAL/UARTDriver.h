@@ -45,6 +45,11 @@ public:
     virtual void set_flow_control(enum flow_control flow_control_setting) {};
     virtual enum flow_control get_flow_control(void) { return FLOW_CONTROL_DISABLE; };
 
+    /* read up to count received bytes into buffer, returning the
+     * number read. Ports with a receive ring buffer override this to
+     * copy in blocks rather than make a read() call per byte */
+    virtual uint16_t read_bytes(uint8_t *buffer, uint16_t count);
+
     /* Implementations of BetterStream virtual methods. These are
      * provided by AP_HAL to ensure consistency between ports to
      * different boards
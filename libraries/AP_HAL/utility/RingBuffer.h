@@ -19,4 +19,69 @@
 #define BUF_ADVANCETAIL(buf, n) buf##_tail = (buf##_tail + n) % buf##_size
 #define BUF_ADVANCEHEAD(buf, n) buf##_head = (buf##_head + n) % buf##_size
 
+/*
+  memory barrier between writing an object and publishing its index,
+  so the other thread never sees an index before the object it covers
+ */
+#if defined(__AVR__)
+#define RINGBUFFER_BARRIER() __asm__ __volatile__("" ::: "memory")
+#else
+#define RINGBUFFER_BARRIER() __sync_synchronize()
+#endif
+
+/*
+  a lock free ring buffer of objects, for one producer and one
+  consumer. A timer process can push() while the main thread pop()s
+  without suspending timers or taking a semaphore. push() fails when
+  the buffer is full, so it holds at most SIZE-1 objects
+ */
+template <typename T, uint8_t SIZE>
+class ObjectBuffer {
+public:
+    ObjectBuffer() : _head(0), _tail(0) {}
+
+    // number of objects waiting to be popped
+    uint8_t available(void) const {
+        uint8_t head = _head;
+        uint8_t tail = _tail;
+        return (tail >= head) ? tail - head : SIZE - head + tail;
+    }
+
+    bool empty(void) const { return _head == _tail; }
+
+    // add an object. Only called by the producer
+    bool push(const T &object) {
+        uint8_t tail = _tail;
+        uint8_t next = (tail + 1) % SIZE;
+        if (next == _head) {
+            return false;
+        }
+        _buffer[tail] = object;
+        RINGBUFFER_BARRIER();
+        _tail = next;
+        return true;
+    }
+
+    // remove the oldest object. Only called by the consumer
+    bool pop(T &object) {
+        uint8_t head = _head;
+        if (head == _tail) {
+            return false;
+        }
+        RINGBUFFER_BARRIER();
+        object = _buffer[head];
+        RINGBUFFER_BARRIER();
+        _head = (head + 1) % SIZE;
+        return true;
+    }
+
+    // discard all objects. Only called by the consumer
+    void clear(void) { _head = _tail; }
+
+private:
+    T _buffer[SIZE];
+    volatile uint8_t _head;     // next object to pop, written by the consumer
+    volatile uint8_t _tail;     // next free slot, written by the producer
+};
+
 #endif // __AP_HAL_UTILITY_RINGBUFFER_H__
@@ -3,6 +3,7 @@
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
 #include "I2CDriver.h"
+#include "Scheduler.h"
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -17,14 +18,25 @@
 
 using namespace Linux;
 
+extern const AP_HAL::HAL& hal;
+
+// the bus thread only runs slow sensors, so it sits below the main thread
+#define APM_LINUX_I2C_PRIORITY 11
+
+// longest sleep of the bus thread, so new processes start promptly
+#define LINUX_I2C_MAX_SLEEP_US 10000
+
 /*
   constructor
  */
 LinuxI2CDriver::LinuxI2CDriver(AP_HAL::Semaphore* semaphore, const char *device) : 
     _semaphore(semaphore),
     _fd(-1),
-    _device(device)
+    _device(device),
+    _num_procs(0),
+    _thread_started(false)
 {
+    pthread_mutex_init(&_procs_mutex, NULL);
 }
 
 /*
@@ -47,18 +59,20 @@ void LinuxI2CDriver::end()
 }
 
 /*
-  tell the I2C library what device we want to talk to
+  run a list of messages as one combined transfer. Each message carries
+  its own slave address, so no I2C_SLAVE ioctl is needed between
+  devices
  */
-bool LinuxI2CDriver::set_address(uint8_t addr)
+static bool _i2c_rdwr(int fd, struct i2c_msg *msgs, uint32_t nmsgs)
 {
-    if (_fd == -1) {
+    if (fd == -1) {
         return false;
     }
-    if (_addr != addr) {
-        ioctl(_fd, I2C_SLAVE, addr);
-        _addr = addr;
-    }
-    return true;
+    struct i2c_rdwr_ioctl_data i2c_data = {
+    msgs : msgs,
+    nmsgs : nmsgs
+    };
+    return ioctl(fd, I2C_RDWR, &i2c_data) != -1;
 }
 
 void LinuxI2CDriver::setTimeout(uint16_t ms) 
@@ -73,10 +87,15 @@ void LinuxI2CDriver::setHighSpeed(bool active)
 
 uint8_t LinuxI2CDriver::write(uint8_t addr, uint8_t len, uint8_t* data)
 {
-    if (!set_address(addr)) {
-        return 1;
-    }
-    if (::write(_fd, data, len) != len) {
+    struct i2c_msg msgs[] = {
+        {
+        addr  : addr,
+        flags : 0,
+        len   : len,
+        buf   : (typeof(msgs->buf))data
+        }
+    };
+    if (!_i2c_rdwr(_fd, msgs, 1)) {
         return 1;
     }
     return 0; // success
@@ -94,41 +113,27 @@ uint8_t LinuxI2CDriver::writeRegisters(uint8_t addr, uint8_t reg,
     return write(addr, len+1, buf);
 }
 
-/*
-  this is a copy of i2c_smbus_access() from i2c-dev.h. We need it for
-  platforms with older headers
- */
-static inline __s32 _i2c_smbus_access(int file, char read_write, __u8 command, 
-                                      int size, union i2c_smbus_data *data)
-{
-	struct i2c_smbus_ioctl_data args;
-	args.read_write = read_write;
-	args.command = command;
-	args.size = size;
-	args.data = data;
-	return ioctl(file,I2C_SMBUS,&args);
-}
-
 uint8_t LinuxI2CDriver::writeRegister(uint8_t addr, uint8_t reg, uint8_t val)
 {
-    if (!set_address(addr)) {
-        return 1;
-    }
-    union i2c_smbus_data data;
-    data.byte = val;
-    if (_i2c_smbus_access(_fd,I2C_SMBUS_WRITE, reg,
-                         I2C_SMBUS_BYTE_DATA, &data) == -1) {
-        return 1;
-    }
-    return 0;
+    uint8_t buf[2] = { reg, val };
+    return write(addr, 2, buf);
 }
 
 uint8_t LinuxI2CDriver::read(uint8_t addr, uint8_t len, uint8_t* data)
 {
-    if (!set_address(addr)) {
-        return 1;
-    }
-    if (::read(_fd, data, len) != len) {
+    struct i2c_msg msgs[] = {
+        {
+        addr  : addr,
+        flags : I2C_M_RD,
+        len   : len,
+        buf   : (typeof(msgs->buf))data
+        }
+    };
+
+    // prevent valgrind error
+    memset(data, 0, len);
+
+    if (!_i2c_rdwr(_fd, msgs, 1)) {
         return 1;
     }
     return 0;
@@ -137,9 +142,6 @@ uint8_t LinuxI2CDriver::read(uint8_t addr, uint8_t len, uint8_t* data)
 uint8_t LinuxI2CDriver::readRegisters(uint8_t addr, uint8_t reg,
                                       uint8_t len, uint8_t* data)
 {
-    if (_fd == -1) {
-        return 1;
-    }
     struct i2c_msg msgs[] = {
         {
         addr  : addr,
@@ -154,15 +156,11 @@ uint8_t LinuxI2CDriver::readRegisters(uint8_t addr, uint8_t reg,
         buf   : (typeof(msgs->buf))data,
         }
     };
-    struct i2c_rdwr_ioctl_data i2c_data = {
-    msgs : msgs,
-    nmsgs : 2
-    };
 
     // prevent valgrind error
     memset(data, 0, len);
 
-    if (ioctl(_fd, I2C_RDWR, &i2c_data) == -1) {
+    if (!_i2c_rdwr(_fd, msgs, 2)) {
         return 1;
     }
 
@@ -180,10 +178,6 @@ uint8_t LinuxI2CDriver::readRegistersMultiple(uint8_t addr, uint8_t reg,
     while (count > 0) {
         uint8_t n = count>8?8:count;
         struct i2c_msg msgs[2*n];
-        struct i2c_rdwr_ioctl_data i2c_data = {
-        msgs : msgs,
-        nmsgs : (typeof(i2c_data.nmsgs))(2*n)
-        };
         for (uint8_t i=0; i<n; i++) {
             msgs[i*2].addr = addr;
             msgs[i*2].flags = 0;
@@ -195,7 +189,7 @@ uint8_t LinuxI2CDriver::readRegistersMultiple(uint8_t addr, uint8_t reg,
             msgs[i*2+1].buf = (typeof(msgs->buf))data;
             data += len;
         };
-        if (ioctl(_fd, I2C_RDWR, &i2c_data) == -1) {
+        if (!_i2c_rdwr(_fd, msgs, 2*n)) {
             return 1;
         }
         count -= n;
@@ -206,17 +200,79 @@ uint8_t LinuxI2CDriver::readRegistersMultiple(uint8_t addr, uint8_t reg,
 
 uint8_t LinuxI2CDriver::readRegister(uint8_t addr, uint8_t reg, uint8_t* data)
 {
-    if (!set_address(addr)) {
-        return 1;
+    return readRegisters(addr, reg, 1, data);
+}
+
+/*
+  add a device process to the bus thread, starting the thread on the
+  first call
+ */
+bool LinuxI2CDriver::register_periodic_process(AP_HAL::MemberProc proc, uint32_t period_us)
+{
+    if (period_us == 0) {
+        return false;
     }
-    union i2c_smbus_data v;
-    memset(&v, 0, sizeof(v));
-    if (_i2c_smbus_access(_fd,I2C_SMBUS_READ, reg,
-                          I2C_SMBUS_BYTE_DATA, &v)) {
-        return 1;
+    pthread_mutex_lock(&_procs_mutex);
+    if (_num_procs == LINUX_I2C_MAX_PROCS) {
+        pthread_mutex_unlock(&_procs_mutex);
+        return false;
     }
-    *data = v.byte;
-    return 0;
+    struct periodic_proc &p = _procs[_num_procs];
+    p.proc = proc;
+    p.period_us = period_us;
+    p.next_run_us = hal.scheduler->micros64();
+    _num_procs++;
+    pthread_mutex_unlock(&_procs_mutex);
+
+    if (!_thread_started) {
+        _thread_started = true;
+        ((LinuxScheduler *)hal.scheduler)->create_realtime_thread(&_thread, APM_LINUX_I2C_PRIORITY,
+                                                                  "i2c-bus", &LinuxI2CDriver::_bus_thread, this);
+    }
+    return true;
+}
+
+/*
+  run the processes that are due, returning the time the next one is
+  due. A process that overruns skips its missed runs rather than
+  running back to back
+ */
+uint64_t LinuxI2CDriver::_run_procs(void)
+{
+    uint64_t now = hal.scheduler->micros64();
+    uint64_t next_run_us = now + LINUX_I2C_MAX_SLEEP_US;
+
+    pthread_mutex_lock(&_procs_mutex);
+    for (uint8_t i=0; i<_num_procs; i++) {
+        struct periodic_proc &p = _procs[i];
+        if (now >= p.next_run_us) {
+            p.proc();
+            p.next_run_us += p.period_us;
+            if (p.next_run_us <= now) {
+                p.next_run_us = now + p.period_us;
+            }
+        }
+        if (p.next_run_us < next_run_us) {
+            next_run_us = p.next_run_us;
+        }
+    }
+    pthread_mutex_unlock(&_procs_mutex);
+
+    return next_run_us;
+}
+
+void *LinuxI2CDriver::_bus_thread(void *arg)
+{
+    LinuxI2CDriver *i2c = (LinuxI2CDriver *)arg;
+
+    while (true) {
+        uint64_t next_run_us = i2c->_run_procs();
+        uint64_t now = hal.scheduler->micros64();
+        if (next_run_us > now) {
+            hal.scheduler->delay_microseconds(next_run_us - now);
+        }
+    }
+    return NULL;
 }
 
 uint8_t LinuxI2CDriver::lockup_count() 
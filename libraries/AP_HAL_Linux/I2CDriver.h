@@ -3,6 +3,10 @@
 #define __AP_HAL_LINUX_I2CDRIVER_H__
 
 #include <AP_HAL_Linux.h>
+#include <pthread.h>
+
+// devices that can be run from the bus thread
+#define LINUX_I2C_MAX_PROCS 8
 
 class Linux::LinuxI2CDriver : public AP_HAL::I2CDriver {
 public:
@@ -36,16 +40,30 @@ public:
                                   uint8_t len, uint8_t count, 
                                   uint8_t* data);
 
+    bool register_periodic_process(AP_HAL::MemberProc proc, uint32_t period_us);
+
     uint8_t lockup_count();
 
     AP_HAL::Semaphore* get_semaphore() { return _semaphore; }
 
 private:
     AP_HAL::Semaphore* _semaphore;
-    bool set_address(uint8_t addr);
     int _fd;
-    uint8_t _addr;
     const char *_device;
+
+    // devices run from the bus thread, each at its own rate
+    struct periodic_proc {
+        AP_HAL::MemberProc proc;
+        uint32_t period_us;
+        uint64_t next_run_us;
+    } _procs[LINUX_I2C_MAX_PROCS];
+    uint8_t _num_procs;
+    bool _thread_started;
+    pthread_t _thread;
+    pthread_mutex_t _procs_mutex;
+
+    static void *_bus_thread(void *arg);
+    uint64_t _run_procs(void);
 };
 
 #endif // __AP_HAL_LINUX_I2CDRIVER_H__
@@ -12,9 +12,14 @@
 #include <sys/ioctl.h>
 #include <linux/spi/spidev.h>
 #include "GPIO.h"
+#include "Scheduler.h"
 
 #define SPI_DEBUGGING 0
 
+// bus threads run above the timer thread, so a batch queued from a
+// timer process completes before the next timer tick
+#define APM_LINUX_SPI_PRIORITY 16
+
 using namespace Linux;
 
 extern const AP_HAL::HAL& hal;
@@ -53,6 +58,9 @@ LinuxSPIDeviceDriver LinuxSPIDeviceManager::_device[0];
 // have a separate semaphore per bus
 LinuxSemaphore LinuxSPIDeviceManager::_semaphore[LINUX_SPI_MAX_BUSES];
 
+// and a transfer queue per bus, started in init()
+struct LinuxSPIDeviceManager::bus_queue LinuxSPIDeviceManager::_queue[LINUX_SPI_MAX_BUSES];
+
 LinuxSPIDeviceDriver::LinuxSPIDeviceDriver(uint16_t bus, uint16_t subdev, enum AP_HAL::SPIDevice type, uint8_t mode, uint8_t bitsPerWord, int16_t cs_pin, uint32_t lowspeed, uint32_t highspeed):
     _bus(bus),
     _subdev(subdev),
@@ -92,6 +100,11 @@ void LinuxSPIDeviceDriver::transaction(const uint8_t *tx, uint8_t *rx, uint16_t
     LinuxSPIDeviceManager::transaction(*this, tx, rx, len);
 }
 
+bool LinuxSPIDeviceDriver::queue_transfers(const Transfer *transfers, uint8_t count, AP_HAL::MemberProc cb)
+{
+    return LinuxSPIDeviceManager::queue_transfers(*this, transfers, count, cb);
+}
+
 void LinuxSPIDeviceDriver::set_bus_speed(enum bus_speed speed)
 {
     if (speed == SPI_SPEED_LOW) {
@@ -143,6 +156,30 @@ void LinuxSPIDeviceManager::init(void *)
 #endif
         _device[i].init();
     }
+
+    // start a transfer thread for each bus in use
+    for (uint8_t b=0; b<LINUX_SPI_MAX_BUSES; b++) {
+        uint8_t i;
+        for (i=0; i<LINUX_SPI_DEVICE_NUM_DEVICES; i++) {
+            if (_device[i]._bus == b) {
+                break;
+            }
+        }
+        if (i == LINUX_SPI_DEVICE_NUM_DEVICES) {
+            continue;
+        }
+        struct bus_queue &q = _queue[b];
+        q.bus = b;
+        q.head = 0;
+        q.count = 0;
+        pthread_mutex_init(&q.mutex, NULL);
+        pthread_cond_init(&q.cond, NULL);
+        char name[16];
+        snprintf(name, sizeof(name), "spi-bus%u", (unsigned)b);
+        ((LinuxScheduler *)hal.scheduler)->create_realtime_thread(&q.thread, APM_LINUX_SPI_PRIORITY,
+                                                                  name, &LinuxSPIDeviceManager::_bus_thread, &q);
+        q.running = true;
+    }
 }
 
 void LinuxSPIDeviceManager::cs_assert(enum AP_HAL::SPIDevice type)
@@ -233,6 +270,107 @@ void LinuxSPIDeviceManager::transaction(LinuxSPIDeviceDriver &driver, const uint
     cs_release(driver._type);
 }
 
+/*
+  add a batch to the queue of the device's bus
+ */
+bool LinuxSPIDeviceManager::queue_transfers(LinuxSPIDeviceDriver &driver,
+                                            const AP_HAL::SPIDeviceDriver::Transfer *transfers, uint8_t count,
+                                            AP_HAL::MemberProc cb)
+{
+    struct bus_queue &q = _queue[driver._bus];
+    if (!q.running || count == 0 || count > LINUX_SPI_MAX_TRANSFERS) {
+        return false;
+    }
+
+    pthread_mutex_lock(&q.mutex);
+    if (q.count == LINUX_SPI_QUEUE_LENGTH) {
+        pthread_mutex_unlock(&q.mutex);
+        return false;
+    }
+    struct spi_batch &batch = q.batch[(q.head + q.count) % LINUX_SPI_QUEUE_LENGTH];
+    batch.driver = &driver;
+    memcpy(batch.transfers, transfers, count * sizeof(transfers[0]));
+    batch.count = count;
+    batch.cb = cb;
+    q.count++;
+    pthread_cond_signal(&q.cond);
+    pthread_mutex_unlock(&q.mutex);
+    return true;
+}
+
+/*
+  run queued batches in order. The bus semaphore is held for each
+  batch to keep out blocking transactions from other threads, and the
+  callback is made after it is released so it can queue the next batch
+ */
+void *LinuxSPIDeviceManager::_bus_thread(void *arg)
+{
+    struct bus_queue &q = *(struct bus_queue *)arg;
+
+    while (true) {
+        pthread_mutex_lock(&q.mutex);
+        while (q.count == 0) {
+            pthread_cond_wait(&q.cond, &q.mutex);
+        }
+        struct spi_batch batch = q.batch[q.head];
+        q.head = (q.head + 1) % LINUX_SPI_QUEUE_LENGTH;
+        q.count--;
+        pthread_mutex_unlock(&q.mutex);
+
+        _semaphore[q.bus].take(0);
+        _run_batch(batch);
+        _semaphore[q.bus].give();
+
+        if (batch.cb) {
+            batch.cb();
+        }
+    }
+    return NULL;
+}
+
+/*
+  run a batch with as few ioctls as possible. The kernel handles
+  cs_change itself, but a GPIO chip select has to be toggled between
+  messages, so a batch is split into one message per selection
+ */
+void LinuxSPIDeviceManager::_run_batch(const struct spi_batch &batch)
+{
+    LinuxSPIDeviceDriver &driver = *batch.driver;
+    const bool kernel_cs = (driver._cs_pin == SPI_CS_KERNEL);
+    struct spi_ioc_transfer spi[LINUX_SPI_MAX_TRANSFERS];
+    memset(spi, 0, sizeof(spi));
+
+    ioctl(driver._fd, SPI_IOC_WR_MODE, &driver._mode);
+
+    uint8_t start = 0;
+    for (uint8_t i=0; i<batch.count; i++) {
+        const AP_HAL::SPIDeviceDriver::Transfer &t = batch.transfers[i];
+        const bool last = (i == batch.count - 1);
+        spi[i].tx_buf        = (uint64_t)t.tx;
+        spi[i].rx_buf        = (uint64_t)t.rx;
+        spi[i].len           = t.len;
+        spi[i].speed_hz      = driver._speed;
+        spi[i].bits_per_word = driver._bitsPerWord;
+        if (t.rx != NULL) {
+            // keep valgrind happy
+            memset(t.rx, 0, t.len);
+        }
+        if (kernel_cs) {
+            // on the last transfer cs_change would leave the device selected
+            spi[i].cs_change = t.cs_change && !last;
+        } else if (t.cs_change || last) {
+            cs_assert(driver._type);
+            ioctl(driver._fd, SPI_IOC_MESSAGE(i + 1 - start), &spi[start]);
+            cs_release(driver._type);
+            start = i + 1;
+        }
+    }
+
+    if (kernel_cs) {
+        ioctl(driver._fd, SPI_IOC_MESSAGE(batch.count), spi);
+    }
+}
+
 /*
   return a SPIDeviceDriver for a particular device
  */
@@ -22,6 +22,10 @@
 
 #define LINUX_SPI_MAX_BUSES 3
 
+// queued batches per bus, and transfers per batch
+#define LINUX_SPI_QUEUE_LENGTH 8
+#define LINUX_SPI_MAX_TRANSFERS 4
+
 // Fake CS pin to indicate in-kernel handling
 #define SPI_CS_KERNEL -1
 
@@ -38,6 +42,7 @@ public:
     uint8_t transfer (uint8_t data);
     void transfer (const uint8_t *data, uint16_t len);
     void set_bus_speed(enum bus_speed speed);
+    bool queue_transfers(const Transfer *transfers, uint8_t count, AP_HAL::MemberProc cb);
 
 private:
     uint16_t _bus;
@@ -63,10 +68,36 @@ public:
     static void cs_assert(enum AP_HAL::SPIDevice type);
     static void cs_release(enum AP_HAL::SPIDevice type);
     static void transaction(LinuxSPIDeviceDriver &driver, const uint8_t *tx, uint8_t *rx, uint16_t len);
+    static bool queue_transfers(LinuxSPIDeviceDriver &driver,
+                                const AP_HAL::SPIDeviceDriver::Transfer *transfers, uint8_t count,
+                                AP_HAL::MemberProc cb);
 
 private:
     static LinuxSPIDeviceDriver _device[LINUX_SPI_DEVICE_NUM_DEVICES];
     static LinuxSemaphore _semaphore[LINUX_SPI_MAX_BUSES];
+
+    struct spi_batch {
+        LinuxSPIDeviceDriver *driver;
+        AP_HAL::SPIDeviceDriver::Transfer transfers[LINUX_SPI_MAX_TRANSFERS];
+        uint8_t count;
+        AP_HAL::MemberProc cb;
+    };
+
+    // batches waiting for the bus thread, filled from any thread
+    struct bus_queue {
+        uint8_t bus;
+        bool running;
+        pthread_t thread;
+        pthread_mutex_t mutex;
+        pthread_cond_t cond;
+        struct spi_batch batch[LINUX_SPI_QUEUE_LENGTH];
+        uint8_t head;
+        uint8_t count;
+    };
+    static struct bus_queue _queue[LINUX_SPI_MAX_BUSES];
+
+    static void *_bus_thread(void *arg);
+    static void _run_batch(const struct spi_batch &batch);
 };
 
 #endif // __AP_HAL_LINUX_SPIDRIVER_H__
@@ -30,9 +30,10 @@ extern const AP_HAL::HAL& hal;
 LinuxScheduler::LinuxScheduler()
 {}
 
-void LinuxScheduler::_create_realtime_thread(pthread_t *ctx, int rtprio,
-                                             const char *name,
-                                             pthread_startroutine_t start_routine)
+void LinuxScheduler::create_realtime_thread(pthread_t *ctx, int rtprio,
+                                            const char *name,
+                                            pthread_startroutine_t start_routine,
+                                            void *arg)
 {
     struct sched_param param = { .sched_priority = rtprio };
     pthread_attr_t attr;
@@ -49,7 +50,7 @@ void LinuxScheduler::_create_realtime_thread(pthread_t *ctx, int rtprio,
         pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
         pthread_attr_setschedparam(&attr, &param);
     }
-    r = pthread_create(ctx, &attr, start_routine, this);
+    r = pthread_create(ctx, &attr, start_routine, arg);
     if (r != 0) {
         hal.console->printf("Error creating thread '%s': %s\n",
                             name, strerror(r));
@@ -110,8 +111,8 @@ void LinuxScheduler::init(void* machtnichts)
     }
 
     for (iter = table; iter->ctx; iter++)
-        _create_realtime_thread(iter->ctx, iter->rtprio, iter->name,
-                                iter->start_routine);
+        create_realtime_thread(iter->ctx, iter->rtprio, iter->name,
+                               iter->start_routine, this);
 }
 
 void LinuxScheduler::_microsleep(uint32_t usec)
@@ -14,9 +14,9 @@
 
 class Linux::LinuxScheduler : public AP_HAL::Scheduler {
 
-typedef void *(*pthread_startroutine_t)(void *);
-
 public:
+    typedef void *(*pthread_startroutine_t)(void *);
+
     LinuxScheduler();
     void     init(void* machtnichts);
     void     delay(uint16_t ms);
@@ -48,6 +48,12 @@ public:
 
     void     stop_clock(uint64_t time_usec);
 
+    // create a thread with SCHED_FIFO priority rtprio, passing arg to
+    // start_routine. Used for HAL threads outside the scheduler, such
+    // as the SPI bus threads
+    void     create_realtime_thread(pthread_t *ctx, int rtprio, const char *name,
+                                    pthread_startroutine_t start_routine, void *arg);
+
 private:
     struct timespec _sketch_start_time;    
     void _timer_handler(int signum);
@@ -85,8 +91,6 @@ private:
 
     void _run_timers(bool called_from_timer_thread);
     void _run_io(void);
-    void _create_realtime_thread(pthread_t *ctx, int rtprio, const char *name,
-                                 pthread_startroutine_t start_routine);
 
     uint64_t stopped_clock_usec;
 
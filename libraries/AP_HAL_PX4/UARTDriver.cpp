@@ -287,6 +287,37 @@ int16_t PX4UARTDriver::read()
 	return c;
 }
 
+/*
+  read a block of bytes from the receive buffer
+ */
+uint16_t PX4UARTDriver::read_bytes(uint8_t *buffer, uint16_t count)
+{
+    if (_uart_owner_pid != getpid()) {
+        return 0;
+    }
+    if (!_initialised) {
+        try_initialise();
+        return 0;
+    }
+    if (_readbuf == NULL) {
+        return 0;
+    }
+    uint16_t _tail;
+    uint16_t avail = BUF_AVAILABLE(_readbuf);
+    if (count > avail) {
+        count = avail;
+    }
+    // copy up to the end of the buffer, then from the start
+    uint16_t n = _readbuf_size - _readbuf_head;
+    if (n > count) {
+        n = count;
+    }
+    memcpy(buffer, &_readbuf[_readbuf_head], n);
+    memcpy(&buffer[n], _readbuf, count - n);
+    BUF_ADVANCEHEAD(_readbuf, count);
+    return count;
+}
+
 /* 
    write one byte to the buffer
  */
@@ -7,6 +7,9 @@
 #include <AP_HAL.h>
 #include <AP_Notify.h>
 #include <AP_Vehicle.h>
+#if INS_DYNAMIC_NOTCH || INS_VOTING
+#include <DataFlash.h>
+#endif
 
 /*
   enable TIMING_DEBUG to track down scheduling issues with the main
@@ -264,6 +267,73 @@ const AP_Param::GroupInfo AP_InertialSensor::var_info[] PROGMEM = {
     // @User: Advanced
     AP_GROUPINFO("ACCEL_FILTER", 19, AP_InertialSensor, _accel_filter_cutoff,  DEFAULT_ACCEL_FILTER),
 
+    // @Param: GYRO_RATE
+    // @DisplayName: Gyro raw sample rate
+    // @Description: Rate at which gyros that support it are sampled, in kHz. Higher rates are filtered and integrated in the sensor driver and decimated to the main loop rate, which stops high frequency vibration aliasing into the attitude controller. Currently only used by the MPU9250, which supports 1kHz and 8kHz. This option takes effect on the next reboot.
+    // @Values: 1:1kHz,8:8kHz
+    // @User: Advanced
+    AP_GROUPINFO("GYRO_RATE",   20, AP_InertialSensor, _gyro_raw_rate_khz,  1),
+
+#if INS_DYNAMIC_NOTCH
+    // @Param: NOTCH_ENABLE
+    // @DisplayName: Dynamic gyro notch enable
+    // @Description: Enables notch filters on the gyros that follow the strongest vibration peaks found by a spectrum analysis of the primary gyro. Use this to remove motor and propeller noise that moves with throttle. The notch is run by the MPU6000 on boards that sample it at 1kHz, the MPU9250 and the PX4 IMU drivers. Other IMUs are not filtered. This option takes effect on the next reboot.
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    AP_GROUPINFO("NOTCH_ENABLE", 21, AP_InertialSensor, _notch_enable,  0),
+
+    // @Param: NOTCH_MIN_HZ
+    // @DisplayName: Dynamic gyro notch minimum frequency
+    // @Description: Lowest vibration frequency the dynamic notch will track. This should be above the bandwidth of the attitude controllers
+    // @Units: Hz
+    // @Range: 20 400
+    // @User: Advanced
+    AP_GROUPINFO("NOTCH_MIN_HZ", 22, AP_InertialSensor, _notch_min_hz,  80),
+
+    // @Param: NOTCH_MAX_HZ
+    // @DisplayName: Dynamic gyro notch maximum frequency
+    // @Description: Highest vibration frequency the dynamic notch will track. Peaks are only found below half of the analysis rate of about 1kHz
+    // @Units: Hz
+    // @Range: 40 500
+    // @User: Advanced
+    AP_GROUPINFO("NOTCH_MAX_HZ", 23, AP_InertialSensor, _notch_max_hz,  400),
+
+    // @Param: NOTCH_BW_HZ
+    // @DisplayName: Dynamic gyro notch bandwidth
+    // @Description: Width of each notch filter at -3dB. Wider notches cope better with a peak that moves quickly but add more phase lag below the notch
+    // @Units: Hz
+    // @Range: 5 200
+    // @User: Advanced
+    AP_GROUPINFO("NOTCH_BW_HZ",  24, AP_InertialSensor, _notch_bw_hz,  40),
+#endif
+
+#if INS_VOTING
+    // @Param: VOTE_GYR
+    // @DisplayName: Gyro voting threshold
+    // @Description: Disagreement of a gyro with the median of the others, after removing their learnt difference, above which it is no longer used as the primary gyro or blended. It still counts as healthy for arming. Set to zero to disable gyro voting
+    // @Units: deg/s
+    // @Range: 0 30
+    // @User: Advanced
+    AP_GROUPINFO("VOTE_GYR",  25, AP_InertialSensor, _vote_gyro_thresh,  AP_INERTIAL_SENSOR_VOTE_GYRO_DEFAULT),
+
+    // @Param: VOTE_ACC
+    // @DisplayName: Accelerometer voting threshold
+    // @Description: Disagreement of an accelerometer with the median of the others, after removing their learnt difference, above which it is no longer used as the primary accelerometer or blended. It still counts as healthy for arming. Set to zero to disable accelerometer voting
+    // @Units: m/s/s
+    // @Range: 0 10
+    // @User: Advanced
+    AP_GROUPINFO("VOTE_ACC",  26, AP_InertialSensor, _vote_accel_thresh,  AP_INERTIAL_SENSOR_VOTE_ACCEL_DEFAULT),
+
+    // @Param: VOTE_TC
+    // @DisplayName: Voting error time constant
+    // @Description: Time constant of the filter on the disagreement compared with the voting thresholds. Longer times ride through short vibration peaks but react more slowly to a failure
+    // @Units: seconds
+    // @Range: 0.001 1
+    // @User: Advanced
+    AP_GROUPINFO("VOTE_TC",   27, AP_InertialSensor, _vote_error_tc,  AP_INERTIAL_SENSOR_VOTE_TC_DEFAULT),
+#endif
+
+
     /*
       NOTE: parameter indexes have gaps above. When adding new
       parameters check for conflicts carefully
@@ -295,11 +365,35 @@ AP_InertialSensor::AP_InertialSensor(AP_AccelCal& acal) :
     for (uint8_t i=0; i<INS_MAX_INSTANCES; i++) {
         _accel_error_count[i] = 0;
         _gyro_error_count[i] = 0;
+        _accel_vibe_level[i].zero();
+        _accel_clip_limit[i] = AP_INERTIAL_SENSOR_ACCEL_CLIP_THRESH_MSS;
+        _accel_clip_count[i] = 0;
+        _dropped_sample_count[i] = 0;
+#if INS_VOTING
+        _gyro_vote[i].error = 0;
+        _gyro_vote[i].voted_out = false;
+        _gyro_vote[i].agree_start_ms = 0;
+        _accel_vote[i].error = 0;
+        _accel_vote[i].voted_out = false;
+        _accel_vote[i].agree_start_ms = 0;
+#endif
     }
+#if INS_VOTING
+    _gyros_consistent = true;
+    _accels_consistent = true;
+    _vote_log_ms = 0;
+#endif
     memset(_delta_velocity_valid,0,sizeof(_delta_velocity_valid));
     memset(_delta_angle_valid,0,sizeof(_delta_angle_valid));
     memset(_accel_startup_error_count,0,sizeof(_accel_startup_error_count));
     memset(_gyro_startup_error_count,0,sizeof(_gyro_startup_error_count));
+#if INS_DYNAMIC_NOTCH
+    memset(_gyro_raw_sample_rate,0,sizeof(_gyro_raw_sample_rate));
+    memset(_notch_center_hz,0,sizeof(_notch_center_hz));
+    memset(_notch_unsent,0,sizeof(_notch_unsent));
+    memset(_notch_loaded_hz,0,sizeof(_notch_loaded_hz));
+    memset(_notch_reload,0,sizeof(_notch_reload));
+#endif
 
     _acal.register_client(this);
 }
@@ -335,6 +429,12 @@ AP_InertialSensor::init( Start_style style,
     _sample_rate = sample_rate;
 
     if (_gyro_count == 0 && _accel_count == 0) {
+#if INS_DYNAMIC_NOTCH
+        // the buffers must exist before the backends start sampling
+        if (_notch_enable != 0 && !_gyro_fft.init()) {
+            hal.console->println_P(PSTR("INS: no memory for gyro FFT"));
+        }
+#endif
         // detect available backends. Only called once
         _detect_backends();
     }
@@ -1134,24 +1234,353 @@ void AP_InertialSensor::update(void)
             }
         }
 
-        // set primary to first healthy accel and gyro
+#if INS_VOTING
+        _update_voting();
+#endif
+
+        // set primary to first healthy accel and gyro that has not
+        // been voted out
         for (uint8_t i=0; i<INS_MAX_INSTANCES; i++) {
-            if (_gyro_healthy[i]) {
+            if (use_gyro(i)) {
                 _primary_gyro = i;
                 break;
             }
         }
         for (uint8_t i=0; i<INS_MAX_INSTANCES; i++) {
-            if (_accel_healthy[i]) {
+            if (use_accel(i)) {
                 _primary_accel = i;
                 break;
             }
         }
+
+#if INS_DYNAMIC_NOTCH
+        if (_notch_enable != 0) {
+            _update_dynamic_notch();
+        }
+#endif
     }
 
     _have_sample = false;
 }
 
+#if INS_DYNAMIC_NOTCH
+/*
+  move the notch centers towards the peaks of the latest gyro
+  spectrum. Each peak moves the nearest notch in use, and a peak with
+  no notch near it starts an unused one. A notch whose peak has gone
+  is left where it was, so a peak that drops below the threshold for
+  one window does not cause the filter to be reset
+ */
+void AP_InertialSensor::_update_dynamic_notch(void)
+{
+    if (_gyro_fft.update(_notch_min_hz, _notch_max_hz)) {
+        const uint8_t num_peaks = min(_gyro_fft.get_num_peaks(), INS_NOTCH_PEAKS);
+        bool peak_matched[INS_NOTCH_PEAKS] = {};
+        bool notch_matched[INS_NOTCH_PEAKS] = {};
+        float target_hz[INS_NOTCH_PEAKS];
+        memcpy(target_hz, _notch_center_hz, sizeof(target_hz));
+
+        // pair peaks with notches in use, closest pair first
+        while (true) {
+            int8_t best_peak = -1, best_notch = -1;
+            float best_dist = 0;
+            for (uint8_t p=0; p<num_peaks; p++) {
+                if (peak_matched[p]) {
+                    continue;
+                }
+                for (uint8_t n=0; n<INS_NOTCH_PEAKS; n++) {
+                    if (notch_matched[n] || is_zero(_notch_center_hz[n])) {
+                        continue;
+                    }
+                    float dist = fabsf(_gyro_fft.get_peak_freq(p) - _notch_center_hz[n]);
+                    if (best_peak < 0 || dist < best_dist) {
+                        best_peak = p;
+                        best_notch = n;
+                        best_dist = dist;
+                    }
+                }
+            }
+            if (best_peak < 0) {
+                break;
+            }
+            peak_matched[best_peak] = true;
+            notch_matched[best_notch] = true;
+            const float peak = _gyro_fft.get_peak_freq(best_peak);
+            target_hz[best_notch] += 0.3f * (peak - _notch_center_hz[best_notch]);
+        }
+
+        // remaining peaks start the unused notches
+        for (uint8_t p=0; p<num_peaks; p++) {
+            if (peak_matched[p]) {
+                continue;
+            }
+            for (uint8_t n=0; n<INS_NOTCH_PEAKS; n++) {
+                if (!notch_matched[n] && is_zero(_notch_center_hz[n])) {
+                    notch_matched[n] = true;
+                    target_hz[n] = _gyro_fft.get_peak_freq(p);
+                    break;
+                }
+            }
+        }
+
+        bool changed = false;
+        for (uint8_t n=0; n<INS_NOTCH_PEAKS; n++) {
+            if (fabsf(target_hz[n] - _notch_center_hz[n]) > 0.5f) {
+                _notch_center_hz[n] = target_hz[n];
+                changed = true;
+            }
+        }
+        if (changed) {
+            for (uint8_t i=0; i<INS_MAX_INSTANCES; i++) {
+                _notch_unsent[i] = true;
+            }
+        }
+
+        _log_dynamic_notch();
+    }
+
+    // hand the centers to the backends, which load them between
+    // samples on their own threads
+    for (uint8_t i=0; i<_gyro_count; i++) {
+        if (!_notch_unsent[i]) {
+            continue;
+        }
+        notch_centers centers;
+        memcpy(centers.hz, _notch_center_hz, sizeof(centers.hz));
+        if (_notch_queue[i].push(centers)) {
+            _notch_unsent[i] = false;
+        }
+    }
+}
+
+/*
+  log the detected peaks and notch centers, and when raw logging is
+  enabled the whole spectrum
+ */
+void AP_InertialSensor::_log_dynamic_notch(void)
+{
+    if (_dataflash == NULL) {
+        return;
+    }
+    uint32_t now = hal.scheduler->millis();
+
+    struct log_FTN ftn = {
+        LOG_PACKET_HEADER_INIT(LOG_FTN_MSG),
+        time_ms     : now,
+        peak_freq   : { _gyro_fft.get_peak_freq(0), _gyro_fft.get_peak_freq(1) },
+        peak_energy : { _gyro_fft.get_peak_energy(0), _gyro_fft.get_peak_energy(1) },
+        notch_freq  : { _notch_center_hz[0], _notch_center_hz[1] }
+    };
+    _dataflash->WriteBlock(&ftn, sizeof(ftn));
+
+    if (!_log_raw_data) {
+        return;
+    }
+    const float *spectrum = _gyro_fft.get_spectrum();
+    for (uint8_t ofs=0; ofs<INS_FFT_SIZE/2; ofs += 8) {
+        struct log_FFT fft = {
+            LOG_PACKET_HEADER_INIT(LOG_FFT_MSG),
+            time_ms   : now,
+            first_bin : ofs
+        };
+        for (uint8_t i=0; i<8; i++) {
+            float db = 10 * log10f(max(spectrum[ofs+i], 1.0e-12f));
+            fft.bin[i] = constrain_float(db * 100, -32000, 32000);
+        }
+        _dataflash->WriteBlock(&fft, sizeof(fft));
+    }
+}
+#endif // INS_DYNAMIC_NOTCH
+
+#if INS_VOTING
+/*
+  median of n values, sorting them in place
+ */
+static float vote_median(float *v, uint8_t n)
+{
+    for (uint8_t i=1; i<n; i++) {
+        float x = v[i];
+        uint8_t j = i;
+        while (j > 0 && v[j-1] > x) {
+            v[j] = v[j-1];
+            j--;
+        }
+        v[j] = x;
+    }
+    if (n & 1) {
+        return v[n/2];
+    }
+    return 0.5f * (v[n/2-1] + v[n/2]);
+}
+
+/*
+  compare the redundant gyros and accels, and vote out any that
+  disagree with the others so the primary selection and the EKF stop
+  using them on this loop
+ */
+void AP_InertialSensor::_update_voting(void)
+{
+    // offsets are not valid while calibrating
+    bool calibrating = _calibrating;
+    for (uint8_t i=0; i<_accel_count; i++) {
+        accel_cal_status_t status = _accel_calibrator[i].get_status();
+        if (status == ACCEL_CAL_WAITING_FOR_ORIENTATION || status == ACCEL_CAL_COLLECTING_SAMPLE) {
+            calibrating = true;
+        }
+    }
+    if (calibrating) {
+        return;
+    }
+
+    const uint8_t last_gyro_out = _vote_mask(_gyro_vote);
+    const uint8_t last_accel_out = _vote_mask(_accel_vote);
+
+    _gyros_consistent = _vote(_gyro, _gyro_healthy, _gyro_count, _gyro_vote,
+                              radians(_vote_gyro_thresh));
+    _accels_consistent = _vote(_accel, _accel_healthy, _accel_count, _accel_vote,
+                               _vote_accel_thresh);
+
+    if (_dataflash == NULL || (_gyro_count < 2 && _accel_count < 2)) {
+        return;
+    }
+
+    // log at 10Hz, and straight away when a vote changes
+    const uint8_t gyro_out = _vote_mask(_gyro_vote);
+    const uint8_t accel_out = _vote_mask(_accel_vote);
+    uint32_t now = hal.scheduler->millis();
+    if (now - _vote_log_ms < 100 && gyro_out == last_gyro_out && accel_out == last_accel_out) {
+        return;
+    }
+    _vote_log_ms = now;
+
+    struct log_Vote pkt = {
+        LOG_PACKET_HEADER_INIT(LOG_VOTE_MSG),
+        time_ms       : now,
+        gyro_error    : { _gyro_vote[0].error, _gyro_vote[1].error, _gyro_vote[2].error },
+        accel_error   : { _accel_vote[0].error, _accel_vote[1].error, _accel_vote[2].error },
+        gyro_out      : gyro_out,
+        accel_out     : accel_out,
+        consistent    : (uint8_t)(_gyros_consistent | (_accels_consistent << 1)),
+        primary_gyro  : _primary_gyro,
+        primary_accel : _primary_accel
+    };
+    _dataflash->WriteBlock(&pkt, sizeof(pkt));
+}
+
+// mask of the voted out instances
+uint8_t AP_InertialSensor::_vote_mask(const vote_state *vote) const
+{
+    uint8_t mask = 0;
+    for (uint8_t i=0; i<INS_MAX_INSTANCES; i++) {
+        if (vote[i].voted_out) {
+            mask |= 1U << i;
+        }
+    }
+    return mask;
+}
+
+/*
+  vote on one type of sensor. Each healthy instance is compared with
+  the median of the instances that have not been voted out, so a
+  second failure cannot outvote the remaining good sensor. Voting an
+  instance out needs a majority of three, and another instance that
+  agrees with the median. When two instances disagree there is no
+  majority and false is returned. A threshold of zero disables voting
+ */
+bool AP_InertialSensor::_vote(const Vector3f *values, const bool *healthy, uint8_t count,
+                              vote_state *vote, float threshold)
+{
+    if (threshold <= 0) {
+        for (uint8_t i=0; i<count; i++) {
+            vote[i].voted_out = false;
+            vote[i].error = 0;
+        }
+        return true;
+    }
+
+    float axis[3][INS_MAX_INSTANCES];
+    uint8_t n = 0;
+    for (uint8_t i=0; i<count; i++) {
+        if (healthy[i] && !vote[i].voted_out) {
+            axis[0][n] = values[i].x;
+            axis[1][n] = values[i].y;
+            axis[2][n] = values[i].z;
+            n++;
+        }
+    }
+    if (n == 0) {
+        // everything left has been voted out. A suspect sensor is
+        // better than none, so fall back to the health flags alone
+        for (uint8_t i=0; i<count; i++) {
+            vote[i].voted_out = false;
+        }
+        return true;
+    }
+    const Vector3f median(vote_median(axis[0], n),
+                          vote_median(axis[1], n),
+                          vote_median(axis[2], n));
+
+    const float error_alpha = constrain_float(_delta_time / (_delta_time + max(_vote_error_tc, 0.0f)), 0.0f, 1.0f);
+    const float bias_alpha = constrain_float(_delta_time / (_delta_time + AP_INERTIAL_SENSOR_VOTE_BIAS_TC), 0.0f, 1.0f);
+    const float bias_limit = 0.5f * threshold;
+
+    uint8_t agreeing = 0;
+    for (uint8_t i=0; i<count; i++) {
+        if (!healthy[i]) {
+            continue;
+        }
+        Vector3f residual = values[i] - median - vote[i].bias;
+        vote[i].error += (residual.length() - vote[i].error) * error_alpha;
+        if (vote[i].error <= threshold) {
+            // only learn the bias while agreeing, so a fault is not
+            // learnt as an offset
+            vote[i].bias += residual * bias_alpha;
+            float bias_length = vote[i].bias.length();
+            if (bias_length > bias_limit) {
+                vote[i].bias *= bias_limit / bias_length;
+            }
+            if (!vote[i].voted_out) {
+                agreeing++;
+            }
+        }
+    }
+
+    const uint32_t now = hal.scheduler->millis();
+    bool consistent = true;
+    for (uint8_t i=0; i<count; i++) {
+        if (!healthy[i]) {
+            continue;
+        }
+        if (vote[i].error > threshold) {
+            vote[i].agree_start_ms = 0;
+            if (n > 2 && agreeing > 0) {
+                vote[i].voted_out = true;
+            } else if (!vote[i].voted_out) {
+                consistent = false;
+            }
+        } else if (vote[i].agree_start_ms == 0) {
+            vote[i].agree_start_ms = now;
+        } else if (vote[i].voted_out &&
+                   now - vote[i].agree_start_ms > AP_INERTIAL_SENSOR_VOTE_RECOVER_MS) {
+            vote[i].voted_out = false;
+        }
+    }
+    return consistent;
+}
+#endif // INS_VOTING
+
+/*
+  return the vibration level of an accel instance in m/s/s RMS
+ */
+Vector3f AP_InertialSensor::get_vibration_levels(uint8_t instance) const
+{
+    Vector3f vibe = _accel_vibe_level[instance];
+    vibe.x = safe_sqrt(vibe.x);
+    vibe.y = safe_sqrt(vibe.y);
+    vibe.z = safe_sqrt(vibe.z);
+    return vibe;
+}
+
 /*
   wait for a sample to be available. This is the function that
   determines the timing of the main loop in ardupilot. 
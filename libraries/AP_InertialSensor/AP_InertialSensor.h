@@ -7,6 +7,14 @@
 #define AP_INERTIAL_SENSOR_ACCEL_TOT_MAX_OFFSET_CHANGE  4.0f
 #define AP_INERTIAL_SENSOR_ACCEL_MAX_OFFSET             250.0f
 
+// default clipping threshold, for 16g accelerometers
+#define AP_INERTIAL_SENSOR_ACCEL_CLIP_THRESH_MSS        (15.5f*GRAVITY_MSS)
+
+// vibration is the RMS of the accel about a 5Hz low passed floor,
+// averaged with a 2Hz low pass
+#define AP_INERTIAL_SENSOR_ACCEL_VIBE_FLOOR_FILT_HZ     5.0f
+#define AP_INERTIAL_SENSOR_ACCEL_VIBE_FILT_HZ           2.0f
+
 /**
    maximum number of INS instances available on this platform. If more
    than 1 then redundent sensors may be available
@@ -19,12 +27,41 @@
 #define INS_MAX_BACKENDS  1
 #endif
 
+/**
+   dynamic notch filtering of gyro data, tuned from an on-board FFT of
+   the primary gyro. Needs the memory and floating point speed of a
+   32 bit FPU board
+ */
+#define INS_DYNAMIC_NOTCH (HAL_CPU_CLASS >= HAL_CPU_CLASS_75)
+#define INS_NOTCH_PEAKS   2
+
+/**
+   consistency voting between redundant IMUs. Each instance is compared
+   with the per-axis median of the others after removing a slowly
+   learnt bias, and one that disagrees is not used as the primary or
+   blended until it has agreed again for
+   AP_INERTIAL_SENSOR_VOTE_RECOVER_MS. The thresholds and error time
+   constant are the INS_VOTE_* parameters
+ */
+#define INS_VOTING (INS_MAX_INSTANCES > 1)
+#define AP_INERTIAL_SENSOR_VOTE_GYRO_DEFAULT    5.0f    // deg/s
+#define AP_INERTIAL_SENSOR_VOTE_ACCEL_DEFAULT   1.5f    // m/s/s
+#define AP_INERTIAL_SENSOR_VOTE_TC_DEFAULT      0.01f   // seconds
+#define AP_INERTIAL_SENSOR_VOTE_BIAS_TC         10.0f   // seconds
+#define AP_INERTIAL_SENSOR_VOTE_RECOVER_MS      2000
+
 
 #include <stdint.h>
 #include <AP_HAL.h>
 #include <AP_Math.h>
 #include <AP_AccelCal.h>
+#include <LowPassFilter.h>
 #include "AP_InertialSensor_UserInteract.h"
+#if INS_DYNAMIC_NOTCH
+#include <BiquadFilterBank.h>
+#include "../AP_HAL/utility/RingBuffer.h"
+#include "AP_InertialSensor_FFT.h"
+#endif
 
 class AP_InertialSensor_Backend;
 
@@ -149,6 +186,17 @@ public:
     uint32_t get_gyro_error_count(uint8_t i) const { return _gyro_error_count[i]; }
     uint32_t get_accel_error_count(uint8_t i) const { return _accel_error_count[i]; }
 
+    // per-axis vibration level in m/s/s RMS, from backends that
+    // report every raw accel sample
+    Vector3f get_vibration_levels(uint8_t instance) const;
+    Vector3f get_vibration_levels(void) const { return get_vibration_levels(_primary_accel); }
+
+    // number of raw accel samples that were at the limit of the sensor range
+    uint32_t get_accel_clip_count(uint8_t instance) const { return _accel_clip_count[instance]; }
+
+    // number of raw samples a FIFO backend lost to overflow, by gyro instance
+    uint32_t get_dropped_sample_count(uint8_t instance) const { return _dropped_sample_count[instance]; }
+
     // multi-device interface
     bool get_gyro_health(uint8_t instance) const { return (instance<_gyro_count) ? _gyro_healthy[instance] : false; }
     bool get_gyro_health(void) const { return get_gyro_health(_primary_gyro); }
@@ -162,6 +210,32 @@ public:
     bool get_accel_health_all(void) const;
     uint8_t get_accel_count(void) const { return _accel_count; };
 
+#if INS_VOTING
+    // filtered disagreement of an instance with the others, in rad/s
+    // for gyros and m/s/s for accels
+    float get_gyro_vote_error(uint8_t instance) const { return _gyro_vote[instance].error; }
+    float get_accel_vote_error(uint8_t instance) const { return _accel_vote[instance].error; }
+
+    // true if an instance disagrees with the others. It stays healthy,
+    // but is not used as the primary or blended
+    bool get_gyro_voted_out(uint8_t instance) const { return _gyro_vote[instance].voted_out; }
+    bool get_accel_voted_out(uint8_t instance) const { return _accel_vote[instance].voted_out; }
+
+    // true if an instance is healthy and has not been voted out
+    bool use_gyro(uint8_t instance) const { return get_gyro_health(instance) && !_gyro_vote[instance].voted_out; }
+    bool use_accel(uint8_t instance) const { return get_accel_health(instance) && !_accel_vote[instance].voted_out; }
+
+    // false when the healthy instances disagree but there are too few
+    // of them to tell which is wrong
+    bool get_gyro_consistent(void) const { return _gyros_consistent; }
+    bool get_accel_consistent(void) const { return _accels_consistent; }
+#else
+    bool use_gyro(uint8_t instance) const { return get_gyro_health(instance); }
+    bool use_accel(uint8_t instance) const { return get_accel_health(instance); }
+    bool get_gyro_consistent(void) const { return true; }
+    bool get_accel_consistent(void) const { return true; }
+#endif
+
     // get accel offsets in m/s/s
     const Vector3f &get_accel_offsets(uint8_t i) const { return _accel_offset[i]; }
     const Vector3f &get_accel_offsets(void) const { return get_accel_offsets(_primary_accel); }
@@ -228,6 +302,14 @@ public:
 
     bool get_new_trim(float& trim_roll, float &trim_pitch);
 
+#if INS_DYNAMIC_NOTCH
+    // current dynamic notch center frequencies in Hz, zero when unused
+    float get_notch_center_hz(uint8_t i) const { return _notch_center_hz[i]; }
+
+    // gyro spectrum analyser feeding the dynamic notch
+    const AP_InertialSensor_FFT &get_gyro_fft(void) const { return _gyro_fft; }
+#endif
+
 private:
 
     // load backend drivers
@@ -258,6 +340,31 @@ private:
     // save parameters to eeprom
     void  _save_parameters();
 
+#if INS_DYNAMIC_NOTCH
+    // retune the notch filters from the gyro spectrum
+    void _update_dynamic_notch(void);
+    void _log_dynamic_notch(void);
+#endif
+
+#if INS_VOTING
+    struct vote_state {
+        Vector3f bias;              // learnt offset from the median
+        float error;                // filtered length of the bias corrected residual
+        bool voted_out;
+        uint32_t agree_start_ms;    // when it last started agreeing, zero while disagreeing
+    };
+    vote_state _gyro_vote[INS_MAX_INSTANCES];
+    vote_state _accel_vote[INS_MAX_INSTANCES];
+    bool _gyros_consistent;
+    bool _accels_consistent;
+    uint32_t _vote_log_ms;
+
+    void _update_voting(void);
+    bool _vote(const Vector3f *values, const bool *healthy, uint8_t count,
+               vote_state *vote, float threshold);
+    uint8_t _vote_mask(const vote_state *vote) const;
+#endif
+
     // backend objects
     AP_InertialSensor_Backend *_backends[INS_MAX_BACKENDS];
 
@@ -297,6 +404,47 @@ private:
     AP_Int8     _accel_filter_cutoff;
     AP_Int8     _gyro_filter_cutoff;
 
+    // raw gyro sample rate in kHz for backends that support it
+    AP_Int8     _gyro_raw_rate_khz;
+
+#if INS_VOTING
+    // voting thresholds, zero to disable, and error time constant
+    AP_Float    _vote_gyro_thresh;
+    AP_Float    _vote_accel_thresh;
+    AP_Float    _vote_error_tc;
+#endif
+
+#if INS_DYNAMIC_NOTCH
+    // dynamic notch parameters
+    AP_Int8     _notch_enable;
+    AP_Int16    _notch_min_hz;
+    AP_Int16    _notch_max_hz;
+    AP_Int16    _notch_bw_hz;
+
+    AP_InertialSensor_FFT _gyro_fft;
+
+    // notch filters, run by the backends at the raw gyro rate
+    BiquadFilterBank<3, INS_NOTCH_PEAKS> _gyro_notch[INS_MAX_INSTANCES];
+    float _gyro_raw_sample_rate[INS_MAX_INSTANCES];
+
+    // notch centers tracked by the main thread
+    float _notch_center_hz[INS_NOTCH_PEAKS];
+
+    // centers handed to the backend of each instance, which loads them
+    // into its filters between samples. The queue holds one set, so a
+    // set that does not fit is retried on the next update
+    struct notch_centers {
+        float hz[INS_NOTCH_PEAKS];
+    };
+    ObjectBuffer<notch_centers, 2> _notch_queue[INS_MAX_INSTANCES];
+    bool _notch_unsent[INS_MAX_INSTANCES];
+
+    // owned by the backend threads: the centers in use and whether the
+    // filters must be rebuilt for a new sample rate
+    float _notch_loaded_hz[INS_MAX_INSTANCES][INS_NOTCH_PEAKS];
+    bool _notch_reload[INS_MAX_INSTANCES];
+#endif
+
     // board orientation from AHRS
     enum Rotation _board_orientation;
 
@@ -341,6 +489,15 @@ private:
     uint32_t _accel_error_count[INS_MAX_INSTANCES];
     uint32_t _gyro_error_count[INS_MAX_INSTANCES];
 
+    // vibration and clipping metrics, copied from the backends in
+    // their update(). The vibration level is the mean square
+    Vector3f _accel_vibe_level[INS_MAX_INSTANCES];
+    float _accel_clip_limit[INS_MAX_INSTANCES];
+    uint32_t _accel_clip_count[INS_MAX_INSTANCES];
+
+    // raw samples lost to sensor FIFO overflow
+    uint32_t _dropped_sample_count[INS_MAX_INSTANCES];
+
     uint32_t _accel_startup_error_count[INS_MAX_INSTANCES];
     uint32_t _gyro_startup_error_count[INS_MAX_INSTANCES];
     bool _startup_error_counts_set;
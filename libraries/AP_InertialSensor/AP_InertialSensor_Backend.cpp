@@ -7,7 +7,14 @@
 AP_InertialSensor_Backend::AP_InertialSensor_Backend(AP_InertialSensor &imu) :
     _imu(imu),
     _product_id(AP_PRODUCT_ID_NONE)
-{}
+{
+    for (uint8_t i=0; i<INS_MAX_INSTANCES; i++) {
+        _vibe[i].floor_filter.set_cutoff_frequency(AP_INERTIAL_SENSOR_ACCEL_VIBE_FLOOR_FILT_HZ);
+        _vibe[i].level_filter.set_cutoff_frequency(AP_INERTIAL_SENSOR_ACCEL_VIBE_FILT_HZ);
+        _vibe[i].init = false;
+        _vibe[i].clip_count = 0;
+    }
+}
 
 void AP_InertialSensor_Backend::_rotate_and_correct_accel(uint8_t instance, Vector3f &accel) 
 {
@@ -108,6 +115,97 @@ void AP_InertialSensor_Backend::_set_gyro_error_count(uint8_t instance, uint32_t
     _imu._gyro_error_count[instance] = error_count;
 }
 
+// set the count of raw samples lost to FIFO overflow
+void AP_InertialSensor_Backend::_set_dropped_sample_count(uint8_t instance, uint32_t dropped_count)
+{
+    _imu._dropped_sample_count[instance] = dropped_count;
+}
+
+/*
+  update the vibration and clipping metrics of an accel instance from
+  one corrected body frame sample. Called at the raw sample rate, so
+  vibration above the main loop rate is included
+ */
+void AP_InertialSensor_Backend::_notify_accel_raw_sample(uint8_t instance, const Vector3f &accel, float dt)
+{
+    vibration_state &vibe = _vibe[instance];
+
+    const float limit = _imu._accel_clip_limit[instance];
+    if (fabsf(accel.x) > limit || fabsf(accel.y) > limit || fabsf(accel.z) > limit) {
+        vibe.clip_count++;
+    }
+
+    if (!vibe.init) {
+        // start the floor at the first sample to avoid a vibration
+        // spike from gravity
+        vibe.floor_filter.reset(accel);
+        vibe.init = true;
+    }
+
+    // square the difference from the floor and average it
+    Vector3f accel_floor = vibe.floor_filter.apply(accel, dt);
+    Vector3f diff = accel - accel_floor;
+    diff.x *= diff.x;
+    diff.y *= diff.y;
+    diff.z *= diff.z;
+    vibe.level_filter.apply(diff, dt);
+}
+
+// copy the vibration and clipping metrics to the frontend
+void AP_InertialSensor_Backend::_publish_vibration(uint8_t instance)
+{
+    _imu._accel_vibe_level[instance] = _vibe[instance].level_filter.get();
+    _imu._accel_clip_count[instance] = _vibe[instance].clip_count;
+}
+
+// set the raw gyro sample rate used by the dynamic notch
+void AP_InertialSensor_Backend::_set_gyro_raw_sample_rate(uint8_t instance, float rate_hz)
+{
+#if INS_DYNAMIC_NOTCH
+    _imu._gyro_raw_sample_rate[instance] = rate_hz;
+    _imu._notch_reload[instance] = true;
+#endif
+}
+
+/*
+  run the dynamic notch filters on one raw gyro sample. New center
+  frequencies queued by the main thread are loaded here, between
+  samples
+ */
+Vector3f AP_InertialSensor_Backend::_notch_filter_gyro(uint8_t instance, const Vector3f &gyro)
+{
+#if INS_DYNAMIC_NOTCH
+    if (_imu._notch_enable == 0) {
+        return gyro;
+    }
+    const float rate_hz = _imu._gyro_raw_sample_rate[instance];
+    if (rate_hz <= 0) {
+        return gyro;
+    }
+    BiquadFilterBank<3, INS_NOTCH_PEAKS> &notch = _imu._gyro_notch[instance];
+    float *loaded_hz = _imu._notch_loaded_hz[instance];
+    AP_InertialSensor::notch_centers centers;
+    if (_imu._notch_queue[instance].pop(centers)) {
+        memcpy(loaded_hz, centers.hz, sizeof(centers.hz));
+        _imu._notch_reload[instance] = true;
+    }
+    if (_imu._notch_reload[instance]) {
+        _imu._notch_reload[instance] = false;
+        for (uint8_t i=0; i<INS_NOTCH_PEAKS; i++) {
+            notch.set_notch(i, rate_hz, loaded_hz[i], _imu._notch_bw_hz);
+        }
+    }
+    if (instance == _imu._primary_gyro) {
+        _imu._gyro_fft.sample(gyro, rate_hz);
+    }
+    Vector3f ret = gyro;
+    notch.apply(&ret);
+    return ret;
+#else
+    return gyro;
+#endif
+}
+
 // return the requested sample rate in Hz
 uint16_t AP_InertialSensor_Backend::get_sample_rate_hz(void) const
 {
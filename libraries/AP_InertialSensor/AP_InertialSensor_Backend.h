@@ -82,6 +82,31 @@ protected:
     // set gyro error_count
     void _set_gyro_error_count(uint8_t instance, uint32_t error_count);
 
+    // set the count of raw samples lost to FIFO overflow
+    void _set_dropped_sample_count(uint8_t instance, uint32_t dropped_count);
+
+    // update the vibration and clipping metrics from a corrected body
+    // frame accel sample in m/s/s. Call for every raw sample
+    void _notify_accel_raw_sample(uint8_t instance, const Vector3f &accel, float dt);
+
+    // copy the vibration and clipping metrics to the frontend. Call
+    // from update(), with the timer procs suspended if the samples
+    // arrive on the timer thread
+    void _publish_vibration(uint8_t instance);
+
+    // set the accel magnitude on any axis that counts as clipping
+    void _set_accel_clip_limit(uint8_t instance, float limit_mss) {
+        _imu._accel_clip_limit[instance] = limit_mss;
+    }
+
+    // set the rate at which raw gyro samples are passed to _notch_filter_gyro()
+    void _set_gyro_raw_sample_rate(uint8_t instance, float rate_hz);
+
+    // apply the dynamic notch filters to a corrected body frame gyro
+    // sample in rad/s, and feed the spectrum analysis from the primary
+    // gyro. Call from the thread that reads the sensor at the raw rate
+    Vector3f _notch_filter_gyro(uint8_t instance, const Vector3f &gyro);
+
     // backend should fill in its product ID from AP_PRODUCT_ID_*
     int16_t _product_id;
 
@@ -94,6 +119,9 @@ protected:
     // return the requested sample rate in Hz
     uint16_t get_sample_rate_hz(void) const;
 
+    // return the requested raw gyro sample rate in kHz
+    uint8_t _gyro_raw_rate_khz(void) const { return _imu._gyro_raw_rate_khz; }
+
     // access to frontend dataflash
     DataFlash_Class *get_dataflash(void) const { 
         return _imu._log_raw_data? _imu._dataflash : NULL; 
@@ -102,6 +130,16 @@ protected:
     // note that each backend is also expected to have a static detect()
     // function which instantiates an instance of the backend sensor
     // driver if the sensor is available
+
+private:
+    // vibration and clipping metrics by frontend instance, owned by
+    // the thread that reads the raw samples
+    struct vibration_state {
+        LowPassFilterVector3f floor_filter;
+        LowPassFilterVector3f level_filter;
+        bool init;
+        uint32_t clip_count;
+    } _vibe[INS_MAX_INSTANCES];
 };
 
 #endif // __AP_INERTIALSENSOR_BACKEND_H__
@@ -0,0 +1,301 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <AP_HAL.h>
+#include "AP_InertialSensor.h"
+#include "AP_InertialSensor_FFT.h"
+
+#if INS_DYNAMIC_NOTCH
+
+#include <stdlib.h>
+
+// a peak must have this many times the median power in the search
+// band, which is a noise floor estimate that strong peaks do not raise
+#define INS_FFT_PEAK_THRESHOLD 10.0f
+
+AP_InertialSensor_FFT::AP_InertialSensor_FFT() :
+    _window_count(0),
+    _window_full(false),
+    _decimation_count(0),
+    _decimation(1),
+    _sample_rate_hz(0),
+    _analysis_rate_hz(0),
+    _re(NULL),
+    _im(NULL),
+    _hann(NULL),
+    _cos(NULL),
+    _sin(NULL),
+    _spectrum(NULL),
+    _state(FFT_COLLECTING),
+    _num_peaks(0)
+{
+    for (uint8_t i=0; i<3; i++) {
+        _window_data[i] = NULL;
+    }
+    for (uint8_t i=0; i<INS_FFT_MAX_PEAKS; i++) {
+        _peak_freq[i] = 0;
+        _peak_energy[i] = 0;
+    }
+}
+
+/*
+  allocate the window, work space and tables
+ */
+bool AP_InertialSensor_FFT::init(void)
+{
+    if (_re != NULL) {
+        return true;
+    }
+    for (uint8_t i=0; i<3; i++) {
+        _window_data[i] = (float *)calloc(INS_FFT_SIZE, sizeof(float));
+    }
+    _re       = (float *)calloc(INS_FFT_SIZE, sizeof(float));
+    _im       = (float *)calloc(INS_FFT_SIZE, sizeof(float));
+    _hann     = (float *)calloc(INS_FFT_SIZE, sizeof(float));
+    _cos      = (float *)calloc(INS_FFT_SIZE/2, sizeof(float));
+    _sin      = (float *)calloc(INS_FFT_SIZE/2, sizeof(float));
+    _spectrum = (float *)calloc(INS_FFT_SIZE/2, sizeof(float));
+
+    if (_window_data[0] == NULL || _window_data[1] == NULL || _window_data[2] == NULL ||
+        _re == NULL || _im == NULL || _hann == NULL ||
+        _cos == NULL || _sin == NULL || _spectrum == NULL) {
+        for (uint8_t i=0; i<3; i++) {
+            free(_window_data[i]);
+            _window_data[i] = NULL;
+        }
+        free(_re);
+        free(_im);
+        free(_hann);
+        free(_cos);
+        free(_sin);
+        free(_spectrum);
+        _re = _im = _hann = _cos = _sin = _spectrum = NULL;
+        return false;
+    }
+
+    for (uint16_t i=0; i<INS_FFT_SIZE; i++) {
+        _hann[i] = 0.5f * (1.0f - cosf(2 * PI * i / (INS_FFT_SIZE - 1)));
+    }
+    for (uint16_t i=0; i<INS_FFT_SIZE/2; i++) {
+        _cos[i] = cosf(2 * PI * i / INS_FFT_SIZE);
+        _sin[i] = -sinf(2 * PI * i / INS_FFT_SIZE);
+    }
+    return true;
+}
+
+/*
+  add a sample to the window. Samples above INS_FFT_MAX_RATE_HZ are
+  averaged in groups so that the analysis covers the frequencies that
+  matter for the rate controllers with the same number of bins. Samples
+  arriving while the main thread owns the window are dropped
+ */
+void AP_InertialSensor_FFT::sample(const Vector3f &gyro, float sample_rate_hz)
+{
+    if (_re == NULL || _window_full || sample_rate_hz <= 0) {
+        return;
+    }
+
+    if (!is_equal(sample_rate_hz, _sample_rate_hz)) {
+        // rate change, start a new window
+        _sample_rate_hz = sample_rate_hz;
+        _decimation = 1;
+        while (_sample_rate_hz / _decimation > INS_FFT_MAX_RATE_HZ) {
+            _decimation++;
+        }
+        _analysis_rate_hz = _sample_rate_hz / _decimation;
+        _decimation_sum.zero();
+        _decimation_count = 0;
+        _window_count = 0;
+    }
+
+    _decimation_sum += gyro;
+    if (++_decimation_count < _decimation) {
+        return;
+    }
+    Vector3f avg = _decimation_sum / _decimation;
+    _decimation_sum.zero();
+    _decimation_count = 0;
+
+    _window_data[0][_window_count] = avg.x;
+    _window_data[1][_window_count] = avg.y;
+    _window_data[2][_window_count] = avg.z;
+    if (++_window_count >= INS_FFT_SIZE) {
+        _window_count = 0;
+        _window_full = true;
+    }
+}
+
+/*
+  run one step of the analysis. The three axes are transformed on
+  successive calls and the peak search runs on the call after that,
+  then the window is handed back to the sensor thread
+ */
+bool AP_InertialSensor_FFT::update(float min_hz, float max_hz)
+{
+    if (_re == NULL) {
+        return false;
+    }
+
+    switch (_state) {
+    case FFT_COLLECTING:
+        if (_window_full) {
+            memset(_spectrum, 0, sizeof(float) * INS_FFT_SIZE/2);
+            _state = FFT_AXIS_X;
+        }
+        return false;
+
+    case FFT_AXIS_X:
+    case FFT_AXIS_Y:
+    case FFT_AXIS_Z:
+        _transform(_window_data[_state - FFT_AXIS_X]);
+        _state = (enum fft_state)(_state + 1);
+        return false;
+
+    case FFT_PEAKS:
+        _find_peaks(min_hz, max_hz);
+        _state = FFT_COLLECTING;
+        _window_full = false;
+        return true;
+    }
+    return false;
+}
+
+/*
+  windowed in-place radix-2 FFT of one axis, adding its power
+  spectrum into _spectrum
+ */
+void AP_InertialSensor_FFT::_transform(const float *input)
+{
+    // remove the mean so the DC bin does not leak into low bins
+    float mean = 0;
+    for (uint16_t i=0; i<INS_FFT_SIZE; i++) {
+        mean += input[i];
+    }
+    mean /= INS_FFT_SIZE;
+
+    // load in bit reversed order
+    for (uint16_t i=0; i<INS_FFT_SIZE; i++) {
+        uint16_t r = 0;
+        for (uint8_t b=0; b<INS_FFT_SIZE_LOG2; b++) {
+            r |= ((i >> b) & 1) << (INS_FFT_SIZE_LOG2 - 1 - b);
+        }
+        _re[r] = (input[i] - mean) * _hann[i];
+        _im[r] = 0;
+    }
+
+    for (uint16_t len=2; len<=INS_FFT_SIZE; len <<= 1) {
+        uint16_t half = len >> 1;
+        uint16_t step = INS_FFT_SIZE / len;
+        for (uint16_t i=0; i<INS_FFT_SIZE; i += len) {
+            for (uint16_t j=0; j<half; j++) {
+                float wr = _cos[j*step];
+                float wi = _sin[j*step];
+                uint16_t a = i + j;
+                uint16_t b = a + half;
+                float tr = _re[b] * wr - _im[b] * wi;
+                float ti = _re[b] * wi + _im[b] * wr;
+                _re[b] = _re[a] - tr;
+                _im[b] = _im[a] - ti;
+                _re[a] += tr;
+                _im[a] += ti;
+            }
+        }
+    }
+
+    for (uint16_t i=0; i<INS_FFT_SIZE/2; i++) {
+        _spectrum[i] += _re[i] * _re[i] + _im[i] * _im[i];
+    }
+}
+
+/*
+  find the strongest local maxima of the spectrum within the search
+  band, refining each with a parabolic fit over its neighbours
+ */
+void AP_InertialSensor_FFT::_find_peaks(float min_hz, float max_hz)
+{
+    const float bin_width = get_bin_width();
+    uint16_t start_bin = constrain_int16(min_hz / bin_width, 1, INS_FFT_SIZE/2 - 2);
+    uint16_t end_bin = constrain_int16(max_hz / bin_width + 1, start_bin + 1, INS_FFT_SIZE/2 - 2);
+
+    // insertion sort a copy of the band to find its median
+    float sorted[INS_FFT_SIZE/2];
+    uint16_t n = 0;
+    for (uint16_t i=start_bin; i<=end_bin; i++) {
+        float p = _spectrum[i];
+        uint16_t j = n++;
+        while (j > 0 && sorted[j-1] > p) {
+            sorted[j] = sorted[j-1];
+            j--;
+        }
+        sorted[j] = p;
+    }
+    const float threshold = INS_FFT_PEAK_THRESHOLD * sorted[n/2];
+
+    uint16_t peak_bin[INS_FFT_MAX_PEAKS];
+    uint8_t num_peaks = 0;
+    for (uint16_t i=start_bin; i<=end_bin; i++) {
+        float p = _spectrum[i];
+        if (p <= threshold ||
+            p <= _spectrum[i-1] || p < _spectrum[i+1]) {
+            continue;
+        }
+        // insert into the list, strongest first
+        uint8_t pos = num_peaks;
+        while (pos > 0 && _spectrum[peak_bin[pos-1]] < p) {
+            if (pos < INS_FFT_MAX_PEAKS) {
+                peak_bin[pos] = peak_bin[pos-1];
+            }
+            pos--;
+        }
+        if (pos < INS_FFT_MAX_PEAKS) {
+            peak_bin[pos] = i;
+            if (num_peaks < INS_FFT_MAX_PEAKS) {
+                num_peaks++;
+            }
+        }
+    }
+
+    for (uint8_t i=0; i<num_peaks; i++) {
+        uint16_t b = peak_bin[i];
+        float y0 = _spectrum[b-1];
+        float y1 = _spectrum[b];
+        float y2 = _spectrum[b+1];
+        float denom = y0 - 2*y1 + y2;
+        float delta = 0;
+        if (!is_zero(denom)) {
+            delta = constrain_float(0.5f * (y0 - y2) / denom, -0.5f, 0.5f);
+        }
+        _peak_freq[i] = (b + delta) * bin_width;
+        _peak_energy[i] = y1;
+    }
+
+    // report in increasing frequency so each notch follows one peak
+    if (num_peaks == 2 && _peak_freq[0] > _peak_freq[1]) {
+        float f = _peak_freq[0];
+        float e = _peak_energy[0];
+        _peak_freq[0] = _peak_freq[1];
+        _peak_energy[0] = _peak_energy[1];
+        _peak_freq[1] = f;
+        _peak_energy[1] = e;
+    }
+    for (uint8_t i=num_peaks; i<INS_FFT_MAX_PEAKS; i++) {
+        _peak_freq[i] = 0;
+        _peak_energy[i] = 0;
+    }
+    _num_peaks = num_peaks;
+}
+
+#endif // INS_DYNAMIC_NOTCH
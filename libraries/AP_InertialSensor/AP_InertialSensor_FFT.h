@@ -0,0 +1,105 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  Streaming spectral analysis of gyro data, used to find the dominant
+  vibration frequencies for the dynamic notch filters.
+
+  Samples are collected from the sensor thread into a window. Once the
+  window is full the main thread runs one FFT per call to update(), so
+  the cost is spread over several loops, and then searches the summed
+  power spectrum of the three axes for peaks.
+ */
+#ifndef __AP_INERTIALSENSOR_FFT_H__
+#define __AP_INERTIALSENSOR_FFT_H__
+
+#include <AP_Math.h>
+
+// window length, giving a resolution of about 8Hz at a 1kHz sample rate
+#define INS_FFT_SIZE        128
+#define INS_FFT_SIZE_LOG2   7
+
+// samples above this rate are averaged down before analysis
+#define INS_FFT_MAX_RATE_HZ 1100
+
+// number of vibration peaks tracked
+#define INS_FFT_MAX_PEAKS   2
+
+class AP_InertialSensor_FFT
+{
+public:
+    AP_InertialSensor_FFT();
+
+    // allocate the buffers. Returns false if there is not enough memory
+    bool init(void);
+
+    // add a body frame gyro sample in rad/s. Called from the thread
+    // that reads the sensor
+    void sample(const Vector3f &gyro, float sample_rate_hz);
+
+    // process a full window if one is ready, looking for peaks between
+    // min_hz and max_hz. Returns true when new peaks are available
+    bool update(float min_hz, float max_hz);
+
+    // results of the last analysis, peaks in increasing frequency
+    uint8_t get_num_peaks(void) const { return _num_peaks; }
+    float get_peak_freq(uint8_t i) const { return _peak_freq[i]; }
+    float get_peak_energy(uint8_t i) const { return _peak_energy[i]; }
+
+    // power spectrum of the last analysis, INS_FFT_SIZE/2 bins
+    const float *get_spectrum(void) const { return _spectrum; }
+    float get_bin_width(void) const { return _analysis_rate_hz / INS_FFT_SIZE; }
+
+private:
+    enum fft_state {
+        FFT_COLLECTING = 0,
+        FFT_AXIS_X,
+        FFT_AXIS_Y,
+        FFT_AXIS_Z,
+        FFT_PEAKS
+    };
+
+    void _transform(const float *input);
+    void _find_peaks(float min_hz, float max_hz);
+
+    // sample window, written by the sensor thread while collecting
+    float *_window_data[3];
+    uint16_t _window_count;
+    volatile bool _window_full;
+
+    // averaging of samples above INS_FFT_MAX_RATE_HZ
+    Vector3f _decimation_sum;
+    uint8_t _decimation_count;
+    uint8_t _decimation;
+    float _sample_rate_hz;
+    float _analysis_rate_hz;
+
+    // work space and tables
+    float *_re;
+    float *_im;
+    float *_hann;
+    float *_cos;
+    float *_sin;
+    float *_spectrum;
+
+    enum fft_state _state;
+
+    uint8_t _num_peaks;
+    float _peak_freq[INS_FFT_MAX_PEAKS];
+    float _peak_energy[INS_FFT_MAX_PEAKS];
+};
+
+#endif // __AP_INERTIALSENSOR_FFT_H__
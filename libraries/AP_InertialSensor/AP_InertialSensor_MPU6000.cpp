@@ -61,6 +61,12 @@ extern const AP_HAL::HAL& hal;
 #define MPUREG_ZRMOT_THR                                0x21    // detection threshold for Zero Motion interrupt generation.
 #define MPUREG_ZRMOT_DUR                                0x22    // duration counter threshold for Zero Motion interrupt generation. The duration counter ticks at 16 Hz, therefore ZRMOT_DUR has a unit of 1 LSB = 64 ms.
 #define MPUREG_FIFO_EN                                  0x23
+// bit definitions for MPUREG_FIFO_EN
+#       define BIT_TEMP_FIFO_EN                                 0x80
+#       define BIT_XG_FIFO_EN                                   0x40
+#       define BIT_YG_FIFO_EN                                   0x20
+#       define BIT_ZG_FIFO_EN                                   0x10
+#       define BIT_ACCEL_FIFO_EN                                0x08
 #define MPUREG_INT_PIN_CFG                              0x37
 #       define BIT_INT_RD_CLEAR                                 0x10    // clear the interrupt when any read occurs
 #       define BIT_LATCH_INT_EN                                 0x20    // latch data ready pin 
@@ -158,6 +164,17 @@ extern const AP_HAL::HAL& hal;
 #define MPU6000_REV_D8                          0x58    // 0101			1000
 #define MPU6000_REV_D9                          0x59    // 0101			1001
 
+// sensor output data rate when fast sampling
+#define MPU6000_SAMPLE_PERIOD_US                1000
+#define MPU6000_SAMPLE_DT                       1.0e-3f
+
+// accel, temperature and gyro, in the same order as the data registers
+#define MPU6000_SAMPLE_SIZE                     14
+
+// FIFO size in bytes, and the most samples read in one SPI burst. Any
+// samples beyond the burst are left for the next timer tick
+#define MPU6000_FIFO_SIZE                       1024
+#define MPU6000_FIFO_BURST                      (MPU6000_FIFO_BURST_BYTES / MPU6000_SAMPLE_SIZE)
 
 /*
  *  RM-MPU-6000A-00.pdf, page 33, section 4.25 lists LSB sensitivity of
@@ -184,12 +201,19 @@ AP_InertialSensor_MPU6000::AP_InertialSensor_MPU6000(AP_InertialSensor &imu) :
 #if MPU6000_FAST_SAMPLING
     _accel_filter(1000, 15),
     _gyro_filter(1000, 15),
+    _accel_sum(),
+    _gyro_sum(),
 #else
     _sample_count(0),
     _accel_sum(),
     _gyro_sum(),
 #endif
     _sum_count(0)
+#if MPU6000_FIFO
+    ,_fifo_overflow_count(0),
+    _dropped_sample_count(0),
+    _last_sample_us(0)
+#endif
 {
 }
 
@@ -250,6 +274,12 @@ bool AP_InertialSensor_MPU6000::_init_sensor(void)
     // grab the used instances
     _gyro_instance = _imu.register_gyro();
     _accel_instance = _imu.register_accel();
+#if MPU6000_FAST_SAMPLING
+    _set_gyro_raw_sample_rate(_gyro_instance, 1.0f / MPU6000_SAMPLE_DT);
+#endif
+
+    // the accel is set to 8g full scale
+    _set_accel_clip_limit(_accel_instance, 7.75f*GRAVITY_MSS);
 
     hal.scheduler->resume_timer_procs();
     
@@ -285,6 +315,11 @@ bool AP_InertialSensor_MPU6000::update( void )
     gyro = _gyro_filtered;
     accel = _accel_filtered;
     num_samples = 1;
+    Vector3f gyro_sum = _gyro_sum;
+    Vector3f accel_sum = _accel_sum;
+    uint16_t sum_count = _sum_count;
+    _accel_sum.zero();
+    _gyro_sum.zero();
 #else
     gyro(_gyro_sum.x, _gyro_sum.y, _gyro_sum.z);
     accel(_accel_sum.x, _accel_sum.y, _accel_sum.z);
@@ -293,20 +328,50 @@ bool AP_InertialSensor_MPU6000::update( void )
     _gyro_sum.zero();
 #endif
     _sum_count = 0;
+#if MPU6000_FAST_SAMPLING
+    _publish_vibration(_accel_instance);
+#endif
     hal.scheduler->resume_timer_procs();
 
-    gyro *= _gyro_scale / num_samples;
     accel *= MPU6000_ACCEL_SCALE_1G / num_samples;
-
 #if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_PXF
     accel.rotate(ROTATION_PITCH_180_YAW_90);
-    gyro.rotate(ROTATION_PITCH_180_YAW_90);
 #endif
-
     _publish_accel(_accel_instance, accel);
+
+#if MPU6000_FAST_SAMPLING
+    // already scaled, rotated and corrected ahead of the notch
+    _publish_gyro(_gyro_instance, gyro, false);
+#else
+    gyro *= _gyro_scale / num_samples;
+#if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_PXF
+    gyro.rotate(ROTATION_PITCH_180_YAW_90);
+#endif
     _publish_gyro(_gyro_instance, gyro);
+#endif
 
 #if MPU6000_FAST_SAMPLING
+    if (sum_count > 0) {
+        // integrate using the mean of the unfiltered samples over the
+        // time covered by the sensor output data rate
+        float dt = sum_count * MPU6000_SAMPLE_DT;
+
+        gyro_sum *= _gyro_scale / sum_count;
+        accel_sum *= MPU6000_ACCEL_SCALE_1G / sum_count;
+#if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_PXF
+        accel_sum.rotate(ROTATION_PITCH_180_YAW_90);
+        gyro_sum.rotate(ROTATION_PITCH_180_YAW_90);
+#endif
+        _rotate_and_correct_gyro(_gyro_instance, gyro_sum);
+        _rotate_and_correct_accel(_accel_instance, accel_sum);
+        _publish_delta_angle(_gyro_instance, gyro_sum * dt);
+        _publish_delta_velocity(_accel_instance, accel_sum * dt, dt);
+    }
+
+#if MPU6000_FIFO
+    _set_dropped_sample_count(_gyro_instance, _dropped_sample_count);
+#endif
+
     if (_last_accel_filter_hz != _accel_filter_cutoff()) {
         _accel_filter.set_cutoff_frequency(1000, _accel_filter_cutoff());
         _last_accel_filter_hz = _accel_filter_cutoff();
@@ -354,11 +419,17 @@ bool AP_InertialSensor_MPU6000::_data_ready()
 void AP_InertialSensor_MPU6000::_poll_data(void)
 {
     if (!_spi_sem->take_nonblocking()) {
+        // with the FIFO enabled the samples wait in the sensor until
+        // the next tick
         return;
     }   
+#if MPU6000_FIFO
+    _read_fifo();
+#else
     if (_data_ready()) {
         _read_data_transaction(); 
     }
+#endif
     _spi_sem->give();
 }
 
@@ -389,34 +460,149 @@ void AP_InertialSensor_MPU6000::_read_data_transaction() {
         }
     }
 
+    _accumulate(rx.v);
+}
+
 #define int16_val(v, idx) ((int16_t)(((uint16_t)v[2*idx] << 8) | v[2*idx+1]))
+
+/*
+  filter or sum one sample in data register layout
+ */
+void AP_InertialSensor_MPU6000::_accumulate(const uint8_t *data)
+{
 #if MPU6000_FAST_SAMPLING
-    _accel_filtered = _accel_filter.apply(Vector3f(int16_val(rx.v, 1),
-                                                   int16_val(rx.v, 0),
-                                                   -int16_val(rx.v, 2)));
+    Vector3f accel(int16_val(data, 1),
+                   int16_val(data, 0),
+                   -int16_val(data, 2));
+    Vector3f gyro(int16_val(data, 5),
+                  int16_val(data, 4),
+                  -int16_val(data, 6));
+
+    _accel_filtered = _accel_filter.apply(accel);
+
+    _accel_sum += accel;
+    _gyro_sum += gyro;
+
+    // the notch runs at the raw rate ahead of the low pass filter, on
+    // a body frame gyro in rad/s like the other backends
+    gyro *= _gyro_scale;
+#if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_PXF
+    gyro.rotate(ROTATION_PITCH_180_YAW_90);
+#endif
+    _rotate_and_correct_gyro(_gyro_instance, gyro);
+    _gyro_filtered = _gyro_filter.apply(_notch_filter_gyro(_gyro_instance, gyro));
 
-    _gyro_filtered = _gyro_filter.apply(Vector3f(int16_val(rx.v, 5),
-                                                 int16_val(rx.v, 4),
-                                                 -int16_val(rx.v, 6)));
+    // vibration and clipping are measured in the body frame
+    accel *= MPU6000_ACCEL_SCALE_1G;
+#if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_PXF
+    accel.rotate(ROTATION_PITCH_180_YAW_90);
+#endif
+    _rotate_and_correct_accel(_accel_instance, accel);
+    _notify_accel_raw_sample(_accel_instance, accel, MPU6000_SAMPLE_DT);
 #else
-    _accel_sum.x += int16_val(rx.v, 1);
-    _accel_sum.y += int16_val(rx.v, 0);
-    _accel_sum.z -= int16_val(rx.v, 2);
-    _gyro_sum.x  += int16_val(rx.v, 5);
-    _gyro_sum.y  += int16_val(rx.v, 4);
-    _gyro_sum.z  -= int16_val(rx.v, 6);
+    _accel_sum.x += int16_val(data, 1);
+    _accel_sum.y += int16_val(data, 0);
+    _accel_sum.z -= int16_val(data, 2);
+    _gyro_sum.x  += int16_val(data, 5);
+    _gyro_sum.y  += int16_val(data, 4);
+    _gyro_sum.z  -= int16_val(data, 6);
 #endif
     _sum_count++;
 
-#if !MPU6000_FAST_SAMPLING
     if (_sum_count == 0) {
         // rollover - v unlikely
         _accel_sum.zero();
         _gyro_sum.zero();
     }
-#endif
 }
 
+#if MPU6000_FIFO
+/*
+  read the number of bytes waiting in the FIFO
+ */
+uint16_t AP_InertialSensor_MPU6000::_fifo_count()
+{
+    uint8_t tx[3] = { MPUREG_FIFO_COUNTH | 0x80, 0, 0 };
+    uint8_t rx[3];
+
+    _spi->transaction(tx, rx, 3);
+    return ((uint16_t)rx[1] << 8) | rx[2];
+}
+
+/*
+  discard the FIFO contents and restart sampling into it, keeping the
+  other USER_CTRL bits
+ */
+void AP_InertialSensor_MPU6000::_fifo_reset()
+{
+    uint8_t user_ctrl = _register_read(MPUREG_USER_CTRL) & ~BIT_USER_CTRL_FIFO_EN;
+
+    _register_write(MPUREG_FIFO_EN, 0);
+    _register_write(MPUREG_USER_CTRL, user_ctrl | BIT_USER_CTRL_FIFO_RESET);
+    _register_write(MPUREG_USER_CTRL, user_ctrl | BIT_USER_CTRL_FIFO_EN);
+    _register_write(MPUREG_FIFO_EN, BIT_TEMP_FIFO_EN | BIT_XG_FIFO_EN | BIT_YG_FIFO_EN |
+                    BIT_ZG_FIFO_EN | BIT_ACCEL_FIFO_EN);
+}
+
+/*
+  drain the samples queued in the FIFO in a single SPI burst, feeding
+  each one through the filters and into the sums
+ */
+void AP_InertialSensor_MPU6000::_read_fifo()
+{
+    uint32_t now = hal.scheduler->micros();
+    uint8_t status = _register_read(MPUREG_INT_STATUS);
+    uint16_t bytes = _fifo_count();
+    uint16_t queued = bytes / MPU6000_SAMPLE_SIZE;
+
+    if ((status & BIT_FIFO_OFLOW_INT) ||
+        bytes > MPU6000_FIFO_SIZE ||
+        bytes % MPU6000_SAMPLE_SIZE != 0 ||
+        (queued == 0 && now - _last_sample_us > 10*MPU6000_SAMPLE_PERIOD_US)) {
+        /*
+          samples have been lost, the FIFO is no longer aligned to a
+          sample boundary (possibly a bad bus transaction) or it has
+          stopped filling. Start again and count the samples we
+          expected since the last good one as dropped
+         */
+        uint32_t expected = (now - _last_sample_us) / MPU6000_SAMPLE_PERIOD_US;
+        _fifo_overflow_count++;
+        _dropped_sample_count += expected > 0 ? expected : 1;
+        if (bytes > MPU6000_FIFO_SIZE && ++_error_count > 4) {
+            _spi->set_bus_speed(AP_HAL::SPIDeviceDriver::SPI_SPEED_LOW);
+        }
+        _fifo_reset();
+        _last_sample_us = now;
+        return;
+    }
+
+    if (queued == 0) {
+        return;
+    }
+
+    /*
+      the newest sample in the FIFO was taken at about the current
+      time, with the older ones spaced by the output data rate
+     */
+    _last_sample_us = now;
+    uint8_t n = queued;
+    if (queued > MPU6000_FIFO_BURST) {
+        n = MPU6000_FIFO_BURST;
+        _last_sample_us -= (queued - n) * MPU6000_SAMPLE_PERIOD_US;
+    }
+
+    uint16_t len = 1 + n*MPU6000_SAMPLE_SIZE;
+
+    memset(_fifo_tx, 0, len);
+    _fifo_tx[0] = MPUREG_FIFO_R_W | 0x80;
+    _spi->transaction(_fifo_tx, _fifo_rx, len);
+
+    for (uint8_t i=0; i<n; i++) {
+        _accumulate(&_fifo_rx[1 + i*MPU6000_SAMPLE_SIZE]);
+    }
+}
+#endif // MPU6000_FIFO
+
 uint8_t AP_InertialSensor_MPU6000::_register_read( uint8_t reg )
 {
     uint8_t addr = reg | 0x80; // Set most significant bit
@@ -549,7 +735,15 @@ bool AP_InertialSensor_MPU6000::_hardware_init(void)
     }
 #endif
 
-#if MPU6000_FAST_SAMPLING
+#if MPU6000_FIFO
+    // 188Hz sensor filter. With the filter disabled the gyro output
+    // rate is 8kHz, which would fill the FIFO eight times faster than
+    // the 1kHz sample rate we integrate at
+    _register_write(MPUREG_CONFIG, BITS_DLPF_CFG_188HZ);
+
+    // set sample rate to 1000Hz and apply a software filter
+    _register_write(MPUREG_SMPLRT_DIV, MPUREG_SMPLRT_1000HZ);
+#elif MPU6000_FAST_SAMPLING
     // disable sensor filtering 
     _set_filter_register(256);
 
@@ -592,6 +786,12 @@ bool AP_InertialSensor_MPU6000::_hardware_init(void)
     // until we clear the interrupt
     _register_write(MPUREG_INT_PIN_CFG, BIT_INT_RD_CLEAR | BIT_LATCH_INT_EN);
 
+#if MPU6000_FIFO
+    // queue accel, temperature and gyro samples at the output data rate
+    _fifo_reset();
+    _last_sample_us = hal.scheduler->micros();
+#endif
+
     // now that we have initialised, we set the SPI bus speed to high
     // (8MHz on APM2)
     _spi->set_bus_speed(AP_HAL::SPIDeviceDriver::SPI_SPEED_HIGH);
@@ -13,11 +13,28 @@
 #define MPU6000_DEBUG 0
 
 // on fast CPUs we sample at 1kHz and use a software filter
+#ifndef MPU6000_FAST_SAMPLING
 #if HAL_CPU_CLASS >= HAL_CPU_CLASS_75
 #define MPU6000_FAST_SAMPLING 1
 #else
 #define MPU6000_FAST_SAMPLING 0
 #endif
+#endif
+
+// read the samples through the sensor FIFO, so that every sample is
+// used even when a timer tick is late or the SPI bus is busy. This is
+// on for every board that samples at 1kHz. 16 bit boards take 200Hz
+// averages from the sensor's own filter, and have no RAM for the burst
+// buffers
+#ifndef MPU6000_FIFO
+#define MPU6000_FIFO MPU6000_FAST_SAMPLING
+#endif
+#if MPU6000_FIFO && !MPU6000_FAST_SAMPLING
+#error "MPU6000_FIFO needs MPU6000_FAST_SAMPLING"
+#endif
+
+// most FIFO bytes read in one SPI burst, a whole number of samples
+#define MPU6000_FIFO_BURST_BYTES (32*14)
 
 #if MPU6000_FAST_SAMPLING
 #include <Filter.h>
@@ -38,6 +55,14 @@ public:
     // detect the sensor
     static AP_InertialSensor_Backend *detect(AP_InertialSensor &imu);
 
+#if MPU6000_FIFO
+    // number of times the FIFO overflowed or lost alignment and was reset
+    uint32_t fifo_overflow_count(void) const { return _fifo_overflow_count; }
+
+    // number of sensor samples lost because of FIFO resets
+    uint32_t dropped_sample_count(void) const { return _dropped_sample_count; }
+#endif
+
 private:
 #if MPU6000_DEBUG
     void _dump_registers(void);
@@ -52,6 +77,12 @@ private:
     bool                 _init_sensor(void);
     bool                 _sample_available();
     void                 _read_data_transaction();
+    void                 _accumulate(const uint8_t *data);
+#if MPU6000_FIFO
+    void                 _read_fifo();
+    uint16_t             _fifo_count();
+    void                 _fifo_reset();
+#endif
     bool                 _data_ready();
     void                 _poll_data(void);
     uint8_t              _register_read( uint8_t reg );
@@ -83,6 +114,11 @@ private:
     // Low Pass filters for gyro and accel 
     LowPassFilter2pVector3f _accel_filter;
     LowPassFilter2pVector3f _gyro_filter;
+
+    // sums of the unfiltered samples since the last update(), used
+    // for delta angle and delta velocity
+    Vector3f _accel_sum;
+    Vector3f _gyro_sum;
 #else
     // accumulation in timer - must be read with timer disabled
     // the sum of the values since last read
@@ -90,6 +126,19 @@ private:
     Vector3l _gyro_sum;
 #endif
     volatile uint16_t _sum_count;
+
+#if MPU6000_FIFO
+    uint32_t _fifo_overflow_count;
+    uint32_t _dropped_sample_count;
+
+    // time of the most recent sample taken from the FIFO, derived
+    // from the sensor output data rate
+    uint32_t _last_sample_us;
+
+    // SPI burst buffers, kept off the timer thread's stack
+    uint8_t _fifo_tx[1 + MPU6000_FIFO_BURST_BYTES];
+    uint8_t _fifo_rx[1 + MPU6000_FIFO_BURST_BYTES];
+#endif
 };
 
 #endif // __AP_INERTIAL_SENSOR_MPU6000_H__
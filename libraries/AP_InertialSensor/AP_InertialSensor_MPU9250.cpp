@@ -75,6 +75,12 @@ extern const AP_HAL::HAL& hal;
 #define MPUREG_ZRMOT_THR                                0x21    // detection threshold for Zero Motion interrupt generation.
 #define MPUREG_ZRMOT_DUR                                0x22    // duration counter threshold for Zero Motion interrupt generation. The duration counter ticks at 16 Hz, therefore ZRMOT_DUR has a unit of 1 LSB = 64 ms.
 #define MPUREG_FIFO_EN                                  0x23
+// bit definitions for MPUREG_FIFO_EN
+#       define BIT_TEMP_FIFO_EN                                 0x80
+#       define BIT_XG_FIFO_EN                                   0x40
+#       define BIT_YG_FIFO_EN                                   0x20
+#       define BIT_ZG_FIFO_EN                                   0x10
+#       define BIT_ACCEL_FIFO_EN                                0x08
 #define MPUREG_INT_PIN_CFG                              0x37
 #       define BIT_INT_RD_CLEAR                                 0x10    // clear the interrupt when any read occurs
 #       define BIT_LATCH_INT_EN                                 0x20    // latch data ready pin
@@ -159,6 +165,24 @@ extern const AP_HAL::HAL& hal;
 #define BITS_DLPF_CFG_2100HZ_NOLPF              0x07
 #define BITS_DLPF_CFG_MASK                              0x07
 
+// accel output data rate, which is also the gyro rate unless fast
+// sampling is enabled with INS_GYRO_RATE
+#define MPU9250_BASE_RATE_HZ                    1000
+#define MPU9250_FAST_RATE_HZ                    8000
+
+// accel, temperature and gyro, in the same order as the data registers
+#define MPU9250_SAMPLE_SIZE                     14
+
+// gyro only, used when fast sampling
+#define MPU9250_GYRO_SAMPLE_SIZE                6
+
+// reset the FIFO if nothing has arrived for this long
+#define MPU9250_FIFO_STALL_US                   10000
+
+// FIFO size in bytes. Samples beyond MPU9250_FIFO_BURST_BYTES are left
+// for the next timer tick
+#define MPU9250_FIFO_SIZE                       512
+
 /*
  *  PS-MPU-9250A-00.pdf, page 8, lists LSB sensitivity of
  *  gyro as 16.4 LSB/DPS at scale factor of +/- 2000dps (FS_SEL==3)
@@ -177,10 +201,18 @@ AP_InertialSensor_MPU9250::AP_InertialSensor_MPU9250(AP_InertialSensor &imu) :
 	AP_InertialSensor_Backend(imu),
     _last_accel_filter_hz(-1),
     _last_gyro_filter_hz(-1),
-    _shared_data_idx(0),
     _accel_filter(1000, 15),
     _gyro_filter(1000, 15),
-    _have_sample_available(false)
+    _have_sample_available(false),
+    _delta_velocity_dt(0.0f),
+    _gyro_rate_hz(MPU9250_BASE_RATE_HZ)
+#if MPU9250_FIFO
+    ,_fifo_sample_size(MPU9250_SAMPLE_SIZE),
+    _last_accel_us(0),
+    _fifo_overflow_count(0),
+    _dropped_sample_count(0),
+    _last_sample_us(0)
+#endif
 {
 }
 
@@ -245,6 +277,7 @@ bool AP_InertialSensor_MPU9250::_init_sensor(void)
 
     _gyro_instance = _imu.register_gyro();
     _accel_instance = _imu.register_accel();
+    _set_gyro_raw_sample_rate(_gyro_instance, _gyro_rate_hz);
 
     _product_id = AP_PRODUCT_ID_MPU9250;
 
@@ -262,36 +295,36 @@ bool AP_InertialSensor_MPU9250::_init_sensor(void)
  */
 bool AP_InertialSensor_MPU9250::update( void )
 {
-    // pull the data from the timer shared data buffer
-    uint8_t idx = _shared_data_idx;
-    Vector3f gyro = _shared_data[idx]._gyro_filtered;
-    Vector3f accel = _shared_data[idx]._accel_filtered;
-
+    // take the latest filtered sample, and the delta angle and delta
+    // velocity integrated since the last update
+    hal.scheduler->suspend_timer_procs();
+    Vector3f gyro = _gyro_filtered;
+    Vector3f accel = _accel_filtered;
+    Vector3f delta_angle = _delta_angle_accumulator;
+    Vector3f delta_velocity = _delta_velocity_accumulator;
+    float delta_velocity_dt = _delta_velocity_dt;
+    _delta_angle_accumulator.zero();
+    _delta_velocity_accumulator.zero();
+    _delta_velocity_dt = 0.0f;
     _have_sample_available = false;
+    _publish_vibration(_accel_instance);
+    hal.scheduler->resume_timer_procs();
 
     accel *= MPU9250_ACCEL_SCALE_1G;
-    gyro *= GYRO_SCALE;
+    _rotate_sensor(accel);
 
-    // rotate for bbone default
-    accel.rotate(ROTATION_ROLL_180_YAW_90);
-    gyro.rotate(ROTATION_ROLL_180_YAW_90);
+    // the gyro was corrected before filtering
+    _publish_gyro(_gyro_instance, gyro, false);
+    _publish_accel(_accel_instance, accel);
 
-#if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_PXF
-    // PXF has an additional YAW 180
-    accel.rotate(ROTATION_YAW_180);
-    gyro.rotate(ROTATION_YAW_180);
-#elif CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_NAVIO
-    // NavIO has different orientation, assuming RaspberryPi is right
-    // way up, and PWM pins on NavIO are at the back of the aircraft
-    accel.rotate(ROTATION_ROLL_180_YAW_90);
-    gyro.rotate(ROTATION_ROLL_180_YAW_90);
-#elif CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_BBBMINI
-    accel.rotate(ROTATION_ROLL_180);
-    gyro.rotate(ROTATION_ROLL_180);
-#endif
+    if (delta_velocity_dt > 0.0f) {
+        _publish_delta_angle(_gyro_instance, delta_angle);
+        _publish_delta_velocity(_accel_instance, delta_velocity, delta_velocity_dt);
+    }
 
-    _publish_gyro(_gyro_instance, gyro);
-    _publish_accel(_accel_instance, accel);
+#if MPU9250_FIFO
+    _set_dropped_sample_count(_gyro_instance, _dropped_sample_count);
+#endif
 
     if (_last_accel_filter_hz != _accel_filter_cutoff()) {
         _set_accel_filter(_accel_filter_cutoff());
@@ -306,6 +339,26 @@ bool AP_InertialSensor_MPU9250::update( void )
     return true;
 }
 
+/*
+  rotate a vector from the chip axes to the board axes
+ */
+void AP_InertialSensor_MPU9250::_rotate_sensor(Vector3f &v) const
+{
+    // rotate for bbone default
+    v.rotate(ROTATION_ROLL_180_YAW_90);
+
+#if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_PXF
+    // PXF has an additional YAW 180
+    v.rotate(ROTATION_YAW_180);
+#elif CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_NAVIO
+    // NavIO has different orientation, assuming RaspberryPi is right
+    // way up, and PWM pins on NavIO are at the back of the aircraft
+    v.rotate(ROTATION_ROLL_180_YAW_90);
+#elif CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_BBBMINI
+    v.rotate(ROTATION_ROLL_180);
+#endif
+}
+
 /*================ HARDWARE FUNCTIONS ==================== */
 
 /**
@@ -318,14 +371,65 @@ void AP_InertialSensor_MPU9250::_poll_data(void)
           the semaphore being busy is an expected condition when the
           mainline code is calling wait_for_sample() which will
           grab the semaphore. We return now and rely on the mainline
-          code grabbing the latest sample.
+          code grabbing the latest sample. With the FIFO enabled the
+          samples wait in the sensor until the next tick.
         */
         return;
     }
+#if MPU9250_FIFO
+    _read_fifo();
+#else
     _read_data_transaction();
+#endif
     _spi_sem->give();
 }
 
+#define int16_val(v, idx) ((int16_t)(((uint16_t)v[2*idx] << 8) | v[2*idx+1]))
+
+/*
+  filter one accel sample and integrate it into the delta velocity
+ */
+void AP_InertialSensor_MPU9250::_accumulate_accel(const uint8_t *data, float dt)
+{
+    Vector3f accel(int16_val(data, 1),
+                   int16_val(data, 0),
+                   -int16_val(data, 2));
+
+    _accel_filtered = _accel_filter.apply(accel);
+
+    accel *= MPU9250_ACCEL_SCALE_1G;
+    _rotate_sensor(accel);
+    _rotate_and_correct_accel(_accel_instance, accel);
+    _notify_accel_raw_sample(_accel_instance, accel, dt);
+
+    _delta_velocity_accumulator += accel * dt;
+    _delta_velocity_dt += dt;
+}
+
+/*
+  filter one gyro sample and integrate it into the delta angle with
+  coning correction, as in AP_InertialSensor_PX4::_new_gyro_sample()
+ */
+void AP_InertialSensor_MPU9250::_accumulate_gyro(const uint8_t *data, float dt)
+{
+    Vector3f gyro(int16_val(data, 1),
+                  int16_val(data, 0),
+                  -int16_val(data, 2));
+
+    gyro *= GYRO_SCALE;
+    _rotate_sensor(gyro);
+    _rotate_and_correct_gyro(_gyro_instance, gyro);
+
+    // the notch runs at the raw rate ahead of the low pass filter
+    _gyro_filtered = _gyro_filter.apply(_notch_filter_gyro(_gyro_instance, gyro));
+
+    Vector3f delAng = (gyro + _last_gyro) * 0.5f * dt;
+    Vector3f delConing = ((_delta_angle_accumulator + _last_delAng * (1.0f/6.0f)) % delAng) * 0.5f;
+
+    _delta_angle_accumulator += delAng + delConing;
+    _last_delAng = delAng;
+    _last_gyro = gyro;
+}
 
 /*
   read from the data registers and update filtered data
@@ -341,23 +445,130 @@ void AP_InertialSensor_MPU9250::_read_data_transaction()
 
     _spi->transaction((const uint8_t *)&tx, (uint8_t *)&rx, sizeof(rx));
 
-#define int16_val(v, idx) ((int16_t)(((uint16_t)v[2*idx] << 8) | v[2*idx+1]))
+    _accumulate_accel(&rx.v[0], 1.0f / MPU9250_BASE_RATE_HZ);
+    _accumulate_gyro(&rx.v[8], 1.0f / MPU9250_BASE_RATE_HZ);
+
+    _have_sample_available = true;
+}
+
+#if MPU9250_FIFO
+/*
+  read the number of bytes waiting in the FIFO
+ */
+uint16_t AP_InertialSensor_MPU9250::_fifo_count()
+{
+    uint8_t tx[3] = { MPUREG_FIFO_COUNTH | 0x80, 0, 0 };
+    uint8_t rx[3];
+
+    _spi->transaction(tx, rx, 3);
+    return ((uint16_t)(rx[1] & 0x1F) << 8) | rx[2];
+}
+
+/*
+  discard the FIFO contents and restart sampling into it. Other bits
+  of USER_CTRL are kept as the AK8963 driver uses the I2C master
+ */
+void AP_InertialSensor_MPU9250::_fifo_reset()
+{
+    uint8_t user_ctrl = _register_read(MPUREG_USER_CTRL) & ~BIT_USER_CTRL_FIFO_EN;
+
+    _register_write(MPUREG_FIFO_EN, 0);
+    _register_write(MPUREG_USER_CTRL, user_ctrl | BIT_USER_CTRL_FIFO_RESET);
+    _register_write(MPUREG_USER_CTRL, user_ctrl | BIT_USER_CTRL_FIFO_EN);
+    if (_fifo_sample_size == MPU9250_GYRO_SAMPLE_SIZE) {
+        _register_write(MPUREG_FIFO_EN, BIT_XG_FIFO_EN | BIT_YG_FIFO_EN | BIT_ZG_FIFO_EN);
+    } else {
+        _register_write(MPUREG_FIFO_EN, BIT_TEMP_FIFO_EN | BIT_XG_FIFO_EN | BIT_YG_FIFO_EN |
+                        BIT_ZG_FIFO_EN | BIT_ACCEL_FIFO_EN);
+    }
+}
+
+/*
+  drain the samples queued in the FIFO in a single SPI burst, feeding
+  each one through the filters and into the delta angle and delta
+  velocity integration
+ */
+void AP_InertialSensor_MPU9250::_read_fifo()
+{
+    /*
+      read the interrupt status, followed by the accel registers
+      which are used when only the gyro goes through the FIFO
+     */
+    struct PACKED {
+        uint8_t cmd;
+        uint8_t int_status;
+        uint8_t accel[6];
+    } rx, tx = { cmd : MPUREG_INT_STATUS | 0x80, };
+
+    _spi->transaction((const uint8_t *)&tx, (uint8_t *)&rx, sizeof(rx));
+
+    uint32_t now = hal.scheduler->micros();
+    uint32_t sample_period_us = 1000000UL / _gyro_rate_hz;
+    uint16_t bytes = _fifo_count();
+    uint16_t queued = bytes / _fifo_sample_size;
+
+    if ((rx.int_status & BIT_FIFO_OFLOW_INT) ||
+        bytes > MPU9250_FIFO_SIZE ||
+        bytes % _fifo_sample_size != 0 ||
+        (queued == 0 && now - _last_sample_us > MPU9250_FIFO_STALL_US)) {
+        /*
+          samples have been lost, the FIFO is no longer aligned to a
+          sample boundary or it has stopped filling (for example when
+          another driver rewrote USER_CTRL). Start again and count the
+          samples we expected since the last good one as dropped
+         */
+        uint32_t expected = (now - _last_sample_us) / sample_period_us;
+        _fifo_overflow_count++;
+        _dropped_sample_count += expected > 0 ? expected : 1;
+        _fifo_reset();
+        _last_sample_us = now;
+        _last_accel_us = now;
+        return;
+    }
+
+    if (_fifo_sample_size == MPU9250_GYRO_SAMPLE_SIZE) {
+        // the accel is sampled once per tick, so integrate it over the
+        // time since the previous tick
+        float dt = constrain_float((now - _last_accel_us) * 1.0e-6f, 0.0f, 0.01f);
+        _last_accel_us = now;
+        _accumulate_accel(rx.accel, dt);
+    }
+
+    if (queued == 0) {
+        return;
+    }
+
+    /*
+      the newest sample in the FIFO was taken at about the current
+      time, with the older ones spaced by the output data rate
+     */
+    _last_sample_us = now;
+    uint8_t n = queued;
+    if (queued > MPU9250_FIFO_BURST_BYTES / _fifo_sample_size) {
+        n = MPU9250_FIFO_BURST_BYTES / _fifo_sample_size;
+        _last_sample_us -= (queued - n) * sample_period_us;
+    }
 
-    Vector3f _accel_filtered = _accel_filter.apply(Vector3f(int16_val(rx.v, 1),
-                                                   int16_val(rx.v, 0),
-                                                   -int16_val(rx.v, 2)));
+    uint16_t len = 1 + n*_fifo_sample_size;
 
-    Vector3f _gyro_filtered = _gyro_filter.apply(Vector3f(int16_val(rx.v, 5),
-                                                 int16_val(rx.v, 4),
-                                                 -int16_val(rx.v, 6)));
-    // update the shared buffer
-    uint8_t idx = _shared_data_idx ^ 1;
-    _shared_data[idx]._accel_filtered = _accel_filtered;
-    _shared_data[idx]._gyro_filtered = _gyro_filtered;
-    _shared_data_idx = idx;
+    memset(_fifo_tx, 0, len);
+    _fifo_tx[0] = MPUREG_FIFO_R_W | 0x80;
+    _spi->transaction(_fifo_tx, _fifo_rx, len);
+
+    float dt = 1.0f / _gyro_rate_hz;
+    for (uint8_t i=0; i<n; i++) {
+        const uint8_t *sample = &_fifo_rx[1 + i*_fifo_sample_size];
+        if (_fifo_sample_size == MPU9250_GYRO_SAMPLE_SIZE) {
+            _accumulate_gyro(sample, dt);
+        } else {
+            _accumulate_accel(&sample[0], dt);
+            _accumulate_gyro(&sample[8], dt);
+        }
+    }
 
     _have_sample_available = true;
 }
+#endif // MPU9250_FIFO
 
 /*
   read an 8 bit register
@@ -393,7 +604,7 @@ void AP_InertialSensor_MPU9250::_register_write(uint8_t reg, uint8_t val)
  */
 void AP_InertialSensor_MPU9250::_set_accel_filter(uint8_t filter_hz)
 {
-    _accel_filter.set_cutoff_frequency(1000, filter_hz);
+    _accel_filter.set_cutoff_frequency(MPU9250_BASE_RATE_HZ, filter_hz);
 }
 
 /*
@@ -401,7 +612,7 @@ void AP_InertialSensor_MPU9250::_set_accel_filter(uint8_t filter_hz)
  */
 void AP_InertialSensor_MPU9250::_set_gyro_filter(uint8_t filter_hz)
 {
-    _gyro_filter.set_cutoff_frequency(1000, filter_hz);
+    _gyro_filter.set_cutoff_frequency(_gyro_rate_hz, filter_hz);
 }
 
 
@@ -445,12 +656,29 @@ bool AP_InertialSensor_MPU9250::_hardware_init(void)
 
     _register_write(MPUREG_PWR_MGMT_2, 0x00);            // only used for wake-up in accelerometer only low power mode
 
-    // used no filter of 256Hz on the sensor, then filter using
-    // the 2-pole software filter
-    _register_write(MPUREG_CONFIG, BITS_DLPF_CFG_256HZ_NOLPF2);
+#if MPU9250_FIFO
+    if (_gyro_raw_rate_khz() >= MPU9250_FAST_RATE_HZ / 1000) {
+        // fast sampling: only the gyro goes through the FIFO
+        _gyro_rate_hz = MPU9250_FAST_RATE_HZ;
+        _fifo_sample_size = MPU9250_GYRO_SAMPLE_SIZE;
+    }
+#endif
+
+    if (_gyro_rate_hz == MPU9250_FAST_RATE_HZ) {
+        // 250Hz filter on the sensor, which gives an 8kHz gyro rate.
+        // Anti-alias filtering and decimation to the main loop rate is
+        // done by the 2-pole software filter running at 8kHz
+        _register_write(MPUREG_CONFIG, BITS_DLPF_CFG_256HZ_NOLPF2);
+    } else {
+        // 184Hz filter on the sensor, the lowest setting that keeps the
+        // gyro at 1kHz, then filter using the 2-pole software filter
+        _register_write(MPUREG_CONFIG, BITS_DLPF_CFG_188HZ);
+    }
+    _set_gyro_filter(_gyro_filter_cutoff());
 
     // set sample rate to 1kHz, and use the 2 pole filter to give the
-    // desired rate
+    // desired rate. This applies to the accel, and to the gyro when
+    // the sensor filter is enabled
     _register_write(MPUREG_SMPLRT_DIV, MPUREG_SMPLRT_1000HZ);
     _register_write(MPUREG_GYRO_CONFIG, BITS_GYRO_FS_2000DPS);  // Gyro scale 2000º/s
 
@@ -464,6 +692,13 @@ bool AP_InertialSensor_MPU9250::_hardware_init(void)
     // until we clear the interrupt
     _register_write(MPUREG_INT_PIN_CFG, BIT_INT_RD_CLEAR | BIT_LATCH_INT_EN);
 
+#if MPU9250_FIFO
+    // queue accel, temperature and gyro samples at the output data rate
+    _fifo_reset();
+    _last_sample_us = hal.scheduler->micros();
+    _last_accel_us = _last_sample_us;
+#endif
+
     // now that we have initialised, we set the SPI bus speed to high
     // (8MHz on APM2)
     _spi->set_bus_speed(AP_HAL::SPIDeviceDriver::SPI_SPEED_HIGH);
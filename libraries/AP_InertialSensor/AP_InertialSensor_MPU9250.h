@@ -14,6 +14,15 @@
 // enable debug to see a register dump on startup
 #define MPU9250_DEBUG 0
 
+// read samples through the sensor FIFO, so that every sample is used
+// even when a timer tick is late or the SPI bus is busy
+#ifndef MPU9250_FIFO
+#define MPU9250_FIFO 1
+#endif
+
+// most FIFO bytes read in one SPI burst
+#define MPU9250_FIFO_BURST_BYTES 448
+
 class AP_InertialSensor_MPU9250 : public AP_InertialSensor_Backend
 {
 public:
@@ -29,10 +38,26 @@ public:
     // detect the sensor
     static AP_InertialSensor_Backend *detect(AP_InertialSensor &imu);
 
+#if MPU9250_FIFO
+    // number of times the FIFO overflowed or lost alignment and was reset
+    uint32_t fifo_overflow_count(void) const { return _fifo_overflow_count; }
+
+    // number of sensor samples lost because of FIFO resets
+    uint32_t dropped_sample_count(void) const { return _dropped_sample_count; }
+#endif
+
 private:
     bool                 _init_sensor(void);
 
     void                 _read_data_transaction();
+    void                 _accumulate_accel(const uint8_t *data, float dt);
+    void                 _accumulate_gyro(const uint8_t *data, float dt);
+    void                 _rotate_sensor(Vector3f &v) const;
+#if MPU9250_FIFO
+    void                 _read_fifo();
+    uint16_t             _fifo_count();
+    void                 _fifo_reset();
+#endif
     bool                 _data_ready();
     void                 _poll_data(void);
     uint8_t              _register_read( uint8_t reg );
@@ -51,15 +76,10 @@ private:
     void _set_accel_filter(uint8_t filter_hz);
     void _set_gyro_filter(uint8_t filter_hz);
 
-    // This structure is used to pass data from the timer which reads
-    // the sensor to the main thread. The _shared_data_idx is used to
-    // prevent race conditions by ensuring the data is fully updated
-    // before being used by the consumer
-    struct {
-        Vector3f _accel_filtered;
-        Vector3f _gyro_filtered;
-    } _shared_data[2];
-    volatile uint8_t _shared_data_idx;
+    // latest filter outputs. The accel is in sensor units and the gyro
+    // is corrected body frame rad/s. Only read with timer procs suspended
+    Vector3f _accel_filtered;
+    Vector3f _gyro_filtered;
 
     // Low Pass filters for gyro and accel 
     LowPassFilter2pVector3f _accel_filter;
@@ -68,6 +88,36 @@ private:
     // do we currently have a sample pending?
     bool _have_sample_available;
 
+    // delta angle and delta velocity integrated at the raw sample
+    // rate since the last update(). Only read with timer procs suspended
+    Vector3f _delta_angle_accumulator;
+    Vector3f _delta_velocity_accumulator;
+    float _delta_velocity_dt;
+    Vector3f _last_delAng;
+    Vector3f _last_gyro;
+
+    // raw gyro sample rate
+    uint16_t _gyro_rate_hz;
+
+#if MPU9250_FIFO
+    // bytes per FIFO sample. At raw gyro rates above 1kHz only the
+    // gyro goes through the FIFO and the accel is read from its
+    // registers on each timer tick
+    uint8_t _fifo_sample_size;
+    uint32_t _last_accel_us;
+
+    uint32_t _fifo_overflow_count;
+    uint32_t _dropped_sample_count;
+
+    // time of the most recent sample taken from the FIFO, derived
+    // from the sensor output data rate
+    uint32_t _last_sample_us;
+
+    // SPI burst buffers, kept off the timer thread's stack
+    uint8_t _fifo_tx[1 + MPU9250_FIFO_BURST_BYTES];
+    uint8_t _fifo_rx[1 + MPU9250_FIFO_BURST_BYTES];
+#endif
+
     // gyro and accel instances
     uint8_t _gyro_instance;
     uint8_t _accel_instance;
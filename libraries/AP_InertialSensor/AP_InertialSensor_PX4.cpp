@@ -127,6 +127,7 @@ bool AP_InertialSensor_PX4::_init_sensor(void)
             hal.scheduler->panic("Invalid gyro sample rate");
         }
         _gyro_sample_time[i] = 1.0f / samplerate;
+        _set_gyro_raw_sample_rate(_gyro_instance[i], samplerate);
     }
 
     for (uint8_t i=0; i<_num_accel_instances; i++) {
@@ -216,6 +217,7 @@ bool AP_InertialSensor_PX4::update(void)
         if (_last_accel_timestamp[k] != _last_accel_update_timestamp[k]) {
             _publish_accel(_accel_instance[k], accel, false);
             _publish_delta_velocity(_accel_instance[k], _delta_velocity_accumulator[k], _delta_velocity_dt[k]);
+            _publish_vibration(_accel_instance[k]);
             _last_accel_update_timestamp[k] = _last_accel_timestamp[k];
         }
     }
@@ -264,6 +266,9 @@ void AP_InertialSensor_PX4::_new_accel_sample(uint8_t i, accel_report &accel_rep
     // get time since last sample
     float dt = _accel_sample_time[i];
 
+    // update vibration and clipping metrics
+    _notify_accel_raw_sample(frontend_instance, accel, dt);
+
     // compute delta velocity
     Vector3f delVel = Vector3f(accel.x, accel.y, accel.z) * dt;
 
@@ -305,8 +310,9 @@ void AP_InertialSensor_PX4::_new_gyro_sample(uint8_t i, gyro_report &gyro_report
     // apply corrections
     _rotate_and_correct_gyro(frontend_instance, gyro);
 
-    // apply filter for control path
-    _gyro_in[i] = _gyro_filter[i].apply(gyro);
+    // apply notch and low pass filters for control path. The delta
+    // angles are integrated from the unfiltered samples
+    _gyro_in[i] = _gyro_filter[i].apply(_notch_filter_gyro(frontend_instance, gyro));
 
     // get time since last sample
     float dt = _gyro_sample_time[i];
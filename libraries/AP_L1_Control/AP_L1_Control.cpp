@@ -163,12 +163,13 @@ void AP_L1_Control::update_waypoint(const struct Location &prev_WP, const struct
 	_L1_dist = 0.3183099f * _L1_damping * _L1_period * groundSpeed;
 	
 	// Calculate the NE position of WP B relative to WP A
-    Vector2f AB = location_diff(prev_WP, next_WP);
+    _ltp.set_origin(prev_WP);
+    Vector2f AB = _ltp.location_to_ne(next_WP);
 	
 	// Check for AB zero length and track directly to the destination
 	// if too small
 	if (AB.length() < 1.0e-6f) {
-		AB = location_diff(_current_loc, next_WP);
+		AB = _ltp.location_diff(_current_loc, next_WP);
         if (AB.length() < 1.0e-6f) {
             AB = Vector2f(cosf(_ahrs.yaw), sinf(_ahrs.yaw));
         }
@@ -176,7 +177,7 @@ void AP_L1_Control::update_waypoint(const struct Location &prev_WP, const struct
 	AB.normalize();
 
 	// Calculate the NE position of the aircraft relative to WP A
-    Vector2f A_air = location_diff(prev_WP, _current_loc);
+    Vector2f A_air = _ltp.location_to_ne(_current_loc);
 
 	// calculate distance to target track, for reporting
 	_crosstrack_error = AB % A_air;
@@ -260,7 +261,8 @@ void AP_L1_Control::update_loiter(const struct Location &center_WP, float radius
 	_L1_dist = 0.3183099f * _L1_damping * _L1_period * groundSpeed;
 
 	//Calculate the NE position of the aircraft relative to WP A
-    Vector2f A_air = location_diff(center_WP, _current_loc);
+    _ltp.set_origin(center_WP);
+    Vector2f A_air = _ltp.location_to_ne(_current_loc);
 
     // Calculate the unit vector from WP A to aircraft
     // protect against being on the waypoint and having zero velocity
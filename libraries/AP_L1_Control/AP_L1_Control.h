@@ -85,6 +85,10 @@ private:
 	// target bearing in centi-degrees from last update
 	int32_t _target_bearing_cd;
 
+	// projection about the waypoint being tracked from, so the trig
+	// is only redone when the waypoint changes latitude
+	LocalTangentPlane _ltp;
+
 	// L1 tracking loop period (sec)
 	AP_Float _L1_period;
 	// L1 tracking loop damping ratio
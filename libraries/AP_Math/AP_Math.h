@@ -19,6 +19,7 @@
 #include "quaternion.h"
 #include "polygon.h"
 #include "edc.h"
+#include "lm_solver.h"
 #include "float.h"
 
 #ifndef M_PI_F
@@ -196,6 +197,12 @@ float sq(float v);
 float pythagorous2(float a, float b);
 float pythagorous3(float a, float b, float c);
 
+// approximations for the fast loop
+#include "fast_math.h"
+
+// projection of locations about a fixed origin
+#include "local_tangent_plane.h"
+
 #ifdef radians
 #error "Build is including Arduino base headers"
 #endif
@@ -0,0 +1,175 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+//
+// Accuracy tests and benchmark of the AP_Math fast math functions
+//
+
+
+#include <AP_HAL.h>
+#include <stdlib.h>
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Param.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_Empty.h>
+#include <AP_HAL_PX4.h>
+#include <AP_HAL_Linux.h>
+#include <AP_Math.h>
+#include <Filter.h>
+#include <AP_ADC.h>
+#include <SITL.h>
+#include <AP_Compass.h>
+#include <AP_Baro.h>
+#include <AP_Notify.h>
+#include <AP_InertialSensor.h>
+#include <AP_GPS.h>
+#include <DataFlash.h>
+#include <GCS_MAVLink.h>
+#include <AP_Mission.h>
+#include <StorageManager.h>
+#include <AP_Terrain.h>
+#include <AP_Declination.h>
+#include <AP_AHRS.h>
+#include <AP_NavEKF.h>
+#include <AP_Airspeed.h>
+#include <AP_Vehicle.h>
+#include <AP_ADC_AnalogSource.h>
+#include <AP_Rally.h>
+#include <AP_BattMonitor.h>
+#include <AP_Gimbal.h>
+#include <AP_Mount.h>
+#include <RC_Channel.h>
+#include <AP_OpticalFlow.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+/*
+  the largest errors found by sweeping each approximation over its
+  range, compared with the libm functions it replaces
+ */
+#define SWEEP_STEPS 100000
+
+static bool check(const char *name, float max_err, float limit)
+{
+    bool ok = max_err < limit;
+    hal.console->printf("%-16s max error %.3e limit %.1e %s\n",
+                        name, max_err, limit, ok ? "OK" : "FAILED");
+    return ok;
+}
+
+static bool test_accuracy(void)
+{
+    float err_sin = 0, err_cos = 0, err_atan2 = 0, err_asin = 0;
+    float err_isqrt = 0, err_wrap = 0, err_wrap_cd = 0;
+
+    for (int32_t i=-SWEEP_STEPS; i<=SWEEP_STEPS; i++) {
+        float angle = i * (10*PI / SWEEP_STEPS);
+        float s, c;
+        fast_sincosf(angle, &s, &c);
+        err_sin = max(err_sin, fabsf(s - sinf(angle)));
+        err_cos = max(err_cos, fabsf(c - cosf(angle)));
+        err_wrap = max(err_wrap, fabsf(fast_wrap_PI(angle) - wrap_PI(angle)));
+        float cd = angle * 10000;
+        err_wrap_cd = max(err_wrap_cd, fabsf(fast_wrap_180_cd(cd) - wrap_180_cd_float(cd)));
+
+        // points around circles of several radii
+        float r = 0.1f + (i & 7);
+        float y = sinf(angle) * r;
+        float x = cosf(angle) * r;
+        err_atan2 = max(err_atan2, fabsf(wrap_PI(fast_atan2f(y, x) - atan2f(y, x))));
+
+        float v = (float)i / SWEEP_STEPS;
+        err_asin = max(err_asin, fabsf(fast_safe_asin(v) - safe_asin(v)));
+
+        float sq_in = 1.0e-3f + fabsf(angle) * (1 + (i & 15));
+        err_isqrt = max(err_isqrt, fabsf(fast_inv_sqrtf(sq_in) * sqrtf(sq_in) - 1.0f));
+    }
+
+    bool ok = true;
+    ok &= check("fast_sinf", err_sin, 1.0e-5f);
+    ok &= check("fast_cosf", err_cos, 1.0e-5f);
+    ok &= check("fast_atan2f", err_atan2, 2.0e-5f);
+    ok &= check("fast_safe_asin", err_asin, 2.0e-5f);
+    ok &= check("fast_inv_sqrtf", err_isqrt, 5.0e-6f);
+    // fast_wrap_PI may differ by a full turn at +-PI
+    ok &= check("fast_wrap_PI", err_wrap > PI ? fabsf(err_wrap - 2*PI) : err_wrap, 1.0e-5f);
+    ok &= check("fast_wrap_180_cd", err_wrap_cd, 0.01f);
+
+    // special values
+    ok &= check("wrap_cd(18000)", fabsf(fast_wrap_180_cd(18000) - wrap_180_cd_float(18000)), 1.0f);
+    ok &= check("wrap_cd(-18000)", fabsf(fast_wrap_180_cd(-18000) - wrap_180_cd_float(-18000)), 1.0f);
+    ok &= check("wrap_cd(54000)", fabsf(fast_wrap_180_cd(54000) - wrap_180_cd_float(54000)), 1.0f);
+    ok &= check("wrap_cd(-54000)", fabsf(fast_wrap_180_cd(-54000) - wrap_180_cd_float(-54000)), 1.0f);
+    ok &= check("atan2(0,0)", fabsf(fast_atan2f(0, 0)), 1.0e-7f);
+    ok &= check("safe_asin(2)", fabsf(fast_safe_asin(2) - PI/2), 1.0e-6f);
+    ok &= check("safe_asin(nan)", fabsf(fast_safe_asin(NAN)), 1.0e-7f);
+    return ok;
+}
+
+/*
+  time NUM_CALLS calls of each function and its libm equivalent
+ */
+#define NUM_CALLS 10000
+
+static volatile float sink;
+
+static float bench_input(uint16_t i)
+{
+    return (i - NUM_CALLS/2) * 0.001f;
+}
+
+static float fast_sincos_sum(float v)
+{
+    float s, c;
+    fast_sincosf(v, &s, &c);
+    return s + c;
+}
+
+#define BENCH(name, expr) do {                                          \
+        float sum = 0;                                                  \
+        uint32_t t0 = hal.scheduler->micros();                          \
+        for (uint16_t i=0; i<NUM_CALLS; i++) {                          \
+            float v = bench_input(i);                                   \
+            sum += expr;                                                \
+        }                                                               \
+        sink = sum;                                                     \
+        hal.console->printf("%-20s %6.1f nsec/call\n", name,             \
+                            (hal.scheduler->micros() - t0) * (1000.0f / NUM_CALLS)); \
+    } while (0)
+
+static void benchmark(void)
+{
+    BENCH("sinf", sinf(v));
+    BENCH("fast_sinf", fast_sinf(v));
+    BENCH("sinf+cosf", sinf(v) + cosf(v));
+    BENCH("fast_sincosf", fast_sincos_sum(v));
+    BENCH("atan2f", atan2f(v, 0.7f));
+    BENCH("fast_atan2f", fast_atan2f(v, 0.7f));
+    BENCH("safe_asin", safe_asin(v * 0.2f));
+    BENCH("fast_safe_asin", fast_safe_asin(v * 0.2f));
+    BENCH("1/sqrtf", 1.0f / sqrtf(fabsf(v) + 1));
+    BENCH("fast_inv_sqrtf", fast_inv_sqrtf(fabsf(v) + 1));
+    BENCH("wrap_PI", wrap_PI(v * 10));
+    BENCH("fast_wrap_PI", fast_wrap_PI(v * 10));
+    BENCH("wrap_180_cd_float", wrap_180_cd_float(v * 10000));
+    BENCH("fast_wrap_180_cd", fast_wrap_180_cd(v * 10000));
+    hal.console->println();
+}
+
+void setup(void)
+{
+    hal.console->println("fast math tests");
+    if (test_accuracy()) {
+        hal.console->println("all tests passed\n");
+    } else {
+        hal.console->println("TESTS FAILED\n");
+    }
+}
+
+void loop(void)
+{
+    benchmark();
+    hal.scheduler->delay(5000);
+}
+
+AP_HAL_MAIN();
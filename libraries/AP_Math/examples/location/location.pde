@@ -205,6 +205,100 @@ static void test_accuracy(void)
     }
 }
 
+/*
+  test the local tangent plane projection against location_diff() near
+  the origin and for round trips far from it, and its east-west error
+  against a spherical earth far from the origin
+ */
+static void test_tangent_plane(void)
+{
+    // meters per 1e-7 degrees, and the radius of the same sphere
+    const double lat_to_m = 0.011131884502145034;
+    const double radius = lat_to_m * 1.0e7 / 1.7453292519943295e-2;
+
+    struct Location origin = {0};
+    origin.lat = -35.3632620e7;
+    origin.lng = 149.1652370e7;
+    origin.alt = 58400;
+
+    LocalTangentPlane ltp;
+    ltp.set_origin(origin);
+
+    float max_diff_error = 0, max_round_trip_error = 0;
+    float max_east_error = 0, max_east_error_near = 0;
+    for (int8_t i=-20; i<=20; i++) {
+        for (int8_t j=-20; j<=20; j++) {
+            // points up to 200km from the origin
+            Vector2f ne(i*10000.0f + 0.37f, j*10000.0f - 0.21f);
+            struct Location loc = origin;
+            ltp.ne_to_location(ne, loc);
+            max_round_trip_error = max(max_round_trip_error, (ltp.location_to_ne(loc) - ne).length());
+
+            // numerical accuracy: a pair 10m apart with the origin's
+            // scale factors, which the float location_diff() resolves
+            // only as well as its cached longitude_scale()
+            struct Location loc2 = loc;
+            loc2.lat += 500;
+            loc2.lng -= 700;
+            Vector2f diff = ltp.location_diff(loc, loc2);
+            Vector2f expected(500 * lat_to_m, -700 * lat_to_m * cos(origin.lat * 1.7453292519943295e-9));
+            max_diff_error = max(max_diff_error, (diff - expected).length());
+
+            // geometric accuracy: the east offset on the sphere at the
+            // pair's own latitude
+            double mid_lat = (loc.lat + 250) * 1.7453292519943295e-9;
+            double east = -700 * 1.7453292519943295e-9 * radius * cos(mid_lat);
+            float east_error = fabs((diff.y - east) / east);
+            max_east_error = max(max_east_error, east_error);
+            if (i >= -1 && i <= 1) {
+                max_east_error_near = max(max_east_error_near, east_error);
+            }
+        }
+    }
+    hal.console->printf("tangent plane: round trip error %.4f m, diff error %.6f m\n",
+                        max_round_trip_error, max_diff_error);
+    hal.console->printf("tangent plane: east error %.2f%% within 10km north/south, %.2f%% within 200km\n",
+                        max_east_error_near*100, max_east_error*100);
+    if (max_round_trip_error > 0.02f || max_diff_error > 0.001f) {
+        hal.console->printf("Failed tangent plane test\n");
+    }
+    // about tan(35 degrees) * north offset / radius
+    if (max_east_error_near > 0.0015f || max_east_error > 0.025f) {
+        hal.console->printf("Failed tangent plane east error test\n");
+    }
+
+    // close to the origin the result matches location_diff()
+    struct Location loc = origin;
+    location_offset(loc, 120, -80);
+    Vector2f error = ltp.location_to_ne(loc) - location_diff(origin, loc);
+    if (error.length() > 0.01f) {
+        hal.console->printf("Failed tangent plane location_diff test error=%f\n", error.length());
+    }
+
+    // either side of the 180 degree meridian
+    origin.lat = 0;
+    origin.lng = 1799999990;
+    ltp.set_origin(origin);
+    loc = origin;
+    loc.lng = -1799999990;
+    Vector2f ne = ltp.location_to_ne(loc);
+    if (fabsf(ne.y - 20 * 0.011131884f) > 0.001f) {
+        hal.console->printf("Failed tangent plane meridian test east=%f\n", ne.y);
+    }
+    ltp.ne_to_location(Vector2f(0, 1.0f), loc);
+    if (loc.lng > -1799990000) {
+        hal.console->printf("Failed tangent plane wrap test lng=%ld\n", (long)loc.lng);
+    }
+
+    // altitudes are down from the origin
+    ltp.ned_to_location(Vector3f(1, 2, -3.5f), loc);
+    if (loc.alt != origin.alt + 350 || fabsf(ltp.location_to_ned(loc).z + 3.5f) > 0.001f) {
+        hal.console->printf("Failed tangent plane altitude test alt=%ld\n", (long)loc.alt);
+    }
+
+    hal.console->printf("tangent plane tests done\n");
+}
+
 static const struct {
     int32_t v, wv;
 } wrap_180_tests[] = {
@@ -359,6 +453,7 @@ void setup(void)
     test_passed_waypoint();
     test_offset();
     test_accuracy();
+    test_tangent_plane();
     test_wrap_cd();
 #if HAL_CPU_CLASS >= HAL_CPU_CLASS_75
     test_wgs_conversion_functions();
@@ -0,0 +1,325 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+//
+// Tests and benchmark of the AP_Math MatrixN template
+//
+
+
+#include <AP_HAL.h>
+#include <stdlib.h>
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Param.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_Empty.h>
+#include <AP_HAL_PX4.h>
+#include <AP_HAL_Linux.h>
+#include <AP_Math.h>
+#include <Filter.h>
+#include <AP_ADC.h>
+#include <SITL.h>
+#include <AP_Compass.h>
+#include <AP_Baro.h>
+#include <AP_Notify.h>
+#include <AP_InertialSensor.h>
+#include <AP_GPS.h>
+#include <DataFlash.h>
+#include <GCS_MAVLink.h>
+#include <AP_Mission.h>
+#include <StorageManager.h>
+#include <AP_Terrain.h>
+#include <AP_Declination.h>
+#include <AP_AHRS.h>
+#include <AP_NavEKF.h>
+#include <AP_Airspeed.h>
+#include <AP_Vehicle.h>
+#include <AP_ADC_AnalogSource.h>
+#include <AP_Rally.h>
+#include <AP_BattMonitor.h>
+#include <AP_Gimbal.h>
+#include <AP_Mount.h>
+#include <RC_Channel.h>
+#include <AP_OpticalFlow.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#include <matrixN.h>
+
+/*
+  the products and factorisations compared with direct loops over the
+  elements. Test matrices are filled from a sine of the indices, so
+  the tests are repeatable and the matrices have no structure
+ */
+template <uint8_t R, uint8_t C>
+static void fill(MatrixN<float,R,C> &m, float phase)
+{
+    for (uint8_t i=0; i<R; i++) {
+        for (uint8_t j=0; j<C; j++) {
+            m(i,j) = 0.5f * sinf(phase + 1.3f*i + 2.9f*j + 0.1f*i*j);
+        }
+    }
+}
+
+template <uint8_t N>
+static void fill(VectorN<float,N> &v, float phase)
+{
+    for (uint8_t i=0; i<N; i++) {
+        v[i] = 0.5f * sinf(phase + 1.7f*i);
+    }
+}
+
+/*
+  print the first element of a that differs from b by more than
+  accuracy, returning false if there is one
+ */
+template <uint8_t R, uint8_t C>
+static bool compare(const char *test, const MatrixN<float,R,C> &a, const MatrixN<float,R,C> &b, float accuracy)
+{
+    for (uint8_t i=0; i<R; i++) {
+        for (uint8_t j=0; j<C; j++) {
+            if (!(fabsf(a(i,j) - b(i,j)) <= accuracy)) {
+                hal.console->printf("%s failed: (%u,%u) is %f, expected %f\n",
+                                    test, (unsigned)i, (unsigned)j, a(i,j), b(i,j));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <uint8_t N>
+static bool compare(const char *test, const VectorN<float,N> &a, const VectorN<float,N> &b, float accuracy)
+{
+    for (uint8_t i=0; i<N; i++) {
+        if (!(fabsf(a[i] - b[i]) <= accuracy)) {
+            hal.console->printf("%s failed: [%u] is %f, expected %f\n",
+                                test, (unsigned)i, a[i], b[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool test_products(void)
+{
+    MatrixN<float,5,7> a;
+    MatrixN<float,7,4> b;
+    fill(a, 0.0f);
+    fill(b, 1.0f);
+
+    MatrixN<float,5,4> ab;
+    for (uint8_t i=0; i<5; i++) {
+        for (uint8_t j=0; j<4; j++) {
+            for (uint8_t k=0; k<7; k++) {
+                ab(i,j) += a(i,k) * b(k,j);
+            }
+        }
+    }
+
+    bool ok = true;
+    ok &= compare("operator *", a * b, ab, 1.0e-6f);
+    ok &= compare("mul_transposed", a.mul_transposed(b.transposed()), ab, 1.0e-6f);
+    ok &= compare("transposed_mul", a.transposed().transposed_mul(b), ab, 1.0e-6f);
+
+    // the vector products against a one column matrix
+    VectorN<float,7> v;
+    fill(v, 2.0f);
+    MatrixN<float,7,1> vm;
+    for (uint8_t i=0; i<7; i++) {
+        vm(i,0) = v[i];
+    }
+    VectorN<float,5> av = a * v;
+    VectorN<float,7> atav = a.mul_transpose(av);
+    MatrixN<float,5,1> avm = a * vm;
+    MatrixN<float,7,1> atavm = a.transposed_mul(avm);
+    VectorN<float,5> av_expected;
+    VectorN<float,7> atav_expected;
+    for (uint8_t i=0; i<5; i++) {
+        av_expected[i] = avm(i,0);
+    }
+    for (uint8_t i=0; i<7; i++) {
+        atav_expected[i] = atavm(i,0);
+    }
+    ok &= compare("matrix * vector", av, av_expected, 1.0e-6f);
+    ok &= compare("mul_transpose", atav, atav_expected, 1.0e-6f);
+    return ok;
+}
+
+static bool test_factorisations(void)
+{
+    // a well conditioned covariance from 10 measurements of 6 states
+    MatrixN<float,10,6> h;
+    fill(h, 3.0f);
+    MatrixN<float,6,6> P;
+    P.identity();
+    P.rank_update(h, 2.0f);
+    VectorN<float,6> v;
+    fill(v, 4.0f);
+    P.rank1_update(v, 0.5f);
+    P.force_symmetry();
+
+    MatrixN<float,6,6> expected;
+    expected.identity();
+    expected += h.transposed_mul(h) * 2.0f;
+    for (uint8_t i=0; i<6; i++) {
+        for (uint8_t j=0; j<6; j++) {
+            expected(i,j) += 0.5f * v[i] * v[j];
+        }
+    }
+
+    bool ok = true;
+    ok &= compare("rank updates", P, expected, 1.0e-5f);
+
+    MatrixN<float,6,6> L;
+    if (!P.cholesky(L)) {
+        hal.console->printf("cholesky failed on a positive definite matrix\n");
+        return false;
+    }
+    ok &= compare("cholesky", L.mul_transposed(L), P, 1.0e-5f);
+    ok &= compare("cholesky_solve", P * MatrixN<float,6,6>::cholesky_solve(L, v), v, 1.0e-5f);
+
+    VectorN<float,6> d;
+    if (!P.ldlt(L, d)) {
+        hal.console->printf("ldlt failed on a positive definite matrix\n");
+        return false;
+    }
+    ok &= compare("ldlt_solve", P * MatrixN<float,6,6>::ldlt_solve(L, d, v), v, 1.0e-5f);
+
+    // indefinite matrix: no Cholesky factor, but LDL' works
+    MatrixN<float,2,2> q;
+    q(0,0) = 1;
+    q(1,1) = -1;
+    q(0,1) = q(1,0) = 0.5f;
+    MatrixN<float,2,2> lq;
+    VectorN<float,2> dq, b;
+    b[0] = 1;
+    b[1] = 2;
+    if (q.cholesky(lq)) {
+        hal.console->printf("cholesky of an indefinite matrix did not fail\n");
+        ok = false;
+    }
+    if (!q.ldlt(lq, dq)) {
+        hal.console->printf("ldlt failed on an indefinite matrix\n");
+        return false;
+    }
+    ok &= compare("indefinite ldlt_solve", q * MatrixN<float,2,2>::ldlt_solve(lq, dq, b), b, 1.0e-6f);
+    return ok;
+}
+
+/*
+  time a covariance prediction P = F*P*F' of the size of the NavEKF
+  state against the nested VectorN loops the filter used to write out
+ */
+#define NUM_STATES  22
+#define NUM_REPEATS 20
+
+typedef MatrixN<float,NUM_STATES,NUM_STATES> MatrixStates;
+typedef VectorN<VectorN<float,NUM_STATES>,NUM_STATES> NestedStates;
+
+static MatrixStates F, P, FP, FPFt;
+static NestedStates nF, nP, nFP, nFPFt;
+
+static void bench_nested(void)
+{
+    for (uint8_t i=0; i<NUM_STATES; i++) {
+        for (uint8_t j=0; j<NUM_STATES; j++) {
+            float sum = 0;
+            for (uint8_t k=0; k<NUM_STATES; k++) {
+                sum += nF[i][k] * nP[k][j];
+            }
+            nFP[i][j] = sum;
+        }
+    }
+    for (uint8_t i=0; i<NUM_STATES; i++) {
+        for (uint8_t j=0; j<NUM_STATES; j++) {
+            float sum = 0;
+            for (uint8_t k=0; k<NUM_STATES; k++) {
+                sum += nFP[i][k] * nF[j][k];
+            }
+            nFPFt[i][j] = sum;
+        }
+    }
+}
+
+static void bench_matrixN(void)
+{
+    FP = F * P;
+    FPFt = FP.mul_transposed(F);
+}
+
+static void benchmark(void)
+{
+    uint32_t t0 = hal.scheduler->micros();
+    for (uint8_t r=0; r<NUM_REPEATS; r++) {
+        bench_nested();
+    }
+    uint32_t t_nested = hal.scheduler->micros() - t0;
+
+    t0 = hal.scheduler->micros();
+    for (uint8_t r=0; r<NUM_REPEATS; r++) {
+        bench_matrixN();
+    }
+    uint32_t t_matrix = hal.scheduler->micros() - t0;
+
+    MatrixStates L;
+    uint8_t factored = 0;
+    t0 = hal.scheduler->micros();
+    for (uint8_t r=0; r<NUM_REPEATS; r++) {
+        factored += P.cholesky(L);
+    }
+    uint32_t t_chol = hal.scheduler->micros() - t0;
+
+    float err = 0;
+    for (uint8_t i=0; i<NUM_STATES; i++) {
+        for (uint8_t j=0; j<NUM_STATES; j++) {
+            err = max(err, fabsf(FPFt(i,j) - nFPFt[i][j]));
+        }
+    }
+
+    hal.console->printf("F*P*F' %ux%u: nested loops %.1f usec, MatrixN %.1f usec, difference %.1e\n",
+                        (unsigned)NUM_STATES, (unsigned)NUM_STATES,
+                        t_nested / (float)NUM_REPEATS, t_matrix / (float)NUM_REPEATS, err);
+    hal.console->printf("cholesky %ux%u: %.1f usec, %u/%u factored\n\n",
+                        (unsigned)NUM_STATES, (unsigned)NUM_STATES,
+                        t_chol / (float)NUM_REPEATS, (unsigned)factored, (unsigned)NUM_REPEATS);
+}
+
+void setup(void)
+{
+    hal.console->println("MatrixN tests");
+    bool ok = test_products();
+    ok &= test_factorisations();
+    if (ok) {
+        hal.console->println("all tests passed\n");
+    } else {
+        hal.console->println("TESTS FAILED\n");
+    }
+
+    // a dense transition, so the zero skipping in operator * does not
+    // help, and a positive definite covariance
+    fill(F, 5.0f);
+    F *= 0.02f;
+    fill(P, 6.0f);
+    P *= 0.02f;
+    P = P.mul_transposed(P);
+    for (uint8_t i=0; i<NUM_STATES; i++) {
+        F(i,i) += 1;
+    }
+    for (uint8_t i=0; i<NUM_STATES; i++) {
+        P(i,i) += 1;
+    }
+    for (uint8_t i=0; i<NUM_STATES; i++) {
+        for (uint8_t j=0; j<NUM_STATES; j++) {
+            nF[i][j] = F(i,j);
+            nP[i][j] = P(i,j);
+        }
+    }
+}
+
+void loop(void)
+{
+    benchmark();
+    hal.scheduler->delay(5000);
+}
+
+AP_HAL_MAIN();
@@ -0,0 +1,203 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  approximate trig, square root and angle wrapping for the fast loop.
+
+  The polynomial versions are used when AP_MATH_FAST_MATH is 1,
+  otherwise these call libm. Error bounds, checked by examples/fast_math:
+
+    fast_sinf, fast_cosf, fast_sincosf     < 1.0e-5 for |angle| < 10*PI
+    fast_atan2f                            < 2.0e-5 radians
+    fast_safe_asin                         < 2.0e-5 radians
+    fast_inv_sqrtf                         < 5.0e-6 relative
+
+  The angle wraps reduce with one multiply and a conversion to integer
+  instead of loops or fmodf(), with the same rounding error as the
+  loops in wrap_PI() and wrap_180_cd_float(). fast_wrap_180_cd()
+  returns the same as wrap_180_cd_float() on the +-18000 boundary. An
+  angle within rounding error of an odd multiple of PI may come back
+  from fast_wrap_PI() as -PI where wrap_PI() gives PI, or the reverse.
+ */
+
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifndef AP_MATH_FAST_MATH
+#define AP_MATH_FAST_MATH 1
+#endif
+
+// single precision, unlike M_PI_2 from math.h
+#define FAST_MATH_PI_2 1.5707963f
+
+// nearest whole number to v, for |v| < 2^31
+static inline float fast_roundf(float v)
+{
+    return (float)(int32_t)(v + (v >= 0.0f ? 0.5f : -0.5f));
+}
+
+/*
+  wrap an angle in radians to -PI ~ PI
+ */
+static inline float fast_wrap_PI(float angle)
+{
+    if (fabsf(angle) > 1.0e8f) {
+        // too large to convert to an integer number of turns
+        angle = fmodf(angle, M_2PI_F);
+    }
+    return angle - M_2PI_F * fast_roundf(angle * (1.0f / M_2PI_F));
+}
+
+/*
+  wrap an angle in centi-degrees to -18000 ~ 18000. An angle on the
+  boundary keeps its sign, as in wrap_180_cd_float()
+ */
+static inline float fast_wrap_180_cd(float angle)
+{
+    if (fabsf(angle) > 1.0e9f) {
+        angle = fmodf(angle, 36000.0f);
+    }
+    float ret = angle - 36000.0f * fast_roundf(angle * (1.0f / 36000.0f));
+    if (fabsf(ret) == 18000.0f) {
+        ret = angle > 0 ? 18000.0f : -18000.0f;
+    }
+    return ret;
+}
+
+#if AP_MATH_FAST_MATH
+
+/*
+  sine and cosine of an angle in radians. The angle is wrapped to
+  -PI ~ PI and reflected into -PI/2 ~ PI/2, where the Taylor series to
+  the 9th and 10th powers are accurate to 4e-6 and 5e-7
+ */
+static inline void fast_sincosf(float angle, float *s, float *c)
+{
+    float x = fast_wrap_PI(angle);
+    float sign_c = 1.0f;
+    if (x > FAST_MATH_PI_2) {
+        x = M_PI_F - x;
+        sign_c = -1.0f;
+    } else if (x < -FAST_MATH_PI_2) {
+        x = -M_PI_F - x;
+        sign_c = -1.0f;
+    }
+    const float x2 = x * x;
+    if (s != NULL) {
+        *s = x * (1.0f + x2 * (-1.0f/6 + x2 * (1.0f/120 + x2 * (-1.0f/5040 + x2 * (1.0f/362880)))));
+    }
+    if (c != NULL) {
+        *c = sign_c * (1.0f + x2 * (-0.5f + x2 * (1.0f/24 + x2 * (-1.0f/720 + x2 * (1.0f/40320 + x2 * (-1.0f/3628800))))));
+    }
+}
+
+static inline float fast_sinf(float angle)
+{
+    float s;
+    fast_sincosf(angle, &s, NULL);
+    return s;
+}
+
+static inline float fast_cosf(float angle)
+{
+    float c;
+    fast_sincosf(angle, NULL, &c);
+    return c;
+}
+
+/*
+  atan2 from the octant of (x,y) and the polynomial for atan on
+  [0,1] from Abramowitz and Stegun 4.4.47, accurate to 1e-5
+ */
+static inline float fast_atan2f(float y, float x)
+{
+    const float ax = fabsf(x);
+    const float ay = fabsf(y);
+    const float hi = ax > ay ? ax : ay;
+    if (hi == 0.0f) {
+        return 0.0f;
+    }
+    const float lo = ax > ay ? ay : ax;
+    const float z = lo / hi;
+    const float z2 = z * z;
+    float a = z * (0.9998660f + z2 * (-0.3302995f + z2 * (0.1801410f + z2 * (-0.0851330f + z2 * 0.0208351f))));
+    if (ay > ax) {
+        a = FAST_MATH_PI_2 - a;
+    }
+    if (x < 0.0f) {
+        a = M_PI_F - a;
+    }
+    return y < 0.0f ? -a : a;
+}
+
+/*
+  1/sqrt(v) for v > 0 from the exponent estimate with two Newton steps
+ */
+static inline float fast_inv_sqrtf(float v)
+{
+    uint32_t i;
+    memcpy(&i, &v, sizeof(i));
+    i = 0x5f3759df - (i >> 1);
+    float r;
+    memcpy(&r, &i, sizeof(r));
+    const float half_v = 0.5f * v;
+    r = r * (1.5f - half_v * r * r);
+    r = r * (1.5f - half_v * r * r);
+    return r;
+}
+
+#else // AP_MATH_FAST_MATH
+
+static inline void fast_sincosf(float angle, float *s, float *c)
+{
+    if (s != NULL) {
+        *s = sinf(angle);
+    }
+    if (c != NULL) {
+        *c = cosf(angle);
+    }
+}
+
+static inline float fast_sinf(float angle) { return sinf(angle); }
+static inline float fast_cosf(float angle) { return cosf(angle); }
+static inline float fast_atan2f(float y, float x) { return atan2f(y, x); }
+static inline float fast_inv_sqrtf(float v) { return 1.0f / sqrtf(v); }
+
+#endif // AP_MATH_FAST_MATH
+
+/*
+  a variant of safe_asin() using fast_atan2f(). Inputs outside -1 ~ 1
+  are limited and nan gives zero
+ */
+static inline float fast_safe_asin(float v)
+{
+    if (isnan(v)) {
+        return 0.0f;
+    }
+    if (v >= 1.0f) {
+        return FAST_MATH_PI_2;
+    }
+    if (v <= -1.0f) {
+        return -FAST_MATH_PI_2;
+    }
+    return fast_atan2f(v, sqrtf(1.0f - v * v));
+}
+
+#endif // FAST_MATH_H
@@ -0,0 +1,116 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  Gauss-Newton / Levenberg-Marquardt step solver for least squares fits
+  of N parameters. The normal equations are accumulated one sample at a
+  time and solved with a Cholesky decomposition, all in fixed size
+  storage so a fit never allocates memory.
+
+  See http://en.wikipedia.org/wiki/Levenberg%E2%80%93Marquardt_algorithm
+ */
+
+#ifndef LM_SOLVER_H
+#define LM_SOLVER_H
+
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+
+template <uint8_t N>
+class LMSolver
+{
+public:
+    LMSolver() {
+        reset();
+    }
+
+    // clear the accumulated normal equations
+    void reset() {
+        memset(_JTJ, 0, sizeof(_JTJ));
+        memset(_JTFI, 0, sizeof(_JTFI));
+    }
+
+    /*
+      add the jacobian row and residual of one sample. Only the lower
+      triangle of the symmetric JTJ is accumulated
+     */
+    void add_sample(const float jacob[N], float residual) {
+        for (uint8_t i=0; i<N; i++) {
+            const float ji = jacob[i];
+            float *row = _JTJ[i];
+            for (uint8_t j=0; j<=i; j++) {
+                row[j] += ji * jacob[j];
+            }
+            _JTFI[i] += ji * residual;
+        }
+    }
+
+    /*
+      solve (JTJ + lambda*I) * delta = JTFI. The caller subtracts delta
+      from its parameters. Returns false if the damped JTJ is not
+      positive definite
+     */
+    bool solve(float lambda, float delta[N]) const {
+        float L[N][N];
+
+        // Cholesky decomposition JTJ + lambda*I = L*L'
+        for (uint8_t i=0; i<N; i++) {
+            for (uint8_t j=0; j<=i; j++) {
+                float sum = _JTJ[i][j];
+                if (i == j) {
+                    sum += lambda;
+                }
+                for (uint8_t k=0; k<j; k++) {
+                    sum -= L[i][k] * L[j][k];
+                }
+                if (i == j) {
+                    if (!(sum > 0.0f)) {
+                        return false;
+                    }
+                    L[i][i] = sqrtf(sum);
+                } else {
+                    L[i][j] = sum / L[j][j];
+                }
+            }
+        }
+
+        // forward substitution L*y = JTFI
+        for (uint8_t i=0; i<N; i++) {
+            float sum = _JTFI[i];
+            for (uint8_t k=0; k<i; k++) {
+                sum -= L[i][k] * delta[k];
+            }
+            delta[i] = sum / L[i][i];
+        }
+
+        // back substitution L'*delta = y
+        for (int8_t i=N-1; i>=0; i--) {
+            float sum = delta[i];
+            for (uint8_t k=i+1; k<N; k++) {
+                sum -= L[k][i] * delta[k];
+            }
+            delta[i] = sum / L[i][i];
+        }
+        return true;
+    }
+
+private:
+    float _JTJ[N][N];
+    float _JTFI[N];
+};
+
+#endif // LM_SOLVER_H
@@ -0,0 +1,125 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <AP_HAL.h>
+#include <string.h>
+#include "AP_Math.h"
+
+// 1e-7 degrees in radians
+#define LTP_LATLON_TO_RAD 1.7453292519943295e-9
+
+// meters per 1e-7 degrees at the equator, the same as
+// LOCATION_SCALING_FACTOR in location.cpp
+#define LTP_LATLON_TO_M 0.011131884502145034
+
+// 360 degrees in units of 1e-7 degrees
+#define LTP_LNG_TURN 3600000000.0
+
+LocalTangentPlane::LocalTangentPlane() :
+    _lat_to_m(LTP_LATLON_TO_M),
+    _lng_to_m(LTP_LATLON_TO_M),
+    _m_to_lat(1.0 / LTP_LATLON_TO_M),
+    _m_to_lng(1.0 / LTP_LATLON_TO_M),
+    _origin_set(false)
+{
+    memset(&_origin, 0, sizeof(_origin));
+}
+
+void LocalTangentPlane::set_origin(const struct Location &origin)
+{
+    if (!_origin_set || origin.lat != _origin.lat) {
+        // limited as in longitude_scale()
+        double scale = cos(origin.lat * LTP_LATLON_TO_RAD);
+        if (scale < 0.01) {
+            scale = 0.01;
+        }
+        _lng_to_m = LTP_LATLON_TO_M * scale;
+        _m_to_lng = 1.0 / _lng_to_m;
+    }
+    _origin = origin;
+    _origin_set = true;
+}
+
+double LocalTangentPlane::lat_offset(const struct Location &loc) const
+{
+    return (double)loc.lat - (double)_origin.lat;
+}
+
+// the longitude difference is wrapped so the shorter way round is used
+// near the 180 degree meridian
+double LocalTangentPlane::lng_offset(const struct Location &loc) const
+{
+    double dlng = (double)loc.lng - (double)_origin.lng;
+    if (dlng > LTP_LNG_TURN/2) {
+        dlng -= LTP_LNG_TURN;
+    } else if (dlng < -LTP_LNG_TURN/2) {
+        dlng += LTP_LNG_TURN;
+    }
+    return dlng;
+}
+
+Vector2f LocalTangentPlane::location_to_ne(const struct Location &loc) const
+{
+    return Vector2f(lat_offset(loc) * _lat_to_m,
+                    lng_offset(loc) * _lng_to_m);
+}
+
+Vector3f LocalTangentPlane::location_to_ned(const struct Location &loc) const
+{
+    return Vector3f(lat_offset(loc) * _lat_to_m,
+                    lng_offset(loc) * _lng_to_m,
+                    (_origin.alt - loc.alt) * 0.01f);
+}
+
+// the difference is taken before rounding so it keeps full precision
+// for nearby points far from the origin
+Vector2f LocalTangentPlane::location_diff(const struct Location &loc1, const struct Location &loc2) const
+{
+    double dlng = lng_offset(loc2) - lng_offset(loc1);
+    if (dlng > LTP_LNG_TURN/2) {
+        dlng -= LTP_LNG_TURN;
+    } else if (dlng < -LTP_LNG_TURN/2) {
+        dlng += LTP_LNG_TURN;
+    }
+    return Vector2f(((double)loc2.lat - (double)loc1.lat) * _lat_to_m,
+                    dlng * _lng_to_m);
+}
+
+float LocalTangentPlane::get_distance(const struct Location &loc1, const struct Location &loc2) const
+{
+    return location_diff(loc1, loc2).length();
+}
+
+void LocalTangentPlane::ne_to_location(const Vector2f &ne, struct Location &loc) const
+{
+    double lat = _origin.lat + ne.x * _m_to_lat;
+    double lng = _origin.lng + ne.y * _m_to_lng;
+    if (lng > LTP_LNG_TURN/2) {
+        lng -= LTP_LNG_TURN;
+    } else if (lng < -LTP_LNG_TURN/2) {
+        lng += LTP_LNG_TURN;
+    }
+    loc.lat = (int32_t)floor(lat + 0.5);
+    loc.lng = (int32_t)floor(lng + 0.5);
+}
+
+void LocalTangentPlane::ned_to_location(const Vector3f &ned, struct Location &loc) const
+{
+    ne_to_location(Vector2f(ned.x, ned.y), loc);
+    loc.alt = _origin.alt - (int32_t)floorf(ned.z * 100 + 0.5f);
+    loc.flags.relative_alt = _origin.flags.relative_alt;
+    loc.flags.terrain_alt = _origin.flags.terrain_alt;
+}
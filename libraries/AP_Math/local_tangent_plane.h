@@ -0,0 +1,84 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  projection between struct Location and North/East/Down offsets in
+  meters on the plane tangent to the earth at an origin.
+
+  This uses the same spherical earth as location_diff() and
+  location_offset(), but the scale factors are calculated once for the
+  origin and the lat/lng differences are scaled in double precision, so
+  the results do not depend on the cached longitude_scale() and add
+  well under a millimeter of rounding error hundreds of kilometers from
+  the origin. Only the outputs are rounded to float.
+
+  That is numerical, not geometric, accuracy. As in location_diff()
+  the longitude scale is that of the origin's latitude, so east-west
+  distances away from it are in error by about tan(lat) times the
+  north offset over the earth radius: around 2% at 200km north or
+  south of an origin at 35 degrees latitude.
+
+  Altitudes are taken to be in the same frame as the origin altitude.
+ */
+
+#ifndef LOCAL_TANGENT_PLANE_H
+#define LOCAL_TANGENT_PLANE_H
+
+class LocalTangentPlane
+{
+public:
+    LocalTangentPlane();
+
+    // set the origin. The scale factors are only recalculated if the
+    // latitude has changed, so this is cheap to call every update
+    void set_origin(const struct Location &origin);
+
+    bool origin_set() const { return _origin_set; }
+    const struct Location &get_origin() const { return _origin; }
+
+    // North/East offset in meters of loc from the origin
+    Vector2f location_to_ne(const struct Location &loc) const;
+
+    // North/East/Down offset in meters of loc from the origin
+    Vector3f location_to_ned(const struct Location &loc) const;
+
+    // North/East offset in meters from loc1 to loc2
+    Vector2f location_diff(const struct Location &loc1, const struct Location &loc2) const;
+
+    // horizontal distance in meters between two locations
+    float get_distance(const struct Location &loc1, const struct Location &loc2) const;
+
+    // set the lat/lng of loc to a North/East offset in meters from the
+    // origin, leaving its altitude unchanged
+    void ne_to_location(const Vector2f &ne, struct Location &loc) const;
+
+    // set loc to a North/East/Down offset in meters from the origin
+    void ned_to_location(const Vector3f &ned, struct Location &loc) const;
+
+private:
+    // offsets from the origin in units of 1e-7 degrees
+    double lat_offset(const struct Location &loc) const;
+    double lng_offset(const struct Location &loc) const;
+
+    struct Location _origin;
+    double _lat_to_m;       // meters per 1e-7 degrees of latitude
+    double _lng_to_m;       // meters per 1e-7 degrees of longitude at the origin
+    double _m_to_lat;
+    double _m_to_lng;
+    bool _origin_set;
+};
+
+#endif // LOCAL_TANGENT_PLANE_H
@@ -0,0 +1,363 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  dense R x C matrix with its size fixed at compile time, stored by rows
+  in one array so there is no allocation and the inner loops of the
+  products walk memory in order.
+
+  Square matrices also have symmetric rank updates and Cholesky (L*L')
+  and LDL' factorisations with solvers, for covariance style estimator
+  code.
+ */
+
+#ifndef MATRIXN_H
+#define MATRIXN_H
+
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+#include "vectorN.h"
+#if defined(MATH_CHECK_INDEXES) && (MATH_CHECK_INDEXES == 1)
+#include <assert.h>
+#endif
+
+// square root in the precision of the matrix
+static inline float matrixN_sqrt(float v) { return sqrtf(v); }
+static inline double matrixN_sqrt(double v) { return sqrt(v); }
+
+template <typename T, uint8_t R, uint8_t C>
+class MatrixN
+{
+public:
+    // trivial ctor
+    MatrixN<T,R,C>() {
+        zero();
+    }
+
+    inline void zero() {
+        memset(_m, 0, sizeof(_m));
+    }
+
+    // set to the identity matrix (square matrices)
+    void identity() {
+        zero();
+        for (uint8_t i=0; i<(R < C ? R : C); i++) {
+            _m[i][i] = 1;
+        }
+    }
+
+    inline T & operator()(uint8_t i, uint8_t j) {
+#if defined(MATH_CHECK_INDEXES) && (MATH_CHECK_INDEXES == 1)
+        assert(i < R && j < C);
+#endif
+        return _m[i][j];
+    }
+
+    inline const T & operator()(uint8_t i, uint8_t j) const {
+#if defined(MATH_CHECK_INDEXES) && (MATH_CHECK_INDEXES == 1)
+        assert(i < R && j < C);
+#endif
+        return _m[i][j];
+    }
+
+    // access to a row as an array
+    inline T *row(uint8_t i) { return _m[i]; }
+    inline const T *row(uint8_t i) const { return _m[i]; }
+
+    // addition
+    MatrixN<T,R,C> operator +(const MatrixN<T,R,C> &m) const {
+        MatrixN<T,R,C> ret = *this;
+        ret += m;
+        return ret;
+    }
+
+    // subtraction
+    MatrixN<T,R,C> operator -(const MatrixN<T,R,C> &m) const {
+        MatrixN<T,R,C> ret = *this;
+        ret -= m;
+        return ret;
+    }
+
+    MatrixN<T,R,C> &operator +=(const MatrixN<T,R,C> &m) {
+        for (uint8_t i=0; i<R; i++) {
+            for (uint8_t j=0; j<C; j++) {
+                _m[i][j] += m._m[i][j];
+            }
+        }
+        return *this;
+    }
+
+    MatrixN<T,R,C> &operator -=(const MatrixN<T,R,C> &m) {
+        for (uint8_t i=0; i<R; i++) {
+            for (uint8_t j=0; j<C; j++) {
+                _m[i][j] -= m._m[i][j];
+            }
+        }
+        return *this;
+    }
+
+    // uniform scaling
+    MatrixN<T,R,C> operator *(const T num) const {
+        MatrixN<T,R,C> ret = *this;
+        ret *= num;
+        return ret;
+    }
+
+    MatrixN<T,R,C> &operator *=(const T num) {
+        for (uint8_t i=0; i<R; i++) {
+            for (uint8_t j=0; j<C; j++) {
+                _m[i][j] *= num;
+            }
+        }
+        return *this;
+    }
+
+    // matrix product. Each row of A scales rows of B into the result,
+    // so the inner loop runs along rows of B and of the result
+    template <uint8_t K>
+    MatrixN<T,R,K> operator *(const MatrixN<T,C,K> &b) const {
+        MatrixN<T,R,K> ret;
+        for (uint8_t i=0; i<R; i++) {
+            T *out = ret.row(i);
+            for (uint8_t k=0; k<C; k++) {
+                const T a = _m[i][k];
+                if (a == 0) {
+                    continue;
+                }
+                const T *in = b.row(k);
+                for (uint8_t j=0; j<K; j++) {
+                    out[j] += a * in[j];
+                }
+            }
+        }
+        return ret;
+    }
+
+    // A * B', each element being the dot product of two rows
+    template <uint8_t K>
+    MatrixN<T,R,K> mul_transposed(const MatrixN<T,K,C> &b) const {
+        MatrixN<T,R,K> ret;
+        for (uint8_t i=0; i<R; i++) {
+            for (uint8_t j=0; j<K; j++) {
+                ret(i,j) = dot(_m[i], b.row(j));
+            }
+        }
+        return ret;
+    }
+
+    // A' * B, summing the outer products of matching rows
+    template <uint8_t K>
+    MatrixN<T,C,K> transposed_mul(const MatrixN<T,R,K> &b) const {
+        MatrixN<T,C,K> ret;
+        for (uint8_t r=0; r<R; r++) {
+            const T *in = b.row(r);
+            for (uint8_t i=0; i<C; i++) {
+                const T a = _m[r][i];
+                if (a == 0) {
+                    continue;
+                }
+                T *out = ret.row(i);
+                for (uint8_t j=0; j<K; j++) {
+                    out[j] += a * in[j];
+                }
+            }
+        }
+        return ret;
+    }
+
+    // matrix times vector
+    VectorN<T,R> operator *(const VectorN<T,C> &v) const {
+        VectorN<T,R> ret;
+        for (uint8_t i=0; i<R; i++) {
+            T sum = 0;
+            for (uint8_t j=0; j<C; j++) {
+                sum += _m[i][j] * v[j];
+            }
+            ret[i] = sum;
+        }
+        return ret;
+    }
+
+    // transpose of matrix times vector
+    VectorN<T,C> mul_transpose(const VectorN<T,R> &v) const {
+        VectorN<T,C> ret;
+        for (uint8_t i=0; i<R; i++) {
+            const T a = v[i];
+            for (uint8_t j=0; j<C; j++) {
+                ret[j] += _m[i][j] * a;
+            }
+        }
+        return ret;
+    }
+
+    MatrixN<T,C,R> transposed() const {
+        MatrixN<T,C,R> ret;
+        for (uint8_t i=0; i<R; i++) {
+            for (uint8_t j=0; j<C; j++) {
+                ret(j,i) = _m[i][j];
+            }
+        }
+        return ret;
+    }
+
+    /*
+      the functions below are for square matrices
+     */
+
+    // A += alpha * v * v'. Only the lower triangle is updated, use
+    // force_symmetry() to copy it to the upper triangle
+    void rank1_update(const VectorN<T,R> &v, const T alpha) {
+        for (uint8_t i=0; i<R; i++) {
+            const T a = alpha * v[i];
+            for (uint8_t j=0; j<=i; j++) {
+                _m[i][j] += a * v[j];
+            }
+        }
+    }
+
+    // A += alpha * H' * H for a K x R matrix H, the update of an
+    // information matrix by K measurements. Only the lower triangle is
+    // updated
+    template <uint8_t K>
+    void rank_update(const MatrixN<T,K,R> &h, const T alpha) {
+        for (uint8_t k=0; k<K; k++) {
+            const T *hk = h.row(k);
+            for (uint8_t i=0; i<R; i++) {
+                const T a = alpha * hk[i];
+                if (a == 0) {
+                    continue;
+                }
+                for (uint8_t j=0; j<=i; j++) {
+                    _m[i][j] += a * hk[j];
+                }
+            }
+        }
+    }
+
+    // copy the lower triangle to the upper triangle
+    void force_symmetry() {
+        for (uint8_t i=1; i<R; i++) {
+            for (uint8_t j=0; j<i; j++) {
+                _m[j][i] = _m[i][j];
+            }
+        }
+    }
+
+    /*
+      Cholesky factorisation A = L*L' of a symmetric positive definite
+      matrix, using its lower triangle. Returns false if A is not
+      positive definite
+     */
+    bool cholesky(MatrixN<T,R,R> &L) const {
+        L.zero();
+        for (uint8_t i=0; i<R; i++) {
+            T *li = L.row(i);
+            for (uint8_t j=0; j<=i; j++) {
+                const T *lj = L.row(j);
+                T sum = _m[i][j] - dot(li, lj, j);
+                if (i == j) {
+                    if (!(sum > 0)) {
+                        return false;
+                    }
+                    li[i] = matrixN_sqrt(sum);
+                } else {
+                    li[j] = sum / lj[j];
+                }
+            }
+        }
+        return true;
+    }
+
+    // solve L*L'*x = b given the Cholesky factor L
+    static VectorN<T,R> cholesky_solve(const MatrixN<T,R,R> &L, const VectorN<T,R> &b) {
+        VectorN<T,R> x;
+        for (uint8_t i=0; i<R; i++) {
+            x[i] = (b[i] - dot(L.row(i), &x[0], i)) / L(i,i);
+        }
+        for (int8_t i=R-1; i>=0; i--) {
+            T sum = x[i];
+            for (uint8_t k=i+1; k<R; k++) {
+                sum -= L(k,i) * x[k];
+            }
+            x[i] = sum / L(i,i);
+        }
+        return x;
+    }
+
+    /*
+      LDL' factorisation of a symmetric matrix, using its lower
+      triangle. L has a unit diagonal. Unlike cholesky() it needs no
+      square roots and works for indefinite matrices, but returns false
+      if a pivot is zero
+     */
+    bool ldlt(MatrixN<T,R,R> &L, VectorN<T,R> &d) const {
+        L.identity();
+        for (uint8_t j=0; j<R; j++) {
+            const T *lj = L.row(j);
+            T dj = _m[j][j];
+            for (uint8_t k=0; k<j; k++) {
+                dj -= lj[k] * lj[k] * d[k];
+            }
+            if (dj == 0 || isnan(dj)) {
+                return false;
+            }
+            d[j] = dj;
+            for (uint8_t i=j+1; i<R; i++) {
+                T *li = L.row(i);
+                T sum = _m[i][j];
+                for (uint8_t k=0; k<j; k++) {
+                    sum -= li[k] * lj[k] * d[k];
+                }
+                li[j] = sum / dj;
+            }
+        }
+        return true;
+    }
+
+    // solve L*D*L'*x = b given the LDL' factors
+    static VectorN<T,R> ldlt_solve(const MatrixN<T,R,R> &L, const VectorN<T,R> &d, const VectorN<T,R> &b) {
+        VectorN<T,R> x;
+        for (uint8_t i=0; i<R; i++) {
+            x[i] = b[i] - dot(L.row(i), &x[0], i);
+        }
+        for (uint8_t i=0; i<R; i++) {
+            x[i] /= d[i];
+        }
+        for (int8_t i=R-1; i>=0; i--) {
+            T sum = x[i];
+            for (uint8_t k=i+1; k<R; k++) {
+                sum -= L(k,i) * x[k];
+            }
+            x[i] = sum;
+        }
+        return x;
+    }
+
+private:
+    // dot product of the first n elements of two arrays
+    static inline T dot(const T *a, const T *b, uint8_t n = C) {
+        T sum = 0;
+        for (uint8_t k=0; k<n; k++) {
+            sum += a[k] * b[k];
+        }
+        return sum;
+    }
+
+    T _m[R][C];
+};
+
+#endif // MATRIXN_H
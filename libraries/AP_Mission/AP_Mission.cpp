@@ -46,6 +46,11 @@ void AP_Mission::init()
         hal.scheduler->panic(PSTR("AP_Mission Content must be 12 bytes"));
     }
 
+#if AP_MISSION_CMD_CACHE
+    // load the mission into RAM
+    cache_init();
+#endif
+
     _last_change_time_ms = hal.scheduler->millis();
 }
 
@@ -255,6 +260,13 @@ bool AP_Mission::get_next_nav_cmd(uint16_t start_index, Mission_Command& cmd)
 
     // search until the end of the mission command list
     while(cmd_index < (unsigned)_cmd_total) {
+#if AP_MISSION_CMD_CACHE
+        // skip over any "do" commands, they can't change the result
+        cmd_index = cache_next_nav_or_jump(cmd_index);
+        if (cmd_index >= (unsigned)_cmd_total) {
+            return false;
+        }
+#endif
         // get next command
         if (!get_next_cmd(cmd_index, cmd, false)) {
             // no more commands so return failure
@@ -397,6 +409,11 @@ bool AP_Mission::read_cmd_from_storage(uint16_t index, Mission_Command& cmd) con
         cmd.id = MAV_CMD_NAV_WAYPOINT;
         cmd.p1 = 0;
         cmd.content.location = _ahrs.get_home();
+#if AP_MISSION_CMD_CACHE
+    }else if (index < _cache_size) {
+        // use the decoded copy in RAM
+        cmd = _cmd_cache[index];
+#endif
     }else{
         // Find out proper location in memory by using the start_byte position + the index
         // we can load a command, we don't process it yet
@@ -432,6 +449,15 @@ bool AP_Mission::write_cmd_to_storage(uint16_t index, Mission_Command& cmd)
     _storage.write_uint16(pos_in_storage+1, cmd.p1);
     _storage.write_block(pos_in_storage+3, cmd.content.bytes, 12);
 
+#if AP_MISSION_CMD_CACHE
+    // keep the RAM copy in sync
+    if (index < _cache_size) {
+        _cmd_cache[index] = cmd;
+        _cmd_cache[index].index = index;
+        _nav_index_valid = false;
+    }
+#endif
+
     // remember when the mission last changed
     _last_change_time_ms = hal.scheduler->millis();
 
@@ -439,6 +465,30 @@ bool AP_Mission::write_cmd_to_storage(uint16_t index, Mission_Command& cmd)
     return true;
 }
 
+/// write_mission_to_storage - replaces the whole mission with count commands from cmds
+///     the total number of commands is only saved once, after all commands have been written
+///     true is returned if successful
+bool AP_Mission::write_mission_to_storage(Mission_Command *cmds, uint16_t count)
+{
+    // check the mission will fit
+    if (count > num_commands_max()) {
+        return false;
+    }
+
+    for (uint16_t i=0; i<count; i++) {
+        if (!write_cmd_to_storage(i, cmds[i])) {
+            return false;
+        }
+        cmds[i].index = i;
+    }
+
+    if ((unsigned)_cmd_total != count) {
+        _cmd_total.set_and_save(count);
+    }
+
+    return true;
+}
+
 /// write_home_to_storage - writes the special purpose cmd 0 (home) to storage
 ///     home is taken directly from ahrs
 void AP_Mission::write_home_to_storage()
@@ -1320,6 +1370,70 @@ void AP_Mission::check_eeprom_version()
     }
 }
 
+#if AP_MISSION_CMD_CACHE
+/// cache_init - allocates the command cache and loads every command slot from storage
+///     the whole of storage is loaded rather than just _cmd_total commands so the cache stays valid
+///     if the mission is extended.  On allocation failure commands are read from storage as before
+void AP_Mission::cache_init()
+{
+    if (_cmd_cache != NULL) {
+        return;
+    }
+
+    uint16_t size = num_commands_max();
+    _cmd_cache = (struct Mission_Command *)calloc(size, sizeof(_cmd_cache[0]));
+    _nav_index = (uint16_t *)calloc(size, sizeof(_nav_index[0]));
+    if (_cmd_cache == NULL || _nav_index == NULL) {
+        free(_cmd_cache);
+        free(_nav_index);
+        _cmd_cache = NULL;
+        _nav_index = NULL;
+        return;
+    }
+
+    // decode every slot, using the same layout as read_cmd_from_storage()
+    for (uint16_t i=AP_MISSION_FIRST_REAL_COMMAND; i<size; i++) {
+        uint16_t pos_in_storage = 4 + (i * AP_MISSION_EEPROM_COMMAND_SIZE);
+        Mission_Command &cmd = _cmd_cache[i];
+        cmd.index = i;
+        cmd.id = _storage.read_byte(pos_in_storage);
+        cmd.p1 = _storage.read_uint16(pos_in_storage+1);
+        _storage.read_block(cmd.content.bytes, pos_in_storage+3, 12);
+    }
+    _cache_size = size;
+    _nav_index_valid = false;
+}
+
+/// cache_build_nav_index - rebuilds _nav_index after the mission has changed
+///     works backwards so each slot points at the nearest navigation or do-jump command at or after it
+void AP_Mission::cache_build_nav_index()
+{
+    uint16_t next = AP_MISSION_CMD_INDEX_NONE;
+    for (int16_t i=_cache_size-1; i>=0; i--) {
+        // command #0 is home, which is always a navigation command
+        if (i == 0 || is_nav_cmd(_cmd_cache[i]) || _cmd_cache[i].id == MAV_CMD_DO_JUMP) {
+            next = i;
+        }
+        _nav_index[i] = next;
+    }
+    _nav_index_valid = true;
+}
+
+/// cache_next_nav_or_jump - returns the index of the first navigation or do-jump command at or after index
+///     returns AP_MISSION_CMD_INDEX_NONE if there is none
+uint16_t AP_Mission::cache_next_nav_or_jump(uint16_t index)
+{
+    if (index >= _cache_size) {
+        // no cache, let the caller walk through storage
+        return _cache_size == 0 ? index : AP_MISSION_CMD_INDEX_NONE;
+    }
+    if (!_nav_index_valid) {
+        cache_build_nav_index();
+    }
+    return _nav_index[index];
+}
+#endif // AP_MISSION_CMD_CACHE
+
 /*
   return total number of commands that can fit in storage space
  */
@@ -33,6 +33,12 @@
  # define AP_MISSION_MAX_NUM_DO_JUMP_COMMANDS 15    // allow up to 15 do-jump commands all high speed CPUs
 #endif
 
+#if HAL_CPU_CLASS < HAL_CPU_CLASS_75
+ # define AP_MISSION_CMD_CACHE              0       // commands are always read from storage on the APM2
+#else
+ # define AP_MISSION_CMD_CACHE              1       // keep a decoded copy of the mission in RAM on high speed CPUs
+#endif
+
 #define AP_MISSION_JUMP_REPEAT_FOREVER      -1      // when do-jump command's repeat count is -1 this means endless repeat
 
 #define AP_MISSION_CMD_ID_NONE              0       // mavlink cmd id of zero means invalid or missing command
@@ -245,6 +251,13 @@ public:
         _flags.state = MISSION_STOPPED;
         _flags.nav_cmd_loaded = false;
         _flags.do_cmd_loaded = false;
+
+#if AP_MISSION_CMD_CACHE
+        _cmd_cache = NULL;
+        _nav_index = NULL;
+        _cache_size = 0;
+        _nav_index_valid = false;
+#endif
     }
 
     ///
@@ -347,6 +360,11 @@ public:
     ///     true is returned if successful
     bool write_cmd_to_storage(uint16_t index, Mission_Command& cmd);
 
+    /// write_mission_to_storage - replaces the whole mission with count commands from cmds
+    ///     the total number of commands is only saved once, after all commands have been written
+    ///     true is returned if successful
+    bool write_mission_to_storage(Mission_Command *cmds, uint16_t count);
+
     /// write_home_to_storage - writes the special purpose cmd 0 (home) to storage
     ///     home is taken directly from ahrs
     void write_home_to_storage();
@@ -427,6 +445,21 @@ private:
     /// command list will be cleared if they do not match
     void check_eeprom_version();
 
+#if AP_MISSION_CMD_CACHE
+    ///
+    /// command cache methods
+    ///
+    /// cache_init - allocates the command cache and loads every command slot from storage
+    void cache_init();
+
+    /// cache_build_nav_index - rebuilds _nav_index after the mission has changed
+    void cache_build_nav_index();
+
+    /// cache_next_nav_or_jump - returns the index of the first navigation or do-jump command at or after index
+    ///     returns AP_MISSION_CMD_INDEX_NONE if there is none
+    uint16_t cache_next_nav_or_jump(uint16_t index);
+#endif
+
     // references to external libraries
     const AP_AHRS&   _ahrs;      // used only for home position
 
@@ -452,6 +485,15 @@ private:
 
     // last time that mission changed
     uint32_t _last_change_time_ms;
+
+#if AP_MISSION_CMD_CACHE
+    // decoded copy of every command slot in storage, kept in sync by write_cmd_to_storage
+    struct Mission_Command  *_cmd_cache;
+    // for each slot, index of the next navigation or do-jump command at or after it
+    uint16_t                *_nav_index;
+    uint16_t                _cache_size;        // number of slots in _cmd_cache and _nav_index
+    bool                    _nav_index_valid;   // false when a command has been written since _nav_index was built
+#endif
 };
 
 #endif
@@ -444,8 +444,8 @@ NavEKF::NavEKF(const AP_AHRS *ahrs, AP_Baro &baro, const RangeFinder &rng) :
     gpsNEVelVarAccScale(0.05f),     // Scale factor applied to horizontal velocity measurement variance due to manoeuvre acceleration - used when GPS doesn't report speed error
     gpsDVelVarAccScale(0.07f),      // Scale factor applied to vertical velocity measurement variance due to manoeuvre acceleration - used when GPS doesn't report speed error
     gpsPosVarAccScale(0.1f),       // Scale factor applied to horizontal position measurement variance due to manoeuvre acceleration
-    msecHgtDelay(60),               // Height measurement delay (msec)
-    msecMagDelay(40),               // Magnetometer measurement delay (msec)
+    msecHgtSampleDelay(5),          // Height measurement delay after the baro sample time (msec)
+    msecMagSampleDelay(10),         // Magnetometer measurement delay after the compass sample time (msec)
     msecTasDelay(240),              // Airspeed measurement delay (msec)
     gpsRetryTimeUseTAS(10000),      // GPS retry time with airspeed measurements (msec)
     gpsRetryTimeNoTAS(7000),        // GPS retry time without airspeed measurements (msec)
@@ -3725,7 +3725,7 @@ bool NavEKF::getPosNED(Vector3f &pos) const
             if ((_ahrs->get_gps().status() >= AP_GPS::GPS_OK_FIX_2D)) {
                 // If the origin has been set and we have GPS, then return the GPS position relative to the origin
                 const struct Location &gpsloc = _ahrs->get_gps().location();
-                Vector2f tempPosNE = location_diff(EKF_origin, gpsloc);
+                Vector2f tempPosNE = originLTP.location_to_ne(gpsloc);
                 pos.x = tempPosNE.x;
                 pos.y = tempPosNE.y;
                 return false;
@@ -3868,9 +3868,7 @@ bool NavEKF::getLLH(struct Location &loc) const
         nav_filter_status status;
         getFilterStatus(status);
         if (status.flags.horiz_pos_abs || status.flags.horiz_pos_rel) {
-            loc.lat = EKF_origin.lat;
-            loc.lng = EKF_origin.lng;
-            location_offset(loc, state.position.x, state.position.y);
+            originLTP.ne_to_location(Vector2f(state.position.x, state.position.y), loc);
             return true;
         } else {
             // we could be in constant position mode  becasue the vehicle has taken off without GPS, or has lost GPS
@@ -4170,12 +4168,13 @@ void NavEKF::readIMUData()
     // the imu sample time is used as a common time reference throughout the filter
     imuSampleTime_ms = hal.scheduler->millis();
 
-    if (ins.get_accel_health(0) && ins.get_accel_health(1)) {
+    if (ins.use_accel(0) && ins.use_accel(1) && ins.get_accel_consistent()) {
         // dual accel mode
         readDeltaVelocity(0, dVelIMU1, dtDelVel1);
         readDeltaVelocity(1, dVelIMU2, dtDelVel2);
     } else {
-        // single accel mode - one of the first two accelerometers are unhealthy
+        // single accel mode - one of the first two accelerometers are unhealthy,
+        // or they disagree and there is no third to show which is right
         // read primary accelerometer into dVelIMU1 and copy to dVelIMU2
         readDeltaVelocity(ins.get_primary_accel(), dVelIMU1, dtDelVel1);
 
@@ -4183,7 +4182,7 @@ void NavEKF::readIMUData()
         dVelIMU2 = dVelIMU1;
     }
 
-    if (ins.get_gyro_health(0) && ins.get_gyro_health(1)) {
+    if (ins.use_gyro(0) && ins.use_gyro(1) && ins.get_gyro_consistent()) {
         // dual gyro mode - average first two gyros
         Vector3f dAng;
         dAngIMU.zero();
@@ -4193,7 +4192,7 @@ void NavEKF::readIMUData()
         dAngIMU += dAng;
         dAngIMU *= 0.5f;
     } else {
-        // single gyro mode - one of the first two gyros are unhealthy or don't exist
+        // single gyro mode - one of the first two gyros are unhealthy, disagree or don't exist
         // just read primary gyro
         readDeltaAngle(ins.get_primary_gyro(), dAngIMU);
     }
@@ -4267,6 +4266,7 @@ void NavEKF::readGpsData()
             alignMagStateDeclination();
             // Set the height of the NED origin to ‘height of baro height datum relative to GPS height datum'
             EKF_origin.alt = gpsloc.alt - hgtMea;
+            originLTP.set_origin(EKF_origin);
         }
 
         // Commence GPS aiding when able to
@@ -4280,7 +4280,7 @@ void NavEKF::readGpsData()
 
         // Convert to local coordinates if we have an origin.
         if (validOrigin) {
-            gpsPosNE = location_diff(EKF_origin, gpsloc);
+            gpsPosNE = originLTP.location_to_ne(gpsloc);
         }
 
         // calculate a position offset which is applied to NE position and velocity wherever it is used throughout code to allow GPS position jumps to be accommodated gradually
@@ -4300,6 +4300,10 @@ void NavEKF::readHgtData()
 {
     // check to see if baro measurement has changed so we know if a new measurement has arrived
     if (_baro.get_last_update() != lastHgtMeasTime) {
+        // the baro records when its samples were taken, so only the
+        // sensor's internal delay needs to be allowed for
+        uint32_t hgtSampleTime_ms = _baro.get_sample_time_ms() - msecHgtSampleDelay;
+
         // Don't use Baro height if operating in optical flow mode as we use range finder instead
         if (_fusionModeGPS == 3 && _altSource == 1) {
             if ((imuSampleTime_ms - rngValidMeaTime_ms) < 2000) {
@@ -4314,7 +4318,7 @@ void NavEKF::readHgtData()
                 // use baro measurement and correct for baro offset - failsafe use only as baro will drift
                 hgtMea = max(_baro.get_altitude() - baroHgtOffset, rngOnGnd);
                 // get states that were stored at the time closest to the measurement time, taking measurement delay into account
-                RecallStates(statesAtHgtTime, (imuSampleTime_ms - msecHgtDelay));
+                RecallStates(statesAtHgtTime, hgtSampleTime_ms);
             } else {
                 // If we are on ground and have no range finder reading, assume the nominal on-ground height
                 hgtMea = rngOnGnd;
@@ -4328,7 +4332,7 @@ void NavEKF::readHgtData()
             // use baro measurement and correct for baro offset
             hgtMea = _baro.get_altitude();
             // get states that were stored at the time closest to the measurement time, taking measurement delay into account
-            RecallStates(statesAtHgtTime, (imuSampleTime_ms - msecHgtDelay));
+            RecallStates(statesAtHgtTime, hgtSampleTime_ms);
         }
 
         // filtered baro data used to provide a reference for takeoff
@@ -4363,8 +4367,8 @@ void NavEKF::readMagData()
         // read compass data and scale to improve numerical conditioning
         magData = _ahrs->get_compass()->get_field() * 0.001f;
 
-        // get states stored at time closest to measurement time after allowance for measurement delay
-        RecallStates(statesAtMagMeasTime, (imuSampleTime_ms - msecMagDelay));
+        // get states stored at the time the compass samples were taken, allowing for the sensor's internal delay
+        RecallStates(statesAtMagMeasTime, (_ahrs->get_compass()->last_sample_time_ms() - msecMagSampleDelay));
 
         // let other processes know that new compass data has arrived
         newDataMag = true;
@@ -5164,6 +5168,7 @@ void NavEKF::performArmingChecks()
 void NavEKF::setOrigin()
 {
     EKF_origin = _ahrs->get_gps().location();
+    originLTP.set_origin(EKF_origin);
     validOrigin = true;
 }
 
@@ -5183,6 +5188,7 @@ bool NavEKF::setOriginLLH(struct Location &loc)
         return false;
     }
     EKF_origin = loc;
+    originLTP.set_origin(EKF_origin);
     validOrigin = true;
     return true;
 }
@@ -529,8 +529,8 @@ private:
     const float gpsNEVelVarAccScale;    // Scale factor applied to NE velocity measurement variance due to manoeuvre acceleration
     const float gpsDVelVarAccScale;     // Scale factor applied to vertical velocity measurement variance due to manoeuvre acceleration
     const float gpsPosVarAccScale;      // Scale factor applied to horizontal position measurement variance due to manoeuvre acceleration
-    const float msecHgtDelay;           // Height measurement delay (msec)
-    const uint16_t msecMagDelay;        // Magnetometer measurement delay (msec)
+    const uint16_t msecHgtSampleDelay;  // Height measurement delay after the baro sample time (msec)
+    const uint16_t msecMagSampleDelay;  // Magnetometer measurement delay after the compass sample time (msec)
     const uint16_t msecTasDelay;        // Airspeed measurement delay (msec)
     const uint16_t gpsRetryTimeUseTAS;  // GPS retry time with airspeed measurements (msec)
     const uint16_t gpsRetryTimeNoTAS;   // GPS retry time without airspeed measurements (msec)
@@ -693,6 +693,7 @@ private:
     bool prevVehicleArmed;          // vehicleArmed from previous frame
     struct Location EKF_origin;     // LLH origin of the NED axis system - do not change unless filter is reset
     bool validOrigin;               // true when the EKF origin is valid
+    LocalTangentPlane originLTP;    // projection between LLH and the NED axis system about EKF_origin
     uint32_t lastGpsVelFail_ms;     // time of last GPS vertical velocity consistency check fail
     Vector3f lastMagOffsets;        // magnetometer offsets returned by compass object from previous update
     bool gpsAidingBad;              // true when GPS position measurements have been consistently rejected by the filter
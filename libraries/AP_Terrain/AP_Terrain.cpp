@@ -72,6 +72,13 @@ AP_Terrain::AP_Terrain(AP_AHRS &_ahrs, const AP_Mission &_mission, const AP_Rall
     AP_Param::setup_object_defaults(this, var_info);
     memset(&home_loc, 0, sizeof(home_loc));
     memset(&disk_block, 0, sizeof(disk_block));
+#if TERRAIN_USE_MMAP
+    file_map = NULL;
+    file_map_size = 0;
+    file_size = 0;
+    file_map_dirty = false;
+    last_sync_ms = 0;
+#endif
 }
 
 /*
@@ -103,39 +110,10 @@ bool AP_Terrain::height_amsl(const Location &loc, float &height)
     // find the grid
     const struct grid_block &grid = find_grid_cache(info).grid;
 
-    /*
-      note that we rely on the one square overlap to ensure these
-      calculations don't go past the end of the arrays
-     */
-    ASSERT_RANGE(info.idx_x, 0, TERRAIN_GRID_BLOCK_SIZE_X-2);
-    ASSERT_RANGE(info.idx_y, 0, TERRAIN_GRID_BLOCK_SIZE_Y-2);
-
-
-    // check we have all 4 required heights
-    if (!check_bitmap(grid, info.idx_x,   info.idx_y) ||
-        !check_bitmap(grid, info.idx_x,   info.idx_y+1) ||
-        !check_bitmap(grid, info.idx_x+1, info.idx_y) ||
-        !check_bitmap(grid, info.idx_x+1, info.idx_y+1)) {
+    if (!interpolate_height(grid, info, height)) {
         return false;
     }
 
-    // hXY are the heights of the 4 surrounding grid points
-    int16_t h00, h01, h10, h11;
-
-    h00 = grid.height[info.idx_x+0][info.idx_y+0];
-    h01 = grid.height[info.idx_x+0][info.idx_y+1];
-    h10 = grid.height[info.idx_x+1][info.idx_y+0];
-    h11 = grid.height[info.idx_x+1][info.idx_y+1];
-
-    // do a simple dual linear interpolation. We could do something
-    // fancier, but it probably isn't worth it as long as the
-    // grid_spacing is kept small enough
-    float avg1 = (1.0f-info.frac_x) * h00  + info.frac_x * h10;
-    float avg2 = (1.0f-info.frac_x) * h01  + info.frac_x * h11;
-    float avg  = (1.0f-info.frac_y) * avg1 + info.frac_y * avg2;
-
-    height = avg;
-
     if (loc.lat == ahrs.get_home().lat &&
         loc.lng == ahrs.get_home().lng) {
         // remember home altitude as a special case
@@ -147,6 +125,47 @@ bool AP_Terrain::height_amsl(const Location &loc, float &height)
 }
 
 
+/*
+  return terrain heights in meters above sea level for an array of
+  locations. Consecutive points in the same grid block share one
+  cache lookup and skip the grid corner calculation
+ */
+uint16_t AP_Terrain::height_amsl_multi(const Location *loc, uint16_t count,
+                                       float *height, bool *available)
+{
+    if (!enable) {
+        memset(available, 0, count*sizeof(available[0]));
+        return 0;
+    }
+
+    uint16_t num_available = 0;
+    struct grid_info info, last_info;
+    const struct grid_block *grid = NULL;
+
+    for (uint16_t i=0; i<count; i++) {
+        calculate_grid_index(loc[i], info);
+
+        if (grid == NULL ||
+            info.lat_degrees != last_info.lat_degrees ||
+            info.lon_degrees != last_info.lon_degrees ||
+            info.grid_idx_x != last_info.grid_idx_x ||
+            info.grid_idx_y != last_info.grid_idx_y) {
+            // moved into a new grid block
+            calculate_grid_corner(info);
+            grid = &find_grid_cache(info).grid;
+            last_info = info;
+        }
+
+        available[i] = interpolate_height(*grid, info, height[i]);
+        if (available[i]) {
+            num_available++;
+        }
+    }
+
+    return num_available;
+}
+
+
 /* 
    find difference between home terrain height and the terrain height
    at a given location, in meters. A positive result means the terrain
@@ -61,6 +61,22 @@
 // format of grid on disk
 #define TERRAIN_GRID_FORMAT_VERSION 1
 
+/*
+  on boards with a full virtual memory system we memory map the
+  degree files, which allows cache misses to be satisfied directly
+  from the page cache without going via the IO timer
+ */
+#ifndef TERRAIN_USE_MMAP
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+#define TERRAIN_USE_MMAP 1
+#else
+#define TERRAIN_USE_MMAP 0
+#endif
+#endif
+
+// how often dirty pages of a mapped degree file are flushed to disk
+#define TERRAIN_MMAP_SYNC_MS 2000
+
 #if TERRAIN_DEBUG
 #define ASSERT_RANGE(v,minv,maxv) assert((v)<=(maxv)&&(v)>=(minv))
 #else
@@ -109,6 +125,20 @@ public:
     // return false if not available
     bool height_amsl(const Location &loc, float &height);
 
+    /*
+      return terrain heights in meters above sea level for an array of
+      locations, such as a mission leg sampled at grid spacing.
+
+      available[i] is set to true if height[i] is valid. Points that
+      fall in the same grid block as the previous point reuse its
+      block, so this is much cheaper than calling height_amsl() for
+      each point. Missing blocks are queued for loading in one pass.
+
+      returns the number of points with a valid height
+     */
+    uint16_t height_amsl_multi(const Location *loc, uint16_t count,
+                               float *height, bool *available);
+
     /* 
        find difference between home terrain height and the terrain
        height at the current location in meters. A positive result
@@ -262,6 +292,11 @@ private:
 
     // given a location, fill a grid_info structure
     void calculate_grid_info(const Location &loc, struct grid_info &info) const;
+    void calculate_grid_index(const Location &loc, struct grid_info &info) const;
+    void calculate_grid_corner(struct grid_info &info) const;
+
+    // interpolate the height at a grid_info position within a grid
+    bool interpolate_height(const struct grid_block &grid, const struct grid_info &info, float &height);
 
     /*
       find a grid structure given a grid_info
@@ -306,9 +341,24 @@ private:
     void check_disk_write(void);
     void io_timer(void);
     void open_file(void);
+    uint32_t block_file_offset(int8_t lat_degrees, int16_t lon_degrees,
+                               uint16_t grid_idx_x, uint16_t grid_idx_y) const;
     void seek_offset(void);
     void write_block(void);
     void read_block(void);
+    bool check_block(struct grid_block &block, int32_t lat, int32_t lon);
+
+#if TERRAIN_USE_MMAP
+    /*
+      memory mapped degree file functions
+     */
+    void mmap_open(const struct grid_block &block);
+    void mmap_close(void);
+    bool mmap_lookup(struct grid_block &block, bool resident_only);
+    bool mmap_resident(uint32_t offset) const;
+    bool mmap_write_block(void);
+    void mmap_sync(bool force);
+#endif
 
     /*
       check for missing mission terrain data
@@ -366,6 +416,22 @@ private:
     int8_t file_lat_degrees;
     int16_t file_lon_degrees;
 
+#if TERRAIN_USE_MMAP
+    // mapping of the open degree file, NULL if not mapped
+    uint8_t *file_map;
+
+    // length of the mapping, covering every block in the degree
+    uint32_t file_map_size;
+
+    // current length of the file on disk. Blocks past the end of
+    // the file are treated as empty
+    uint32_t file_size;
+
+    // have blocks been written to the mapping since the last sync?
+    bool file_map_dirty;
+    uint32_t last_sync_ms;
+#endif
+
     // do we have an IO failure
     volatile bool io_failure;
 
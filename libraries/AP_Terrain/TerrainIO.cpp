@@ -33,6 +33,9 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <errno.h>
+#if TERRAIN_USE_MMAP
+#include <sys/mman.h>
+#endif
 
 extern const AP_HAL::HAL& hal;
 
@@ -166,6 +169,9 @@ void AP_Terrain::open_file(void)
         directory_created = true;
     }
 
+#if TERRAIN_USE_MMAP
+    mmap_close();
+#endif
     if (fd != -1) {
         ::close(fd);
     }
@@ -181,28 +187,41 @@ void AP_Terrain::open_file(void)
 
     file_lat_degrees = block.lat_degrees;
     file_lon_degrees = block.lon_degrees;
+
+#if TERRAIN_USE_MMAP
+    mmap_open(block);
+#endif
 }
 
 /*
-  seek to the right offset for disk_block
+  calculate the file offset of a grid block within its degree file
  */
-void AP_Terrain::seek_offset(void)
+uint32_t AP_Terrain::block_file_offset(int8_t lat_degrees, int16_t lon_degrees,
+                                       uint16_t grid_idx_x, uint16_t grid_idx_y) const
 {
-    struct grid_block &block = disk_block.block;
     // work out how many longitude blocks there are at this latitude
     Location loc1, loc2;
-    loc1.lat = block.lat_degrees*10*1000*1000L;
-    loc1.lng = block.lon_degrees*10*1000*1000L;
-    loc2.lat = block.lat_degrees*10*1000*1000L;
-    loc2.lng = (block.lon_degrees+1)*10*1000*1000L;
+    loc1.lat = lat_degrees*10*1000*1000L;
+    loc1.lng = lon_degrees*10*1000*1000L;
+    loc2.lat = lat_degrees*10*1000*1000L;
+    loc2.lng = (lon_degrees+1)*10*1000*1000L;
 
     // shift another two blocks east to ensure room is available
     location_offset(loc2, 0, 2*grid_spacing*TERRAIN_GRID_BLOCK_SIZE_Y);
     Vector2f offset = location_diff(loc1, loc2);
     uint16_t east_blocks = offset.y / (grid_spacing*TERRAIN_GRID_BLOCK_SIZE_Y);
 
-    uint32_t file_offset = (east_blocks * block.grid_idx_x + 
-                            block.grid_idx_y) * sizeof(union grid_io_block);
+    return (east_blocks * grid_idx_x + grid_idx_y) * sizeof(union grid_io_block);
+}
+
+/*
+  seek to the right offset for disk_block
+ */
+void AP_Terrain::seek_offset(void)
+{
+    struct grid_block &block = disk_block.block;
+    uint32_t file_offset = block_file_offset(block.lat_degrees, block.lon_degrees,
+                                             block.grid_idx_x, block.grid_idx_y);
     if (::lseek(fd, file_offset, SEEK_SET) != (off_t)file_offset) {
 #if TERRAIN_DEBUG
         hal.console->printf("Seek %lu failed - %s\n",
@@ -219,13 +238,20 @@ void AP_Terrain::seek_offset(void)
  */
 void AP_Terrain::write_block(void)
 {
+    disk_block.block.crc = get_block_crc(disk_block.block);
+
+#if TERRAIN_USE_MMAP
+    if (mmap_write_block()) {
+        disk_io_state = DiskIoDoneWrite;
+        return;
+    }
+#endif
+
     seek_offset();
     if (io_failure) {
         return;
     }
 
-    disk_block.block.crc = get_block_crc(disk_block.block);
-
     ssize_t ret = ::write(fd, &disk_block, sizeof(disk_block));
     if (ret  != sizeof(disk_block)) {
 #if TERRAIN_DEBUG
@@ -236,6 +262,13 @@ void AP_Terrain::write_block(void)
         io_failure = true;
     } else {
         ::fsync(fd);
+#if TERRAIN_USE_MMAP
+        // keep the mapped length in step with the file
+        off_t end = ::lseek(fd, 0, SEEK_CUR);
+        if (end > (off_t)file_size) {
+            file_size = end;
+        }
+#endif
 #if TERRAIN_DEBUG
         printf("wrote block at %ld %ld ret=%d mask=%07llx\n",
                (long)disk_block.block.lat,
@@ -247,11 +280,31 @@ void AP_Terrain::write_block(void)
     disk_io_state = DiskIoDoneWrite;
 }
 
+/*
+  check a block read from disk is the one we asked for and is intact
+ */
+bool AP_Terrain::check_block(struct grid_block &block, int32_t lat, int32_t lon)
+{
+    return (block.lat == lat &&
+            block.lon == lon &&
+            block.bitmap != 0 &&
+            block.spacing == grid_spacing &&
+            block.version == TERRAIN_GRID_FORMAT_VERSION &&
+            block.crc == get_block_crc(block));
+}
+
 /*
   read in disk_block
  */
 void AP_Terrain::read_block(void)
 {
+#if TERRAIN_USE_MMAP
+    if (mmap_lookup(disk_block.block, false)) {
+        disk_io_state = DiskIoDoneRead;
+        return;
+    }
+#endif
+
     seek_offset();
     if (io_failure) {
         return;
@@ -261,12 +314,7 @@ void AP_Terrain::read_block(void)
 
     ssize_t ret = ::read(fd, &disk_block, sizeof(disk_block));
     if (ret != sizeof(disk_block) || 
-        disk_block.block.lat != lat || 
-        disk_block.block.lon != lon ||
-        disk_block.block.bitmap == 0 ||
-        disk_block.block.spacing != grid_spacing ||
-        disk_block.block.version != TERRAIN_GRID_FORMAT_VERSION ||
-        disk_block.block.crc != get_block_crc(disk_block.block)) {
+        !check_block(disk_block.block, lat, lon)) {
 #if TERRAIN_DEBUG
         printf("read empty block at %ld %ld ret=%d\n",
                (long)lat,
@@ -291,6 +339,197 @@ void AP_Terrain::read_block(void)
     disk_io_state = DiskIoDoneRead;
 }
 
+#if TERRAIN_USE_MMAP
+/*
+  map the whole of the newly opened degree file. The mapping is sized
+  to cover every block the file can hold, so it never needs to be
+  remapped as the file grows. If the map fails we fall back to plain
+  read/write IO
+ */
+void AP_Terrain::mmap_open(const struct grid_block &block)
+{
+    // find the northmost row of blocks in the degree
+    Location ne;
+    ne.lat = (block.lat_degrees+1)*10*1000*1000L - 1;
+    ne.lng = (block.lon_degrees+1)*10*1000*1000L - 1;
+    struct grid_info info;
+    calculate_grid_info(ne, info);
+
+    // every row is a full row of blocks in the file, so the mapping
+    // ends where the row after the last one would start
+    file_map_size = block_file_offset(block.lat_degrees, block.lon_degrees,
+                                      info.grid_idx_x+1, 0);
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        return;
+    }
+    file_size = st.st_size;
+
+    void *p = ::mmap(NULL, file_map_size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+#if TERRAIN_DEBUG
+        hal.console->printf("mmap of %lu bytes failed - %s\n",
+                            (unsigned long)file_map_size, strerror(errno));
+#endif
+        return;
+    }
+    file_map = (uint8_t *)p;
+    file_map_dirty = false;
+    last_sync_ms = hal.scheduler->millis();
+}
+
+/*
+  flush and unmap the current degree file
+ */
+void AP_Terrain::mmap_close(void)
+{
+    if (file_map == NULL) {
+        return;
+    }
+    mmap_sync(true);
+    ::munmap(file_map, file_map_size);
+    file_map = NULL;
+    file_map_size = 0;
+    file_size = 0;
+}
+
+/*
+  fill in a block from the mapped degree file. The block must have
+  its position fields set. Returns false if the block is not in the
+  currently mapped file, or with resident_only set if reading it
+  would fault in a page from disk, in which case it must go via the
+  IO timer.
+
+  A block that is past the end of the file or fails validation is
+  returned empty with a zero bitmap, the same as read_block()
+ */
+bool AP_Terrain::mmap_lookup(struct grid_block &block, bool resident_only)
+{
+    if (file_map == NULL ||
+        block.lat_degrees != file_lat_degrees ||
+        block.lon_degrees != file_lon_degrees) {
+        return false;
+    }
+    uint32_t offset = block_file_offset(block.lat_degrees, block.lon_degrees,
+                                        block.grid_idx_x, block.grid_idx_y);
+    if (offset + sizeof(union grid_io_block) > file_map_size) {
+        return false;
+    }
+    if (offset + sizeof(union grid_io_block) > file_size) {
+        // not written yet
+        block.bitmap = 0;
+        return true;
+    }
+    if (resident_only && !mmap_resident(offset)) {
+        return false;
+    }
+    const struct grid_block &disk = *(const struct grid_block *)&file_map[offset];
+    if (disk.bitmap == 0) {
+        // quick check for a hole in the file
+        block.bitmap = 0;
+        return true;
+    }
+    struct grid_block tmp = disk;
+    if (!check_block(tmp, block.lat, block.lon)) {
+        block.bitmap = 0;
+        return true;
+    }
+    block = tmp;
+    return true;
+}
+
+/*
+  return true if the pages holding the block at offset in the mapped
+  file are in memory, so reading it will not block on the disk
+ */
+bool AP_Terrain::mmap_resident(uint32_t offset) const
+{
+    const uint32_t page_size = ::sysconf(_SC_PAGESIZE);
+    uint32_t start = offset & ~(page_size-1);
+    uint32_t end = offset + sizeof(union grid_io_block);
+    unsigned char vec[2];
+    uint32_t num_pages = (end - start + page_size - 1) / page_size;
+    if (num_pages > sizeof(vec) ||
+        ::mincore(&file_map[start], end - start, vec) != 0) {
+        return false;
+    }
+    for (uint8_t i=0; i<num_pages; i++) {
+        if ((vec[i] & 1) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+  write disk_block into the mapped degree file. The data is flushed
+  to disk in batches by mmap_sync(). Returns false if the block is
+  not in the currently mapped file
+ */
+bool AP_Terrain::mmap_write_block(void)
+{
+    const struct grid_block &block = disk_block.block;
+    if (file_map == NULL ||
+        block.lat_degrees != file_lat_degrees ||
+        block.lon_degrees != file_lon_degrees) {
+        return false;
+    }
+    uint32_t offset = block_file_offset(block.lat_degrees, block.lon_degrees,
+                                        block.grid_idx_x, block.grid_idx_y);
+    uint32_t end = offset + sizeof(union grid_io_block);
+    if (end > file_map_size) {
+        return false;
+    }
+    if (end > file_size) {
+        // the file may have grown since it was mapped, and must never
+        // be shortened
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            return false;
+        }
+        file_size = st.st_size;
+    }
+    if (end > file_size) {
+        // extend the file so the mapped pages are backed
+        if (::ftruncate(fd, end) != 0) {
+#if TERRAIN_DEBUG
+            hal.console->printf("ftruncate failed - %s\n", strerror(errno));
+#endif
+            return false;
+        }
+        file_size = end;
+    }
+    memcpy(&file_map[offset], &disk_block, sizeof(disk_block));
+    file_map_dirty = true;
+#if TERRAIN_DEBUG
+    printf("mapped block at %ld %ld mask=%07llx\n",
+           (long)block.lat,
+           (long)block.lon,
+           (unsigned long long)block.bitmap);
+#endif
+    return true;
+}
+
+/*
+  flush written blocks to disk. Unless forced this is rate limited so
+  that a burst of blocks from the GCS is written out in one go
+ */
+void AP_Terrain::mmap_sync(bool force)
+{
+    if (file_map == NULL || !file_map_dirty) {
+        return;
+    }
+    uint32_t now = hal.scheduler->millis();
+    if (!force && now - last_sync_ms < TERRAIN_MMAP_SYNC_MS) {
+        return;
+    }
+    ::msync(file_map, file_size, MS_SYNC);
+    file_map_dirty = false;
+    last_sync_ms = now;
+}
+#endif // TERRAIN_USE_MMAP
+
 /*
   timer called to do disk IO
  */
@@ -306,7 +545,10 @@ void AP_Terrain::io_timer(void)
     case DiskIoIdle:
     case DiskIoDoneRead:
     case DiskIoDoneWrite:
-        // nothing to do
+#if TERRAIN_USE_MMAP
+        // flush any blocks written since the last sync
+        mmap_sync(false);
+#endif
         break;
         
     case DiskIoWaitWrite:
@@ -80,29 +80,38 @@ void AP_Terrain::update_mission_data(void)
 
         // we will fetch 5 points around the waypoint. Four at 10 grid
         // spacings away at 45, 135, 225 and 315 degrees, and the
-        // point itself
-        if (next_mission_pos != 4) {
-            location_update(cmd.content.location, 45+90*next_mission_pos, grid_spacing.get() * 10);
+        // point itself. Points already checked are skipped
+        Location locs[5];
+        float heights[5];
+        bool available[5];
+        uint8_t count = 0;
+        for (uint8_t pos=next_mission_pos; pos<5; pos++) {
+            locs[count] = cmd.content.location;
+            if (pos != 4) {
+                location_update(locs[count], 45+90*pos, grid_spacing.get() * 10);
+            }
+            count++;
         }
 
-        // we have a mission command to check
-        float height;
-        if (!height_amsl(cmd.content.location, height)) {
+        // check all of the remaining points in one pass, so any
+        // missing grids are requested together
+        if (height_amsl_multi(locs, count, heights, available) != count) {
             // if we can't get data for a mission item then return and
-            // check again next time
+            // check again next time, starting from the first missing
+            // point
+            for (uint8_t j=0; j<count && available[j]; j++) {
+                next_mission_pos++;
+            }
             return;
         }
 
-        next_mission_pos++;
-        if (next_mission_pos == 5) {
 #if TERRAIN_DEBUG
-            hal.console->printf("checked waypoint %u\n", (unsigned)next_mission_index);
+        hal.console->printf("checked waypoint %u\n", (unsigned)next_mission_index);
 #endif
 
-            // move to next waypoint
-            next_mission_index++;
-            next_mission_pos = 0;
-        }
+        // move to next waypoint
+        next_mission_index++;
+        next_mission_pos = 0;
     }
 }
 
@@ -66,6 +66,17 @@ bool AP_Terrain::check_bitmap(const struct grid_block &grid, uint8_t idx_x, uint
   grid indices
 */
 void AP_Terrain::calculate_grid_info(const Location &loc, struct grid_info &info) const
+{
+    calculate_grid_index(loc, info);
+    calculate_grid_corner(info);
+}
+
+/*
+  given a location, calculate the degree reference, the 32x28 grid
+  indices and the position within the grid. This fills in everything
+  in grid_info except the grid SW corner
+*/
+void AP_Terrain::calculate_grid_index(const Location &loc, struct grid_info &info) const
 {
     // grids start on integer degrees. This makes storing terrain data
     // on the SD card a bit easier
@@ -98,17 +109,67 @@ void AP_Terrain::calculate_grid_info(const Location &loc, struct grid_info &info
     info.frac_x = (offset.x - idx_x * grid_spacing) / grid_spacing;
     info.frac_y = (offset.y - idx_y * grid_spacing) / grid_spacing;
 
-    // calculate lat/lon of SW corner of 32*28 grid_block
+    ASSERT_RANGE(info.idx_x,0,TERRAIN_GRID_BLOCK_SPACING_X-1);
+    ASSERT_RANGE(info.idx_y,0,TERRAIN_GRID_BLOCK_SPACING_Y-1);
+    ASSERT_RANGE(info.frac_x,0,1);
+    ASSERT_RANGE(info.frac_y,0,1);
+}
+
+/*
+  calculate lat/lon of SW corner of the 32*28 grid_block given by
+  the degree reference and grid indices in a grid_info
+*/
+void AP_Terrain::calculate_grid_corner(struct grid_info &info) const
+{
+    Location ref;
+    ref.lat = info.lat_degrees*10*1000*1000L;
+    ref.lng = info.lon_degrees*10*1000*1000L;
     location_offset(ref, 
                     info.grid_idx_x * TERRAIN_GRID_BLOCK_SPACING_X * (float)grid_spacing,
                     info.grid_idx_y * TERRAIN_GRID_BLOCK_SPACING_Y * (float)grid_spacing);
     info.grid_lat = ref.lat;
     info.grid_lon = ref.lng;
+}
 
-    ASSERT_RANGE(info.idx_x,0,TERRAIN_GRID_BLOCK_SPACING_X-1);
-    ASSERT_RANGE(info.idx_y,0,TERRAIN_GRID_BLOCK_SPACING_Y-1);
-    ASSERT_RANGE(info.frac_x,0,1);
-    ASSERT_RANGE(info.frac_y,0,1);
+/*
+  interpolate the height at a position within a grid. Return false
+  if the 4 surrounding heights are not all available
+*/
+bool AP_Terrain::interpolate_height(const struct grid_block &grid, const struct grid_info &info, float &height)
+{
+    /*
+      note that we rely on the one square overlap to ensure these
+      calculations don't go past the end of the arrays
+     */
+    ASSERT_RANGE(info.idx_x, 0, TERRAIN_GRID_BLOCK_SIZE_X-2);
+    ASSERT_RANGE(info.idx_y, 0, TERRAIN_GRID_BLOCK_SIZE_Y-2);
+
+
+    // check we have all 4 required heights
+    if (!check_bitmap(grid, info.idx_x,   info.idx_y) ||
+        !check_bitmap(grid, info.idx_x,   info.idx_y+1) ||
+        !check_bitmap(grid, info.idx_x+1, info.idx_y) ||
+        !check_bitmap(grid, info.idx_x+1, info.idx_y+1)) {
+        return false;
+    }
+
+    // hXY are the heights of the 4 surrounding grid points
+    int16_t h00, h01, h10, h11;
+
+    h00 = grid.height[info.idx_x+0][info.idx_y+0];
+    h01 = grid.height[info.idx_x+0][info.idx_y+1];
+    h10 = grid.height[info.idx_x+1][info.idx_y+0];
+    h11 = grid.height[info.idx_x+1][info.idx_y+1];
+
+    // do a simple dual linear interpolation. We could do something
+    // fancier, but it probably isn't worth it as long as the
+    // grid_spacing is kept small enough
+    float avg1 = (1.0f-info.frac_x) * h00  + info.frac_x * h10;
+    float avg2 = (1.0f-info.frac_x) * h01  + info.frac_x * h11;
+    float avg  = (1.0f-info.frac_y) * avg1 + info.frac_y * avg2;
+
+    height = avg;
+    return true;
 }
 
 
@@ -147,6 +208,17 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
     grid.grid.version = TERRAIN_GRID_FORMAT_VERSION;
     grid.last_access_ms = hal.scheduler->millis();
 
+#if TERRAIN_USE_MMAP
+    // if the degree file is mapped and the block is in the page cache
+    // then we can fill it straight away. The main thread owns the
+    // mapping while the IO timer is idle. A block that would need a
+    // page fault, and so an SD card read, goes via the IO timer
+    if (disk_io_state == DiskIoIdle && mmap_lookup(grid.grid, true)) {
+        grid.state = GRID_CACHE_VALID;
+        return grid;
+    }
+#endif
+
     // mark as waiting for disk read
     grid.state = GRID_CACHE_DISKWAIT;
 
@@ -745,9 +745,15 @@ void DataFlash_Class::Log_Write_GPS(const AP_GPS &gps, uint8_t i, int32_t relati
     }
 #if HAL_CPU_CLASS > HAL_CPU_CLASS_16
     if (i > 0) {
+        // the blended solution of several receivers is logged as GPSB
+#if GPS_MAX_INSTANCES > 1
+        const uint8_t msgid = (i == GPS_BLENDED_INSTANCE) ? LOG_GPSB_MSG : LOG_GPS2_MSG;
+#else
+        const uint8_t msgid = LOG_GPS2_MSG;
+#endif
         const struct Location &loc2 = gps.location(i);
         struct log_GPS2 pkt2 = {
-            LOG_PACKET_HEADER_INIT(LOG_GPS2_MSG),
+            LOG_PACKET_HEADER_INIT(msgid),
             status        : (uint8_t)gps.status(i),
             gps_week_ms   : gps.time_week_ms(i),
             gps_week      : gps.time_week(i),
@@ -898,6 +904,34 @@ void DataFlash_Class::Log_Write_IMU(const AP_InertialSensor &ins)
 #endif
 }
 
+// Write the vibration levels, accel clipping counts and dropped samples
+void DataFlash_Class::Log_Write_Vibration(const AP_InertialSensor &ins)
+{
+    const Vector3f vibration = ins.get_vibration_levels();
+    uint32_t clipping[3] = {};
+    uint32_t dropped[3] = {};
+    for (uint8_t i=0; i<ins.get_accel_count() && i<3; i++) {
+        clipping[i] = ins.get_accel_clip_count(i);
+    }
+    for (uint8_t i=0; i<ins.get_gyro_count() && i<3; i++) {
+        dropped[i] = ins.get_dropped_sample_count(i);
+    }
+    struct log_Vibe pkt = {
+        LOG_PACKET_HEADER_INIT(LOG_VIBE_MSG),
+        time_ms    : hal.scheduler->millis(),
+        vibe_x     : vibration.x,
+        vibe_y     : vibration.y,
+        vibe_z     : vibration.z,
+        clipping_0 : clipping[0],
+        clipping_1 : clipping[1],
+        clipping_2 : clipping[2],
+        dropped_0  : dropped[0],
+        dropped_1  : dropped[1],
+        dropped_2  : dropped[2]
+    };
+    WriteBlock(&pkt, sizeof(pkt));
+}
+
 // Write a text message to the log
 bool DataFlash_Backend::Log_Write_Message(const char *message)
 {
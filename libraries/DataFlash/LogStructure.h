@@ -466,6 +466,47 @@ struct PACKED log_GYRO {
     float GyrX, GyrY, GyrZ;
 };
 
+// vibration levels of the primary accel, clip counts of each accel and
+// FIFO dropped sample counts of each gyro
+struct PACKED log_Vibe {
+    LOG_PACKET_HEADER;
+    uint32_t time_ms;
+    float vibe_x, vibe_y, vibe_z;
+    uint32_t clipping_0, clipping_1, clipping_2;
+    uint32_t dropped_0, dropped_1, dropped_2;
+};
+
+// dynamic notch tuning: detected gyro vibration peaks and notch centers
+struct PACKED log_FTN {
+    LOG_PACKET_HEADER;
+    uint32_t time_ms;
+    float peak_freq[2];
+    float peak_energy[2];
+    float notch_freq[2];
+};
+
+// a slice of the gyro power spectrum in centi-dB
+struct PACKED log_FFT {
+    LOG_PACKET_HEADER;
+    uint32_t time_ms;
+    uint8_t  first_bin;
+    int16_t  bin[8];
+};
+
+// IMU consistency voting. Errors are in rad/s and m/s/s, the out
+// fields are masks of voted out instances
+struct PACKED log_Vote {
+    LOG_PACKET_HEADER;
+    uint32_t time_ms;
+    float gyro_error[3];
+    float accel_error[3];
+    uint8_t gyro_out;
+    uint8_t accel_out;
+    uint8_t consistent;
+    uint8_t primary_gyro;
+    uint8_t primary_accel;
+};
+
 struct PACKED log_DF_MAV_Stats {
     LOG_PACKET_HEADER;
     uint32_t timestamp;
@@ -547,12 +588,16 @@ Format characters in the format string for binary log messages
     { LOG_MODE_MSG, sizeof(log_Mode), \
       "MODE", "IMB",         "TimeMS,Mode,ModeNum" }, \
     { LOG_DF_MAV_STATS, sizeof(log_DF_MAV_Stats), \
-      "DMS", "IIIIIBBBBBBBBBB",         "TimeMS,N,Dp,RT,RS,Er,Fa,Fmn,Fmx,Pa,Pmn,Pmx,Sa,Smn,Smx" }
+      "DMS", "IIIIIBBBBBBBBBB",         "TimeMS,N,Dp,RT,RS,Er,Fa,Fmn,Fmx,Pa,Pmn,Pmx,Sa,Smn,Smx" }, \
+    { LOG_VIBE_MSG, sizeof(log_Vibe), \
+      "VIBE", "IfffIIIIII",  "TimeMS,VibeX,VibeY,VibeZ,Clip0,Clip1,Clip2,Drop0,Drop1,Drop2" }
 
 // messages for more advanced boards
 #define LOG_EXTRA_STRUCTURES \
     { LOG_GPS2_MSG, sizeof(log_GPS2), \
       "GPS2",  "BIHBcLLeEefIBI", "Status,TimeMS,Week,NSats,HDop,Lat,Lng,Alt,Spd,GCrs,VZ,T,DSc,DAg" }, \
+    { LOG_GPSB_MSG, sizeof(log_GPS2), \
+      "GPSB",  "BIHBcLLeEefIBI", "Status,TimeMS,Week,NSats,HDop,Lat,Lng,Alt,Spd,GCrs,VZ,T,DSc,DAg" }, \
     { LOG_IMU2_MSG, sizeof(log_IMU), \
       "IMU2",  "IffffffIIf",     "TimeMS,GyrX,GyrY,GyrZ,AccX,AccY,AccZ,ErrG,ErrA,Temp" }, \
     { LOG_IMU3_MSG, sizeof(log_IMU), \
@@ -626,7 +671,13 @@ Format characters in the format string for binary log messages
     { LOG_GYR3_MSG, sizeof(log_GYRO), \
       "GYR3", "IIfff",        "TimeMS,TimeUS,GyrX,GyrY,GyrZ" }, \
     { LOG_EKF6_MSG, sizeof(log_EKF6), \
-      "EKF6","IHfffff","TimeMS,GCS,VVD,GSE,PDR,VVF,HVF" }
+      "EKF6","IHfffff","TimeMS,GCS,VVD,GSE,PDR,VVF,HVF" }, \
+    { LOG_FTN_MSG, sizeof(log_FTN), \
+      "FTN", "Iffffff", "TimeMS,Pk1,Pk2,E1,E2,N1,N2" }, \
+    { LOG_FFT_MSG, sizeof(log_FFT), \
+      "FFT", "IBcccccccc", "TimeMS,Ofs,B0,B1,B2,B3,B4,B5,B6,B7" }, \
+    { LOG_VOTE_MSG, sizeof(log_Vote), \
+      "VOTE", "IffffffBBBBB", "TimeMS,GE0,GE1,GE2,AE0,AE1,AE2,GOut,AOut,Cons,PG,PA" }
 
 #if HAL_CPU_CLASS >= HAL_CPU_CLASS_75
 #define LOG_COMMON_STRUCTURES LOG_BASE_STRUCTURES, LOG_EXTRA_STRUCTURES
@@ -696,6 +747,11 @@ Format characters in the format string for binary log messages
 #define LOG_DF_MAV_STATS  184
 #define LOG_EKF6_MSG      185
 #define LOG_R10CGIMBAL_MSG 186
+#define LOG_FTN_MSG       187
+#define LOG_FFT_MSG       188
+#define LOG_VIBE_MSG      189
+#define LOG_VOTE_MSG      190
+#define LOG_GPSB_MSG      191
 
 // message types 200 to 210 reversed for GPS driver use
 // message types 211 to 220 reversed for autotune use
@@ -0,0 +1,183 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file   BiquadFilterBank.h
+/// @brief  Cascaded biquad filter sections applied to several channels at once,
+///         for example the three axes of each of several IMUs.
+///
+///         All channels share the coefficients of a section, and the delay
+///         elements are stored with one row of channels per section. The inner
+///         loop over channels then has no dependency between iterations and is
+///         vectorised by the compiler on processors with SIMD floating point.
+
+#ifndef __BIQUAD_FILTER_BANK_H__
+#define __BIQUAD_FILTER_BANK_H__
+
+#include <AP_Math.h>
+#include "LowPassFilter2p.h"
+
+template <uint8_t CHANNELS, uint8_t SECTIONS>
+class BiquadFilterBank
+{
+public:
+    // constructor. All sections start disabled
+    BiquadFilterBank();
+
+    // set a section to a second order low pass. A zero cutoff disables the section
+    void set_lowpass(uint8_t section, float sample_freq, float cutoff_freq);
+
+    // set a section to a notch. A zero center frequency disables the section
+    void set_notch(uint8_t section, float sample_freq, float center_freq, float bandwidth_hz);
+
+    // disable a section, so that it passes samples through
+    void disable(uint8_t section);
+
+    // reset - clear the state of all channels
+    void reset();
+
+    // apply - filter one sample for each channel, in place
+    void apply(float samples[CHANNELS]);
+
+    // apply - filter CHANNELS/3 vectors, in place
+    void apply(Vector3f *vectors);
+
+    // return the coefficients of a section
+    const DigitalBiquadFilter::biquad_params &get_params(uint8_t section) const {
+        return _params[section];
+    }
+
+private:
+    void _apply_section(uint8_t section, float samples[CHANNELS]);
+
+    struct DigitalBiquadFilter::biquad_params _params[SECTIONS];
+
+    // delay elements, one row of channels per section
+    float _delay_element_1[SECTIONS][CHANNELS];
+    float _delay_element_2[SECTIONS][CHANNELS];
+};
+
+// Constructor
+template <uint8_t CHANNELS, uint8_t SECTIONS>
+BiquadFilterBank<CHANNELS,SECTIONS>::BiquadFilterBank()
+{
+    memset(_params, 0, sizeof(_params));
+    reset();
+}
+
+template <uint8_t CHANNELS, uint8_t SECTIONS>
+void BiquadFilterBank<CHANNELS,SECTIONS>::set_lowpass(uint8_t section, float sample_freq, float cutoff_freq)
+{
+    if (section >= SECTIONS) {
+        return;
+    }
+    if (cutoff_freq <= 0.0f || sample_freq <= 0.0f) {
+        disable(section);
+        return;
+    }
+    DigitalBiquadFilter::compute_params(sample_freq, cutoff_freq, _params[section]);
+}
+
+template <uint8_t CHANNELS, uint8_t SECTIONS>
+void BiquadFilterBank<CHANNELS,SECTIONS>::set_notch(uint8_t section, float sample_freq, float center_freq, float bandwidth_hz)
+{
+    if (section >= SECTIONS) {
+        return;
+    }
+    DigitalBiquadFilter::compute_notch_params(sample_freq, center_freq, bandwidth_hz, _params[section]);
+}
+
+template <uint8_t CHANNELS, uint8_t SECTIONS>
+void BiquadFilterBank<CHANNELS,SECTIONS>::disable(uint8_t section)
+{
+    if (section >= SECTIONS) {
+        return;
+    }
+    _params[section].cutoff_freq = 0.0f;
+}
+
+// reset - clear the delay elements of every section and channel
+template <uint8_t CHANNELS, uint8_t SECTIONS>
+void BiquadFilterBank<CHANNELS,SECTIONS>::reset()
+{
+    memset(_delay_element_1, 0, sizeof(_delay_element_1));
+    memset(_delay_element_2, 0, sizeof(_delay_element_2));
+}
+
+// apply - run each enabled section in turn over all channels
+template <uint8_t CHANNELS, uint8_t SECTIONS>
+void BiquadFilterBank<CHANNELS,SECTIONS>::apply(float samples[CHANNELS])
+{
+    for (uint8_t s=0; s<SECTIONS; s++) {
+        if (_params[s].cutoff_freq != 0.0f) {
+            _apply_section(s, samples);
+        }
+    }
+}
+
+template <uint8_t CHANNELS, uint8_t SECTIONS>
+void BiquadFilterBank<CHANNELS,SECTIONS>::apply(Vector3f *vectors)
+{
+    float samples[CHANNELS];
+    for (uint8_t i=0; i<CHANNELS/3; i++) {
+        samples[3*i]   = vectors[i].x;
+        samples[3*i+1] = vectors[i].y;
+        samples[3*i+2] = vectors[i].z;
+    }
+    apply(samples);
+    for (uint8_t i=0; i<CHANNELS/3; i++) {
+        vectors[i].x = samples[3*i];
+        vectors[i].y = samples[3*i+1];
+        vectors[i].z = samples[3*i+2];
+    }
+}
+
+/*
+  run one section over all channels. This is the same direct form II
+  as DigitalBiquadFilter::apply(), but the check for a non-finite
+  result is done in a separate pass so the main loop stays branch free
+ */
+template <uint8_t CHANNELS, uint8_t SECTIONS>
+void BiquadFilterBank<CHANNELS,SECTIONS>::_apply_section(uint8_t section, float samples[CHANNELS])
+{
+    const float a1 = _params[section].a1;
+    const float a2 = _params[section].a2;
+    const float b0 = _params[section].b0;
+    const float b1 = _params[section].b1;
+    const float b2 = _params[section].b2;
+    float *d1 = _delay_element_1[section];
+    float *d2 = _delay_element_2[section];
+
+    float input[CHANNELS];
+    memcpy(input, samples, sizeof(input));
+
+    for (uint8_t i=0; i<CHANNELS; i++) {
+        float d0 = input[i] - d1[i] * a1 - d2[i] * a2;
+        samples[i] = d0 * b0 + d1[i] * b1 + d2[i] * b2;
+        d2[i] = d1[i];
+        d1[i] = d0;
+    }
+
+    for (uint8_t i=0; i<CHANNELS; i++) {
+        if (isnan(d1[i]) || isinf(d1[i])) {
+            // pass the raw sample through and restart this channel from it
+            d1[i] = input[i];
+            samples[i] = input[i];
+        }
+    }
+}
+
+#endif // __BIQUAD_FILTER_BANK_H__
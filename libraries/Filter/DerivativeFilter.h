@@ -22,6 +22,8 @@
 #ifndef __DERIVATIVE_FILTER_H__
 #define __DERIVATIVE_FILTER_H__
 
+#include <string.h>
+#include <math.h>
 #include "FilterClass.h"
 #include "FilterWithBuffer.h"
 
@@ -58,5 +60,141 @@ typedef DerivativeFilter<float,7> DerivativeFilterFloat_Size7;
 typedef DerivativeFilter<float,9> DerivativeFilterFloat_Size9;
 
 
+/*
+  coefficients of the differentiators above, as used by
+  FastDerivativeFilter. k runs from 1 to FILTER_SIZE/2 and the weight
+  of (f(k)-f(-k))/(x(k)-x(-k)) is 2*k*coefficient(k)
+ */
+template <uint8_t FILTER_SIZE>
+struct DerivativeFilterCoefficients;
+
+template <> struct DerivativeFilterCoefficients<5> {
+    static float get(uint8_t k) {
+        static const float c[] = { 2*2/8.0f, 4*1/8.0f };
+        return c[k-1];
+    }
+};
+
+template <> struct DerivativeFilterCoefficients<7> {
+    static float get(uint8_t k) {
+        static const float c[] = { 2*5/32.0f, 4*4/32.0f, 6*1/32.0f };
+        return c[k-1];
+    }
+};
+
+template <> struct DerivativeFilterCoefficients<9> {
+    static float get(uint8_t k) {
+        static const float c[] = { 2*14/128.0f, 4*14/128.0f, 6*6/128.0f, 8*1/128.0f };
+        return c[k-1];
+    }
+};
+
+template <> struct DerivativeFilterCoefficients<11> {
+    static float get(uint8_t k) {
+        static const float c[] = { 2*42/512.0f, 4*48/512.0f, 6*27/512.0f, 8*8/512.0f, 10*1/512.0f };
+        return c[k-1];
+    }
+};
+
+/*
+  FastDerivativeFilter - the same smooth differentiator as
+  DerivativeFilter, without virtual dispatch.
+
+  Each sample and timestamp is stored twice, FILTER_SIZE apart, so the
+  window is always a contiguous slice of the buffer and the slope is
+  computed without modulo arithmetic. The size is checked at compile
+  time, as only 5, 7, 9 and 11 have coefficients.
+ */
+template <class T, uint8_t FILTER_SIZE>
+class FastDerivativeFilter
+{
+public:
+    FastDerivativeFilter() { reset(); }
+
+    // update - Add a new raw value to the filter, but don't recalculate
+    void update(T sample, uint32_t timestamp);
+
+    // return the derivative value
+    float slope(void);
+
+    // reset - clear the filter
+    void reset(void);
+
+private:
+    T               _samples[2*FILTER_SIZE];
+    uint32_t        _timestamps[2*FILTER_SIZE];
+    uint8_t         _index;     // start of the window, which is the oldest sample
+    uint8_t         _count;
+    bool            _new_data;
+    float           _last_slope;
+};
+
+typedef FastDerivativeFilter<float,5> FastDerivativeFilterFloat_Size5;
+typedef FastDerivativeFilter<float,7> FastDerivativeFilterFloat_Size7;
+typedef FastDerivativeFilter<float,9> FastDerivativeFilterFloat_Size9;
+
+template <class T, uint8_t FILTER_SIZE>
+void FastDerivativeFilter<T,FILTER_SIZE>::reset(void)
+{
+    memset(_samples, 0, sizeof(_samples));
+    memset(_timestamps, 0, sizeof(_timestamps));
+    _index = 0;
+    _count = 0;
+    _new_data = false;
+    _last_slope = 0;
+}
+
+template <class T, uint8_t FILTER_SIZE>
+void FastDerivativeFilter<T,FILTER_SIZE>::update(T sample, uint32_t timestamp)
+{
+    if (_count > 0 && _timestamps[_index + FILTER_SIZE - 1] == timestamp) {
+        // this is not a new timestamp - ignore
+        return;
+    }
+
+    // overwrite the oldest sample in both copies
+    _samples[_index] = sample;
+    _samples[_index + FILTER_SIZE] = sample;
+    _timestamps[_index] = timestamp;
+    _timestamps[_index + FILTER_SIZE] = timestamp;
+    if (++_index >= FILTER_SIZE) {
+        _index = 0;
+    }
+    if (_count < FILTER_SIZE) {
+        _count++;
+    }
+    _new_data = true;
+}
+
+template <class T, uint8_t FILTER_SIZE>
+float FastDerivativeFilter<T,FILTER_SIZE>::slope(void)
+{
+    if (!_new_data) {
+        return _last_slope;
+    }
+    if (_count < FILTER_SIZE) {
+        // we haven't filled the buffer yet - assume zero derivative
+        return 0;
+    }
+
+    // the window runs oldest to newest from _index, with f(0) in the middle
+    const T *f = &_samples[_index + FILTER_SIZE/2];
+    const uint32_t *x = &_timestamps[_index + FILTER_SIZE/2];
+
+    float result = 0;
+    for (uint8_t k=1; k<=FILTER_SIZE/2; k++) {
+        result += DerivativeFilterCoefficients<FILTER_SIZE>::get(k) *
+            (f[k] - f[-(int8_t)k]) / (float)(x[k] - x[-(int8_t)k]);
+    }
+
+    // cope with numerical errors
+    if (isnan(result) || isinf(result)) {
+        result = 0;
+    }
+    _new_data = false;
+    _last_slope = result;
+    return result;
+}
+
 #endif // __DERIVATIVE_FILTER_H__
 
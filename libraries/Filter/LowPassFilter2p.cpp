@@ -56,3 +56,26 @@ void DigitalBiquadFilter::compute_params(float sample_freq, float cutoff_freq, b
     ret.a1 = 2.0f*(ohm*ohm-1.0f)/c;
     ret.a2 = (1.0f-2.0f*cosf(PI/4.0f)*ohm+ohm*ohm)/c;
 }
+
+void DigitalBiquadFilter::compute_notch_params(float sample_freq, float center_freq, float bandwidth_hz, biquad_params &ret)
+{
+    ret.cutoff_freq = center_freq;
+    ret.sample_freq = sample_freq;
+
+    if (center_freq <= 0.0f || sample_freq <= 0.0f || bandwidth_hz <= 0.0f) {
+        // a zero cutoff makes apply() pass samples through
+        ret.cutoff_freq = 0.0f;
+        return;
+    }
+
+    float omega = 2.0f*PI*center_freq/sample_freq;
+    float Q = center_freq/bandwidth_hz;
+    float alpha = sinf(omega)/(2.0f*Q);
+    float c = 1.0f+alpha;
+
+    ret.b0 = 1.0f/c;
+    ret.b1 = -2.0f*cosf(omega)/c;
+    ret.b2 = ret.b0;
+    ret.a1 = ret.b1;
+    ret.a2 = (1.0f-alpha)/c;
+}
@@ -45,6 +45,9 @@ public:
 
     static void compute_params(float sample_freq, float cutoff_freq, biquad_params &ret);
 
+    // notch centred on center_freq, with bandwidth_hz between the -3dB points
+    static void compute_notch_params(float sample_freq, float center_freq, float bandwidth_hz, biquad_params &ret);
+
 private:
     float _delay_element_1;
     float _delay_element_2;
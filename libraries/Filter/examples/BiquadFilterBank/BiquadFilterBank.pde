@@ -0,0 +1,139 @@
+/*
+ *       Example sketch to benchmark BiquadFilterBank against the
+ *       per-axis LowPassFilter2pVector3f, filtering three IMUs
+ */
+
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_HAL.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_PX4.h>
+#include <AP_HAL_FLYMAPLE.h>
+#include <AP_Param.h>
+#include <StorageManager.h>
+#include <AP_Math.h>            // ArduPilot Mega Vector/Matrix math Library
+#include <Filter.h>                     // Filter library
+#include <LowPassFilter2p.h>
+#include <BiquadFilterBank.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#define NUM_IMUS        3
+#define NUM_SAMPLES     2000
+#define SAMPLE_FREQ     1000
+#define CUTOFF_FREQ     20
+
+// the current implementation, one filter object per IMU
+static LowPassFilter2pVector3f vector_filter[NUM_IMUS];
+
+// three axes of three IMUs, with a low pass and a notch section
+static BiquadFilterBank<3*NUM_IMUS, 2> filter_bank;
+
+// 3 IMUs, 3 axes, one low pass section to compare outputs
+static BiquadFilterBank<3*NUM_IMUS, 1> compare_bank;
+
+// the test signal repeats every INPUT_PERIOD samples, so it is
+// calculated once before the timing loops
+#define INPUT_PERIOD    200
+static Vector3f input[INPUT_PERIOD][NUM_IMUS];
+
+static void fill_input(void)
+{
+    for (uint16_t n=0; n<INPUT_PERIOD; n++) {
+        float t = (float)n / SAMPLE_FREQ;
+        for (uint8_t imu=0; imu<NUM_IMUS; imu++) {
+            input[n][imu] = Vector3f(sinf(2*PI*5*t + imu),
+                                     sinf(2*PI*80*t) + 0.2f*imu,
+                                     cosf(2*PI*200*t));
+        }
+    }
+}
+
+// setup routine
+static void setup()
+{
+    // introduction
+    hal.console->printf("ArduPilot BiquadFilterBank benchmark\n\n");
+
+    for (uint8_t i=0; i<NUM_IMUS; i++) {
+        vector_filter[i].set_cutoff_frequency(SAMPLE_FREQ, CUTOFF_FREQ);
+    }
+    filter_bank.set_lowpass(0, SAMPLE_FREQ, CUTOFF_FREQ);
+    filter_bank.set_notch(1, SAMPLE_FREQ, 80, 20);
+    compare_bank.set_lowpass(0, SAMPLE_FREQ, CUTOFF_FREQ);
+    fill_input();
+}
+
+static void check_outputs(void)
+{
+    float max_error = 0;
+    Vector3f samples[NUM_IMUS];
+
+    for (uint8_t i=0; i<NUM_IMUS; i++) {
+        vector_filter[i] = LowPassFilter2pVector3f(SAMPLE_FREQ, CUTOFF_FREQ);
+    }
+    compare_bank.reset();
+
+    for (uint16_t n=0; n<NUM_SAMPLES; n++) {
+        for (uint8_t i=0; i<NUM_IMUS; i++) {
+            samples[i] = input[n % INPUT_PERIOD][i];
+        }
+        compare_bank.apply(samples);
+        for (uint8_t i=0; i<NUM_IMUS; i++) {
+            Vector3f v = vector_filter[i].apply(input[n % INPUT_PERIOD][i]);
+            max_error = max(max_error, (v - samples[i]).length());
+        }
+    }
+    hal.console->printf("max difference from LowPassFilter2pVector3f: %.8f\n", max_error);
+}
+
+void loop()
+{
+    Vector3f samples[NUM_IMUS];
+    Vector3f sum;
+    uint32_t t0, t_vector, t_bank, t_bank2;
+
+    check_outputs();
+
+    // per-axis filters, one low pass section
+    t0 = hal.scheduler->micros();
+    for (uint16_t n=0; n<NUM_SAMPLES; n++) {
+        for (uint8_t i=0; i<NUM_IMUS; i++) {
+            sum += vector_filter[i].apply(input[n % INPUT_PERIOD][i]);
+        }
+    }
+    t_vector = hal.scheduler->micros() - t0;
+
+    // filter bank, one low pass section
+    t0 = hal.scheduler->micros();
+    for (uint16_t n=0; n<NUM_SAMPLES; n++) {
+        for (uint8_t i=0; i<NUM_IMUS; i++) {
+            samples[i] = input[n % INPUT_PERIOD][i];
+        }
+        compare_bank.apply(samples);
+        sum += samples[0];
+    }
+    t_bank = hal.scheduler->micros() - t0;
+
+    // filter bank, low pass and notch sections
+    t0 = hal.scheduler->micros();
+    for (uint16_t n=0; n<NUM_SAMPLES; n++) {
+        for (uint8_t i=0; i<NUM_IMUS; i++) {
+            samples[i] = input[n % INPUT_PERIOD][i];
+        }
+        filter_bank.apply(samples);
+        sum += samples[0];
+    }
+    t_bank2 = hal.scheduler->micros() - t0;
+
+    // copying the inputs is common to all three loops
+    hal.console->printf("%u samples x %u IMUs (sum %.2f)\n",
+                        (unsigned)NUM_SAMPLES, (unsigned)NUM_IMUS, sum.length());
+    hal.console->printf("LowPassFilter2pVector3f:        %lu usec\n", (unsigned long)t_vector);
+    hal.console->printf("BiquadFilterBank low pass:      %lu usec\n", (unsigned long)t_bank);
+    hal.console->printf("BiquadFilterBank low pass+notch: %lu usec\n\n", (unsigned long)t_bank2);
+
+    hal.scheduler->delay(5000);
+}
+
+AP_HAL_MAIN();
@@ -0,0 +1,102 @@
+/*
+ *       Example sketch to benchmark the virtual DerivativeFilter
+ *       against FastDerivativeFilter, and check that they give the
+ *       same slope
+ */
+
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_HAL.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_PX4.h>
+#include <AP_HAL_FLYMAPLE.h>
+#include <AP_Param.h>
+#include <StorageManager.h>
+#include <AP_Math.h>            // ArduPilot Mega Vector/Matrix math Library
+#include <Filter.h>                     // Filter library
+#include <DerivativeFilter.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#define NUM_SAMPLES     2000
+
+// 7 point derivative, as used for the baro climb rate
+static DerivativeFilterFloat_Size7 derivative_filter;
+static FastDerivativeFilterFloat_Size7 fast_derivative_filter;
+
+// a noisy altitude with occasional glitches. It is calculated before
+// the timing loops so they time only the filters
+static float input[NUM_SAMPLES];
+
+static void fill_input(void)
+{
+    for (uint16_t n=0; n<NUM_SAMPLES; n++) {
+        float s = 500 + 100*sinf(n * 0.01f) + (int16_t)(n * 7919 % 21) - 10;
+        if (n % 37 == 0) {
+            s += 400;
+        }
+        input[n] = s;
+    }
+}
+
+// setup routine
+static void setup()
+{
+    // introduction
+    hal.console->printf("ArduPilot Filter benchmark\n\n");
+
+    fill_input();
+}
+
+/*
+  check the derivative filters agree once their windows are full
+ */
+static void check_outputs(void)
+{
+    float max_slope_error = 0;
+
+    derivative_filter.reset();
+    fast_derivative_filter.reset();
+
+    for (uint16_t n=0; n<NUM_SAMPLES; n++) {
+        derivative_filter.update(input[n], (n+1)*20);
+        fast_derivative_filter.update(input[n], (n+1)*20);
+        if (n >= 7) {
+            float err = fabsf(derivative_filter.slope() - fast_derivative_filter.slope());
+            max_slope_error = max(max_slope_error, err);
+        }
+    }
+    hal.console->printf("max difference from DerivativeFilter: %.8f\n", max_slope_error);
+}
+
+void loop()
+{
+    float sum = 0;
+    uint32_t t0, t_deriv, t_fast_deriv;
+
+    check_outputs();
+
+    // the slope is read after every update, as AP_Baro does
+    t0 = hal.scheduler->micros();
+    for (uint16_t n=0; n<NUM_SAMPLES; n++) {
+        derivative_filter.update(input[n], t0 + n*20);
+        sum += derivative_filter.slope();
+    }
+    t_deriv = hal.scheduler->micros() - t0;
+
+    t0 = hal.scheduler->micros();
+    for (uint16_t n=0; n<NUM_SAMPLES; n++) {
+        fast_derivative_filter.update(input[n], t0 + n*20);
+        sum += fast_derivative_filter.slope();
+    }
+    t_fast_deriv = hal.scheduler->micros() - t0;
+
+    // the sum keeps the slopes from being optimised away
+    hal.console->printf("%u samples (sum %.2f)\n", (unsigned)NUM_SAMPLES, sum);
+    hal.console->printf("DerivativeFilter:     %lu usec\n", (unsigned long)t_deriv);
+    hal.console->printf("FastDerivativeFilter: %lu usec\n\n", (unsigned long)t_fast_deriv);
+
+    hal.scheduler->delay(5000);
+}
+
+AP_HAL_MAIN();
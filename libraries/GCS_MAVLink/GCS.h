@@ -18,6 +18,18 @@
 #include "../AP_SerialManager/AP_SerialManager.h"
 #include "../AP_Mount/AP_Mount.h"
 
+// number of MISSION_REQUEST messages kept outstanding during a
+// mission upload, and whether a full upload is staged in RAM and
+// checked before being committed to storage. The window is at most 8
+// items, as the items received in it are kept in an 8 bit mask
+#if HAL_CPU_CLASS >= HAL_CPU_CLASS_75
+#define GCS_MISSION_REQUEST_WINDOW 4
+#define GCS_MISSION_STAGING 1
+#else
+#define GCS_MISSION_REQUEST_WINDOW 1
+#define GCS_MISSION_STAGING 0
+#endif
+
 //  GCS Message ID's
 /// NOTE: to ensure we never block on sending MAVLink messages
 /// please keep each MSG_ to a single MAVLink message. If need be
@@ -62,6 +74,7 @@ enum ap_message {
     MSG_GPS_ACCURACY,
     MSG_LOCAL_POSITION,
     MSG_ARMMASK,
+    MSG_VIBRATION,
     MSG_RETRY_DEFERRED // this must be last
 };
 
@@ -141,6 +154,7 @@ public:
 #endif
     void send_autopilot_version(void) const;
     void send_local_position(const AP_AHRS &ahrs) const;
+    void send_vibration(const AP_InertialSensor &ins) const;
     void send_home(const Location &home) const;
     
     // return a bitmap of active channels. Used by libraries to loop
@@ -211,6 +225,8 @@ private:
     // waypoints
     uint16_t        waypoint_request_i; // request index
     uint16_t        waypoint_request_last; // last request index
+    uint16_t        waypoint_request_next; // next index to request, up to GCS_MISSION_REQUEST_WINDOW ahead of waypoint_request_i
+    uint8_t         waypoint_received_mask; // items from waypoint_request_i on already received, bit 0 being waypoint_request_i
     uint16_t        waypoint_dest_sysid; // where to send requests
     uint16_t        waypoint_dest_compid; // "
     bool            waypoint_receiving; // currently receiving
@@ -218,6 +234,9 @@ private:
     uint32_t        waypoint_timelast_receive; // milliseconds
     uint32_t        waypoint_timelast_request; // milliseconds
     const uint16_t  waypoint_receive_timeout; // milliseconds
+#if GCS_MISSION_STAGING
+    AP_Mission::Mission_Command *waypoint_staging; // full mission being uploaded, NULL if writing straight to storage
+#endif
 
     // saveable rate of each stream
     AP_Int16        streamRates[NUM_STREAMS];
@@ -296,6 +315,10 @@ private:
     void handle_mission_clear_all(AP_Mission &mission, mavlink_message_t *msg);
     void handle_mission_write_partial_list(AP_Mission &mission, mavlink_message_t *msg);
     void handle_mission_item(mavlink_message_t *msg, AP_Mission &mission);
+#if GCS_MISSION_STAGING
+    uint8_t commit_staged_mission(AP_Mission &mission);
+    void free_staged_mission(void);
+#endif
 
     void handle_request_data_stream(mavlink_message_t *msg, bool save);
     void handle_param_request_list(mavlink_message_t *msg);
@@ -27,6 +27,9 @@ uint8_t GCS_MAVLINK::mavlink_active = 0;
 
 GCS_MAVLINK::GCS_MAVLINK() :
     waypoint_receive_timeout(5000)
+#if GCS_MISSION_STAGING
+    , waypoint_staging(NULL)
+#endif
 {
     AP_Param::setup_object_defaults(this, var_info);
 }
@@ -181,20 +184,44 @@ GCS_MAVLINK::queued_param_send()
 }
 
 /**
- * @brief Send the next pending waypoint, called from deferred message
- * handling code
+ * @brief Send the next pending waypoint requests, called from deferred
+ * message handling code. Up to GCS_MISSION_REQUEST_WINDOW requests are
+ * kept outstanding so the GCS can send items back to back
  */
 void
 GCS_MAVLINK::queued_waypoint_send()
 {
-    if (initialised &&
-        waypoint_receiving &&
-        waypoint_request_i <= waypoint_request_last) {
+    if (!initialised || !waypoint_receiving) {
+        return;
+    }
+    if (waypoint_request_next < waypoint_request_i) {
+        waypoint_request_next = waypoint_request_i;
+    }
+
+    // the window stops at waypoint_request_last, but we always
+    // allow a request for the next expected item, which is how a
+    // single item partial list update is requested
+    uint16_t window_end = waypoint_request_i + GCS_MISSION_REQUEST_WINDOW;
+    if (window_end > waypoint_request_last) {
+        window_end = max(waypoint_request_last, waypoint_request_i+1);
+    }
+
+    while (waypoint_request_next < window_end) {
+        if (waypoint_received_mask & (1U << (waypoint_request_next - waypoint_request_i))) {
+            // already received out of order
+            waypoint_request_next++;
+            continue;
+        }
         mavlink_msg_mission_request_send(
             chan,
             waypoint_dest_sysid,
             waypoint_dest_compid,
-            waypoint_request_i);
+            waypoint_request_next);
+        waypoint_request_next++;
+        if (comm_get_txspace(chan) < 
+            MAVLINK_NUM_NON_PAYLOAD_BYTES+MAVLINK_MSG_ID_MISSION_REQUEST_LEN) {
+            break;
+        }
     }
 }
 
@@ -254,6 +281,9 @@ void GCS_MAVLINK::handle_mission_request_list(AP_Mission &mission, mavlink_messa
     mavlink_msg_mission_count_send(chan,msg->sysid, msg->compid, mission.num_commands());
 
     // set variables to help handle the expected sending of commands to the GCS
+#if GCS_MISSION_STAGING
+    free_staged_mission();                  // abandon any upload in progress
+#endif
     waypoint_receiving = false;             // record that we are sending commands (i.e. not receiving)
     waypoint_dest_sysid = msg->sysid;       // record system id of GCS who has requested the commands
     waypoint_dest_compid = msg->compid;     // record component id of GCS who has requested the commands
@@ -344,13 +374,29 @@ void GCS_MAVLINK::handle_mission_count(AP_Mission &mission, mavlink_message_t *m
         return;
     }
 
+#if GCS_MISSION_STAGING
+    // stage the new mission in RAM, so the current mission is left
+    // untouched until the whole of the new one has arrived and been
+    // checked
+    free_staged_mission();
+    if (packet.count > 0) {
+        waypoint_staging = (AP_Mission::Mission_Command *)calloc(packet.count, sizeof(waypoint_staging[0]));
+    }
+    if (waypoint_staging == NULL) {
+        // new mission arriving, truncate mission to be the same length
+        mission.truncate(packet.count);
+    }
+#else
     // new mission arriving, truncate mission to be the same length
     mission.truncate(packet.count);
+#endif
 
     // set variables to help handle the expected receiving of commands from the GCS
     waypoint_timelast_receive = hal.scheduler->millis();    // set time we last received commands to now
     waypoint_receiving = true;              // record that we expect to receive commands
     waypoint_request_i = 0;                 // reset the next expected command number to zero
+    waypoint_request_next = 0;              // reset the next command number to request to zero
+    waypoint_received_mask = 0;             // nothing received out of order yet
     waypoint_request_last = packet.count;   // record how many commands we expect to receive
     waypoint_timelast_request = 0;          // set time we last requested commands to zero
 }
@@ -391,13 +437,72 @@ void GCS_MAVLINK::handle_mission_write_partial_list(AP_Mission &mission, mavlink
         return;
     }
 
+#if GCS_MISSION_STAGING
+    // partial updates are written straight to storage
+    free_staged_mission();
+#endif
+
     waypoint_timelast_receive = hal.scheduler->millis();
     waypoint_timelast_request = 0;
     waypoint_receiving   = true;
     waypoint_request_i   = packet.start_index;
+    waypoint_request_next= packet.start_index;
+    waypoint_received_mask = 0;
     waypoint_request_last= packet.end_index;
 }
 
+#if GCS_MISSION_STAGING
+/*
+  check a fully received mission and write it to storage in one
+  pass. Returns the MAV_MISSION_RESULT to send to the GCS.
+
+  Each item was already decoded by mavlink_to_mission_cmd(). Here the
+  checks that need the whole mission are made: jump targets must be
+  within it, and navigation commands must have a valid latitude and
+  longitude. Other command parameters are stored as the GCS sent them,
+  as for an upload written straight to storage
+ */
+uint8_t GCS_MAVLINK::commit_staged_mission(AP_Mission &mission)
+{
+    uint16_t count = waypoint_request_last;
+    uint8_t result = MAV_MISSION_ACCEPTED;
+
+    for (uint16_t i=0; i<count && result == MAV_MISSION_ACCEPTED; i++) {
+        const AP_Mission::Mission_Command &cmd = waypoint_staging[i];
+        if (cmd.id == MAV_CMD_DO_JUMP) {
+            if (cmd.content.jump.target == 0 || cmd.content.jump.target >= count) {
+                result = MAV_MISSION_INVALID_PARAM1;
+            }
+        } else if (AP_Mission::is_nav_cmd(cmd)) {
+            if (labs(cmd.content.location.lat) > 900000000L) {
+                result = MAV_MISSION_INVALID_PARAM5_X;
+            } else if (labs(cmd.content.location.lng) > 1800000000L) {
+                result = MAV_MISSION_INVALID_PARAM6_Y;
+            }
+        }
+    }
+
+    if (result == MAV_MISSION_ACCEPTED &&
+        !mission.write_mission_to_storage(waypoint_staging, count)) {
+        result = MAV_MISSION_ERROR;
+    }
+
+    free_staged_mission();
+    return result;
+}
+
+/*
+  release the RAM copy of a mission upload
+ */
+void GCS_MAVLINK::free_staged_mission(void)
+{
+    if (waypoint_staging != NULL) {
+        free(waypoint_staging);
+        waypoint_staging = NULL;
+    }
+}
+#endif // GCS_MISSION_STAGING
+
 
 /*
   handle a GIMBAL_REPORT mavlink packet
@@ -732,16 +837,46 @@ void GCS_MAVLINK::handle_mission_item(mavlink_message_t *msg, AP_Mission &missio
 
     // Check if receiving waypoints (mission upload expected)
     if (!waypoint_receiving) {
+        if (GCS_MISSION_REQUEST_WINDOW > 1 &&
+            packet.seq < waypoint_request_last &&
+            hal.scheduler->millis() - waypoint_timelast_receive < waypoint_receive_timeout) {
+            // a late duplicate reply to a request of the upload that
+            // just finished
+            return;
+        }
         result = MAV_MISSION_ERROR;
         goto mission_ack;
     }
 
     // check if this is the requested waypoint
     if (packet.seq != waypoint_request_i) {
+        if (packet.seq + GCS_MISSION_REQUEST_WINDOW > waypoint_request_i &&
+            packet.seq < waypoint_request_i + GCS_MISSION_REQUEST_WINDOW) {
+            // a reply to one of the requests sent ahead of time
+            // arrived before an earlier one, or is a duplicate
+#if GCS_MISSION_STAGING
+            if (waypoint_staging != NULL &&
+                packet.seq > waypoint_request_i &&
+                packet.seq < waypoint_request_last) {
+                // keep it, it will not be requested again
+                waypoint_staging[packet.seq] = cmd;
+                waypoint_received_mask |= 1U << (packet.seq - waypoint_request_i);
+                waypoint_timelast_receive = hal.scheduler->millis();
+            }
+#endif
+            return;
+        }
         result = MAV_MISSION_INVALID_SEQUENCE;
         goto mission_ack;
     }
     
+#if GCS_MISSION_STAGING
+    if (waypoint_staging != NULL) {
+        // hold the command until the whole mission has arrived
+        waypoint_staging[packet.seq] = cmd;
+        result = MAV_MISSION_ACCEPTED;
+    } else
+#endif
     // if command index is within the existing list, replace the command
     if (packet.seq < mission.num_commands()) {
         if (mission.replace_cmd(packet.seq,cmd)) {
@@ -764,11 +899,24 @@ void GCS_MAVLINK::handle_mission_item(mavlink_message_t *msg, AP_Mission &missio
         goto mission_ack;
     }
     
-    // update waypoint receiving state machine
+    // update waypoint receiving state machine, skipping items already
+    // received out of order
     waypoint_timelast_receive = hal.scheduler->millis();
-    waypoint_request_i++;
+    do {
+        waypoint_request_i++;
+        waypoint_received_mask >>= 1;
+    } while (waypoint_received_mask & 1);
     
     if (waypoint_request_i >= waypoint_request_last) {
+#if GCS_MISSION_STAGING
+        if (waypoint_staging != NULL) {
+            waypoint_receiving = false;
+            result = commit_staged_mission(mission);
+            if (result != MAV_MISSION_ACCEPTED) {
+                goto mission_ack;
+            }
+        }
+#endif
         mavlink_msg_mission_ack_send_buf(
             msg,
             chan,
@@ -784,7 +932,7 @@ void GCS_MAVLINK::handle_mission_item(mavlink_message_t *msg, AP_Mission &missio
         waypoint_timelast_request = hal.scheduler->millis();
         // if we have enough space, then send the next WP immediately
         if (comm_get_txspace(chan) >= 
-            MAVLINK_NUM_NON_PAYLOAD_BYTES+MAVLINK_MSG_ID_MISSION_ITEM_LEN) {
+            MAVLINK_NUM_NON_PAYLOAD_BYTES+MAVLINK_MSG_ID_MISSION_REQUEST_LEN) {
             queued_waypoint_send();
         } else {
             send_message(MSG_NEXT_WAYPOINT);
@@ -920,12 +1068,17 @@ GCS_MAVLINK::update(void (*run_cli)(AP_HAL::UARTDriver *))
         waypoint_request_i <= waypoint_request_last &&
         tnow - waypoint_timelast_request > wp_recv_time) {
         waypoint_timelast_request = tnow;
+        // request the whole window again
+        waypoint_request_next = waypoint_request_i;
         send_message(MSG_NEXT_WAYPOINT);
     }
 
     // stop waypoint receiving if timeout
     if (waypoint_receiving && (tnow - waypoint_timelast_receive) > wp_recv_time+waypoint_receive_timeout) {
         waypoint_receiving = false;
+#if GCS_MISSION_STAGING
+        free_staged_mission();
+#endif
     }
 }
 
@@ -1355,6 +1508,29 @@ void GCS_MAVLINK::send_local_position(const AP_AHRS &ahrs) const
         velocity.z);
 }
 
+/*
+  send the vibration levels of the primary accel and the clipping
+  counts of the first three accels
+ */
+void GCS_MAVLINK::send_vibration(const AP_InertialSensor &ins) const
+{
+    Vector3f vibration = ins.get_vibration_levels();
+    uint32_t clipping[3] = {};
+    for (uint8_t i=0; i<ins.get_accel_count() && i<3; i++) {
+        clipping[i] = ins.get_accel_clip_count(i);
+    }
+
+    mavlink_msg_vibration_send(
+        chan,
+        hal.scheduler->micros64(),
+        vibration.x,
+        vibration.y,
+        vibration.z,
+        clipping[0],
+        clipping[1],
+        clipping[2]);
+}
+
 void GCS_MAVLINK::send_home(const Location &home) const
 {
     if (comm_get_txspace(chan) >= MAVLINK_NUM_NON_PAYLOAD_BYTES + MAVLINK_MSG_ID_HOME_POSITION_LEN) {